@@ -11,6 +11,8 @@ HEADERS += $$PWD/include/QHexView/model/commands/hexcommand.h \
            $$PWD/include/QHexView/model/buffer/qmemorybuffer.h \
            $$PWD/include/QHexView/model/buffer/qmemoryrefbuffer.h \
            $$PWD/include/QHexView/model/buffer/qmappedfilebuffer.h \
+           $$PWD/include/QHexView/model/buffer/qpagedfilebuffer.h \
+           $$PWD/include/QHexView/model/buffer/qpiecetablebuffer.h \
            $$PWD/include/QHexView/model/qhexdelegate.h \
            $$PWD/include/QHexView/model/qhexutils.h \
            $$PWD/include/QHexView/model/qhexcursor.h \
@@ -18,6 +20,7 @@ HEADERS += $$PWD/include/QHexView/model/commands/hexcommand.h \
            $$PWD/include/QHexView/model/qhexoptions.h \
            $$PWD/include/QHexView/model/qhexdocument.h \
            $$PWD/include/QHexView/dialogs/hexfinddialog.h \
+           $$PWD/include/QHexView/qhexrenderer.h \
            $$PWD/include/QHexView/qhexview.h
 
 SOURCES += $$PWD/src/model/commands/hexcommand.cpp \
@@ -29,12 +32,15 @@ SOURCES += $$PWD/src/model/commands/hexcommand.cpp \
            $$PWD/src/model/buffer/qmemorybuffer.cpp \
            $$PWD/src/model/buffer/qmemoryrefbuffer.cpp \
            $$PWD/src/model/buffer/qmappedfilebuffer.cpp \
+           $$PWD/src/model/buffer/qpagedfilebuffer.cpp \
+           $$PWD/src/model/buffer/qpiecetablebuffer.cpp \
            $$PWD/src/model/qhexdelegate.cpp \
            $$PWD/src/model/qhexutils.cpp \
            $$PWD/src/model/qhexcursor.cpp \
            $$PWD/src/model/qhexmetadata.cpp \
            $$PWD/src/model/qhexdocument.cpp \
            $$PWD/src/dialogs/hexfinddialog.cpp \
+           $$PWD/src/qhexrenderer.cpp \
            $$PWD/src/qhexview.cpp
 
 INCLUDEPATH += $$PWD/include
@@ -0,0 +1,143 @@
+#include <QFontDatabase>
+#include <QHexView/model/buffer/qmemorybuffer.h>
+#include <QHexView/qhexview.h>
+#include <QImage>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QtTest>
+
+// Paints N rows per iteration, one scroll step apart, once through a fresh
+// QTextDocument with a formatted fragment per byte (the way QHexView painted
+// before QHexRenderer) and once through QHexView itself.
+class QHexViewBenchmark: public QObject {
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void textDocument_data();
+    void textDocument();
+    void renderer_data();
+    void renderer();
+
+private:
+    static void addRows();
+
+private:
+    QByteArray m_data;
+    QFont m_font;
+};
+
+void QHexViewBenchmark::initTestCase() {
+    m_data.resize(1 << 20);
+
+    for(int i = 0; i < m_data.size(); i++)
+        m_data[i] = static_cast<char>((i * 31) ^ (i >> 8));
+
+    m_font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+}
+
+void QHexViewBenchmark::addRows() {
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("linelength");
+
+    QTest::newRow("32 rows, 16 bytes") << 32 << 16;
+    QTest::newRow("32 rows, 32 bytes") << 32 << 32;
+    QTest::newRow("64 rows, 16 bytes") << 64 << 16;
+    QTest::newRow("64 rows, 32 bytes") << 64 << 32;
+}
+
+void QHexViewBenchmark::textDocument_data() { QHexViewBenchmark::addRows(); }
+
+void QHexViewBenchmark::textDocument() {
+    QFETCH(int, rows);
+    QFETCH(int, linelength);
+
+    const qint64 lines = m_data.size() / linelength;
+    qint64 line = 0;
+
+    QTextCharFormat addrformat, cf;
+    addrformat.setForeground(Qt::darkBlue);
+    cf.setForeground(Qt::black);
+
+    const QFontMetrics fm(m_font);
+    QImage image(fm.averageCharWidth() * (linelength * 4 + 16),
+                 fm.height() * (rows + 1), QImage::Format_ARGB32_Premultiplied);
+
+    QBENCHMARK {
+        QTextDocument doc;
+        doc.setDocumentMargin(0);
+        doc.setUndoRedoEnabled(false);
+        doc.setDefaultFont(m_font);
+
+        QTextCursor c(&doc);
+
+        for(int r = 0; r < rows; r++) {
+            const qint64 offset = ((line + r) % lines) * linelength;
+
+            c.insertText(" " +
+                             QString::number(offset, 16)
+                                 .rightJustified(8, '0')
+                                 .toUpper() +
+                             " ",
+                         addrformat);
+            c.insertText(" ", {});
+
+            for(int i = 0; i < linelength; i++) {
+                const quint8 b = static_cast<quint8>(m_data.at(offset + i));
+                c.insertText(
+                    QString::number(b, 16).rightJustified(2, '0').toUpper(),
+                    cf);
+                c.insertText(" ", cf);
+            }
+
+            c.insertText(" ", {});
+
+            for(int i = 0; i < linelength; i++) {
+                const quint8 b = static_cast<quint8>(m_data.at(offset + i));
+                c.insertText(b < 0x80 && QChar::isPrint(b) ? QString(QChar(b))
+                                                           : QString("."),
+                             cf);
+            }
+
+            c.insertBlock();
+        }
+
+        image.fill(Qt::white);
+        QPainter painter(&image);
+        doc.drawContents(&painter);
+        line++;
+    }
+}
+
+void QHexViewBenchmark::renderer_data() { QHexViewBenchmark::addRows(); }
+
+void QHexViewBenchmark::renderer() {
+    QFETCH(int, rows);
+    QFETCH(int, linelength);
+
+    QHexView view;
+    view.setFont(m_font);
+    view.setLineLength(linelength);
+    view.setDocument(QHexDocument::fromMemory<QMemoryBuffer>(m_data, &view));
+
+    // One header row plus the requested rows
+    const QFontMetrics fm(m_font);
+    view.resize(fm.averageCharWidth() * (linelength * 4 + 16),
+                fm.height() * (rows + 1) +
+                    view.horizontalScrollBar()->sizeHint().height());
+    view.show();
+
+    QImage image(view.viewport()->size(), QImage::Format_ARGB32_Premultiplied);
+    QScrollBar* vscrollbar = view.verticalScrollBar();
+
+    QBENCHMARK {
+        vscrollbar->setValue((vscrollbar->value() + 1) %
+                             (vscrollbar->maximum() + 1));
+        view.viewport()->render(&image);
+    }
+}
+
+QTEST_MAIN(QHexViewBenchmark)
+#include "main.moc"
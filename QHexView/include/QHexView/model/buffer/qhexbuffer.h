@@ -6,9 +6,16 @@
 class QHexBuffer: public QObject {
     Q_OBJECT
 
+public:
+    static constexpr int SEARCH_CHUNK = 1024 * 1024;
+
 public:
     explicit QHexBuffer(QObject* parent = nullptr);
     bool isEmpty() const;
+    qint64 find(const QByteArray& ba, qint64 from, Qt::CaseSensitivity cs);
+    qint64 find(const QByteArray& ba, const QByteArray& mask, qint64 from);
+    qint64 findLast(const QByteArray& ba, qint64 from, Qt::CaseSensitivity cs);
+    qint64 findLast(const QByteArray& ba, const QByteArray& mask, qint64 from);
 
 public:
     virtual uchar at(qint64 idx);
@@ -16,6 +23,11 @@ public:
     virtual void replace(qint64 offset, const QByteArray& data);
     virtual void read(char* data, int size);
     virtual void read(const QByteArray& ba);
+    // Let go of the backing file while it is replaced on disk, then pick it
+    // up again: the original contents when the replacement failed, the new
+    // file (holding the whole document) when it succeeded
+    virtual void release();
+    virtual bool restore(bool replaced);
 
 public:
     virtual qint64 length() const = 0;
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QHash>
+#include <QHexView/model/buffer/qhexbuffer.h>
+#include <list>
+
+// Reads the underlying device in fixed-size pages on demand and keeps at
+// most MAX_PAGES of them in an LRU cache, so opening is O(1) and memory stays
+// bounded regardless of file size. Overwritten pages are pinned in memory
+// until the buffer is written back; the length of the data never changes.
+class QPagedFileBuffer: public QHexBuffer {
+    Q_OBJECT
+
+public:
+    static constexpr qint64 PAGE_SIZE = 64 * 1024;
+    static constexpr int MAX_PAGES = 256;
+
+public:
+    explicit QPagedFileBuffer(QObject* parent = nullptr);
+    virtual ~QPagedFileBuffer();
+    uchar at(qint64 idx) override;
+    qint64 length() const override;
+    void insert(qint64 offset, const QByteArray& data) override;
+    void replace(qint64 offset, const QByteArray& data) override;
+    void remove(qint64 offset, int length) override;
+    QByteArray read(qint64 offset, int length) override;
+    bool read(QIODevice* device) override;
+    void write(QIODevice* device) override;
+    void release() override;
+    bool restore(bool replaced) override;
+    qint64 indexOf(const QByteArray& ba, qint64 from) override;
+    qint64 lastIndexOf(const QByteArray& ba, qint64 from) override;
+
+private:
+    struct CachedPage {
+        QByteArray data;
+        std::list<qint64>::iterator lru;
+    };
+
+    const QByteArray& page(qint64 index);
+
+private:
+    QIODevice* m_device{nullptr};
+    qint64 m_length{0};
+    QHash<qint64, CachedPage> m_cache;
+    QHash<qint64, QByteArray> m_dirty;
+    std::list<qint64> m_lru;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QHexView/model/buffer/qhexbuffer.h>
+#include <QVector>
+
+class QFile;
+class QPagedFileBuffer;
+
+// Piece table over an immutable original (a mapped file, a byte array or,
+// when mapping fails, a paged reader) and an append-only add buffer. The
+// pieces are kept in an implicit treap ordered by position, so insert,
+// remove and lookups are O(log n) in the number of pieces.
+class QPieceTableBuffer: public QHexBuffer {
+    Q_OBJECT
+
+public:
+    explicit QPieceTableBuffer(QObject* parent = nullptr);
+    virtual ~QPieceTableBuffer();
+    uchar at(qint64 idx) override;
+    qint64 length() const override;
+    void insert(qint64 offset, const QByteArray& data) override;
+    void remove(qint64 offset, int length) override;
+    QByteArray read(qint64 offset, int length) override;
+    bool read(QIODevice* device) override;
+    void write(QIODevice* device) override;
+    void release() override;
+    bool restore(bool replaced) override;
+    qint64 indexOf(const QByteArray& ba, qint64 from) override;
+    qint64 lastIndexOf(const QByteArray& ba, qint64 from) override;
+
+private:
+    struct Piece {
+        int block; // -1 for the original, otherwise an add block
+        qint64 start;
+        qint64 length;
+    };
+
+    struct Node {
+        Piece piece;
+        qint64 total;
+        quint32 priority;
+        Node* left;
+        Node* right;
+    };
+
+private:
+    Node* createNode(const Piece& piece);
+    void collect(Node* n, qint64 base, qint64 from, qint64 to,
+                 QVector<Piece>& pieces) const;
+    void destroy(Node* n);
+    Node* merge(Node* a, Node* b);
+    const char* pointer(const Piece& piece) const;
+    void split(Node* n, qint64 offset, Node*& l, Node*& r);
+    static qint64 total(const Node* n);
+    static void update(Node* n);
+
+private:
+    QVector<QByteArray> m_blocks;
+    QFile* m_file{nullptr};
+    const char* m_original{nullptr};
+    QByteArray m_originaldata;
+    QPagedFileBuffer* m_pages{nullptr};
+    Node* m_root{nullptr};
+    quint32 m_seed{0x9E3779B9};
+};
@@ -29,11 +29,17 @@ public:
     qint64 length() const;
     qint64 indexOf(const QByteArray& ba, qint64 from = 0);
     qint64 lastIndexOf(const QByteArray& ba, qint64 from = 0);
+    qint64 find(const QByteArray& ba, qint64 from,
+                Qt::CaseSensitivity cs = Qt::CaseSensitive,
+                FindDirection fd = FindDirection::Forward);
+    qint64 find(const QByteArray& ba, const QByteArray& mask, qint64 from,
+                FindDirection fd = FindDirection::Forward);
     QByteArray read(qint64 offset, int len = 0) const;
     uchar at(int offset) const;
 
 public Q_SLOTS:
     void clearModified();
+    void markModified();
     void undo();
     void redo();
     void insert(qint64 offset, uchar b);
@@ -42,6 +48,8 @@ public Q_SLOTS:
     void replace(qint64 offset, const QByteArray& data);
     void remove(qint64 offset, int len);
     bool saveTo(QIODevice* device);
+    void release();
+    bool restore(bool replaced);
 
 public:
     template<typename T, bool Owned = true>
@@ -59,6 +67,10 @@ public:
                                        QObject* parent = nullptr);
     static QHexDocument* fromMappedFile(QString filename,
                                         QObject* parent = nullptr);
+    static QHexDocument* fromPagedFile(QString filename,
+                                       QObject* parent = nullptr);
+    static QHexDocument* fromPieceTableFile(QString filename,
+                                            QObject* parent = nullptr);
     static QHexDocument* fromFile(QString filename, QObject* parent = nullptr);
     static QHexDocument* create(QObject* parent = nullptr);
 
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QCache>
+#include <QColor>
+#include <QFont>
+#include <QFontMetricsF>
+#include <QPixmap>
+#include <QStaticText>
+#include <QTextCharFormat>
+#include <QVector>
+
+class QPainter;
+class QPalette;
+
+// Paints QHexView rows directly with QPainter. The hex pair and the ascii
+// character of every byte value are laid out once as QStaticText, and each
+// row is described as a run of glyphs with a resolved style: the run itself
+// is the key of a pixmap cache, so a scroll step only renders the rows that
+// came into view and a cursor move only the rows whose cells changed.
+class QHexRenderer {
+public:
+    static constexpr int MAX_CACHED_LINES = 512;
+
+    enum Glyph : quint32 {
+        HexGlyph = 0,
+        AsciiGlyph = 256,
+        InvalidGlyph = 512,
+        InvalidPairGlyph,
+        BlankPairGlyph,
+        GlyphCount,
+        NoGlyph = GlyphCount,
+    };
+
+    struct Style {
+        enum : quint32 {
+            Background = (1 << 0),
+            Underline = (1 << 1),
+            Bold = (1 << 2),
+            Italic = (1 << 3),
+        };
+
+        QRgb foreground;
+        QRgb background;
+        QRgb underline;
+        quint32 flags;
+
+        void setForeground(const QColor& c);
+        void setBackground(const QColor& c);
+        void setUnderline(const QColor& c);
+        void clearBackground() { flags &= ~Background; }
+        void clearUnderline() { flags &= ~Underline; }
+    };
+
+public:
+    QHexRenderer();
+    Style defaultStyle() const;
+    Style style(const QTextCharFormat& cf) const;
+    void setup(const QFont& font, const QPalette& palette,
+               QChar unprintablechar, QChar invalidchar, qreal dpr);
+    void beginLine(const QColor& background);
+    void append(quint32 glyph, const Style& style);
+    void appendText(const QString& s, const Style& style);
+    void drawLine(QPainter* painter, QPointF pos);
+    qreal drawText(QPainter* painter, QPointF pos, const QString& s,
+                   const QTextCharFormat& cf) const;
+    void clear();
+
+private:
+    struct Cell {
+        quint32 glyph;
+        Style style;
+    };
+
+    QPixmap render() const;
+    void drawCell(QPainter* painter, const QRectF& r, const QString& s,
+                  const QStaticText* glyph, const Style& style) const;
+    qreal cellWidth() const;
+    static int cells(quint32 glyph);
+
+private:
+    QFont m_font;
+    QFontMetricsF m_fontmetrics;
+    QRgb m_base{0}, m_foreground{0};
+    QChar m_unprintablechar, m_invalidchar;
+    qreal m_dpr{0};
+    QVector<QStaticText> m_glyphs;
+    QVector<Cell> m_line; // The first cell carries the row background
+    QCache<QByteArray, QPixmap> m_cache;
+};
@@ -7,6 +7,7 @@
 #include <QHexView/model/qhexcursor.h>
 #include <QHexView/model/qhexdelegate.h>
 #include <QHexView/model/qhexdocument.h>
+#include <QHexView/qhexrenderer.h>
 #include <QList>
 #include <QRectF>
 #include <QTextCharFormat>
@@ -116,11 +117,11 @@ private:
     void calcColumns();
     void ensureVisible();
     void drawSeparators(QPainter* p) const;
-    void drawHeader(QTextCursor& c) const;
-    void drawDocument(QTextCursor& c) const;
-    QTextCharFormat drawFormat(QTextCursor& c, quint8 b, const QString& s,
-                               QHexArea area, qint64 line, qint64 column,
-                               bool applyformat) const;
+    void drawHeader(QPainter* p) const;
+    void drawDocument(QPainter* p) const;
+    QHexRenderer::Style drawFormat(quint32 glyph, quint8 b, QHexArea area,
+                                   qint64 line, qint64 column,
+                                   bool applyformat) const;
     unsigned int calcAddressWidth() const;
     int visibleLines(bool absolute = false) const;
     qint64 getLastColumn(qint64 line) const;
@@ -170,6 +171,7 @@ private:
     QHexArea m_currentarea{QHexArea::Ascii};
     QList<QRectF> m_hexcolumns;
     QFontMetricsF m_fontmetrics;
+    mutable QHexRenderer m_hexrenderer;
     QHexOptions m_options;
     QHexCursor* m_hexcursor{nullptr};
     QHexDocument* m_hexdocument{nullptr};
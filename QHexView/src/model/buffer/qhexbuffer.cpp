@@ -1,10 +1,306 @@
 #include <QBuffer>
 #include <QHexView/model/buffer/qhexbuffer.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(_WIN32) && _MSC_VER <= 1916 // v141_xp
+#include <ctype.h>
+namespace std {
+using ::tolower;
+}
+#else
+#include <cctype>
+#endif
+
+namespace {
+
+// Boyer-Moore-Horspool over raw chunks, case folding goes through a byte
+// table so the insensitive path costs one lookup per inspected byte
+class Horspool {
+public:
+    Horspool(const QByteArray& pattern, Qt::CaseSensitivity cs)
+        : m_length(pattern.size()), m_casesensitive(cs == Qt::CaseSensitive) {
+        for(int c = 0; c < 256; c++)
+            m_fold[c] = static_cast<uchar>(m_casesensitive ? c
+                                                           : std::tolower(c));
+
+        m_pattern.resize(m_length);
+        for(int i = 0; i < m_length; i++)
+            m_pattern[i] = static_cast<char>(
+                m_fold[static_cast<uchar>(pattern.at(i))]);
+
+        std::fill(m_skip, m_skip + 256, m_length);
+        std::fill(m_rskip, m_rskip + 256, m_length);
+
+        for(int i = 0; i < m_length - 1; i++)
+            m_skip[this->patternAt(i)] = m_length - 1 - i;
+        for(int i = m_length - 1; i > 0; i--)
+            m_rskip[this->patternAt(i)] = i;
+    }
+
+    qint64 indexIn(const uchar* data, qint64 size) const {
+        if(m_casesensitive && m_length == 1) {
+            const void* p = std::memchr(data, this->patternAt(0), size);
+            return p ? static_cast<const uchar*>(p) - data : -1;
+        }
+
+        const int last = m_length - 1;
+
+        for(qint64 pos = 0; pos + m_length <= size;) {
+            uchar c = m_fold[data[pos + last]];
+            if(c == this->patternAt(last) && this->matches(data + pos))
+                return pos;
+            pos += m_skip[c];
+        }
+
+        return -1;
+    }
+
+    qint64 lastIndexIn(const uchar* data, qint64 size, qint64 from) const {
+        for(qint64 pos = std::min<qint64>(from, size - m_length); pos >= 0;) {
+            uchar c = m_fold[data[pos]];
+            if(c == this->patternAt(0) && this->matches(data + pos))
+                return pos;
+            pos -= m_rskip[c];
+        }
+
+        return -1;
+    }
+
+    int length() const { return m_length; }
+
+private:
+    uchar patternAt(int i) const {
+        return static_cast<uchar>(m_pattern.at(i));
+    }
+
+    bool matches(const uchar* p) const {
+        if(m_casesensitive)
+            return !std::memcmp(p, m_pattern.constData(), m_length);
+
+        for(int i = 0; i < m_length; i++) {
+            if(m_fold[p[i]] != this->patternAt(i))
+                return false;
+        }
+
+        return true;
+    }
+
+private:
+    int m_length;
+    bool m_casesensitive;
+    QByteArray m_pattern;
+    uchar m_fold[256];
+    int m_skip[256], m_rskip[256];
+};
+
+// Matches a pattern where each byte only has to agree on its mask bits, a
+// zero mask being a wildcard. Candidates are located by running memchr for
+// the fixed byte least likely to occur in binary data, the other bytes are
+// only compared at those offsets
+class MaskedMatcher {
+public:
+    MaskedMatcher(const QByteArray& pattern, const QByteArray& mask)
+        : m_pattern(pattern), m_mask(mask) {
+        int best = std::numeric_limits<int>::max();
+
+        for(int i = 0; i < this->length(); i++) {
+            m_pattern[i] = static_cast<char>(m_pattern.at(i) & m_mask.at(i));
+
+            if(static_cast<uchar>(m_mask.at(i)) != 0xFF)
+                continue;
+
+            int score =
+                MaskedMatcher::commonness(static_cast<uchar>(m_pattern.at(i)));
+
+            if(score < best) {
+                best = score;
+                m_anchor = i;
+            }
+        }
+    }
+
+    int length() const { return m_pattern.size(); }
+
+    qint64 indexIn(const uchar* data, qint64 size) const {
+        const qint64 last = size - this->length();
+        if(last < 0)
+            return -1;
+        if(m_anchor == -1)
+            return 0;
+
+        const uchar anchor = static_cast<uchar>(m_pattern.at(m_anchor));
+
+        for(qint64 pos = 0; pos <= last;) {
+            const void* p =
+                std::memchr(data + pos + m_anchor, anchor, last - pos + 1);
+            if(!p)
+                break;
+
+            qint64 candidate = static_cast<const uchar*>(p) - data - m_anchor;
+            if(this->matches(data + candidate))
+                return candidate;
+
+            pos = candidate + 1;
+        }
+
+        return -1;
+    }
+
+    qint64 lastIndexIn(const uchar* data, qint64 size, qint64 from) const {
+        const qint64 last = std::min<qint64>(from, size - this->length());
+        if(last < 0)
+            return -1;
+        if(m_anchor == -1)
+            return last;
+
+        // There is no portable memrchr: walk windows from the end, collect
+        // the anchor hits of each one with memchr and verify them backwards
+        const uchar anchor = static_cast<uchar>(m_pattern.at(m_anchor));
+        const uchar* base = data + m_anchor;
+        std::vector<qint64> hits;
+
+        for(qint64 end = last; end >= 0;) {
+            const qint64 begin = std::max<qint64>(0, end - ANCHOR_WINDOW + 1);
+            hits.clear();
+
+            for(qint64 pos = begin; pos <= end;) {
+                const void* p = std::memchr(base + pos, anchor, end - pos + 1);
+                if(!p)
+                    break;
+
+                pos = static_cast<const uchar*>(p) - base;
+                hits.push_back(pos++);
+            }
+
+            for(auto it = hits.rbegin(); it != hits.rend(); ++it) {
+                if(this->matches(data + *it))
+                    return *it;
+            }
+
+            end = begin - 1;
+        }
+
+        return -1;
+    }
+
+private:
+    bool matches(const uchar* p) const {
+        for(int i = 0; i < this->length(); i++) {
+            if((p[i] & static_cast<uchar>(m_mask.at(i))) !=
+               static_cast<uchar>(m_pattern.at(i)))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Rough byte frequency in executables and resources: padding and
+    // sign-extension bytes first, then text, control codes last
+    static int commonness(uchar b) {
+        if(b == 0x00)
+            return 4;
+        if(b == 0xFF)
+            return 3;
+        if(b >= 0x20 && b < 0x7F)
+            return 2;
+        if(b < 0x20)
+            return 1;
+        return 0;
+    }
+
+private:
+    static constexpr qint64 ANCHOR_WINDOW = 4096;
+
+    QByteArray m_pattern, m_mask;
+    int m_anchor{-1};
+};
+
+template<typename Matcher>
+qint64 findForward(QHexBuffer* buffer, const Matcher& matcher, qint64 from) {
+    const qint64 len = buffer->length();
+    if(from < 0 || matcher.length() > len)
+        return -1;
+
+    // Each chunk holds SEARCH_CHUNK candidate offsets plus the pattern tail,
+    // so a match straddling two chunks is found in the first one
+    const int overlap = matcher.length() - 1;
+
+    for(qint64 pos = from; pos <= len - matcher.length();
+        pos += QHexBuffer::SEARCH_CHUNK) {
+        const QByteArray data =
+            buffer->read(pos, QHexBuffer::SEARCH_CHUNK + overlap);
+        const qint64 idx = matcher.indexIn(
+            reinterpret_cast<const uchar*>(data.constData()), data.size());
+
+        if(idx >= 0)
+            return pos + idx;
+    }
+
+    return -1;
+}
+
+template<typename Matcher>
+qint64 findBackward(QHexBuffer* buffer, const Matcher& matcher, qint64 from) {
+    const qint64 len = buffer->length();
+    if(from < 0 || matcher.length() > len)
+        return -1;
+
+    for(qint64 start = std::min<qint64>(from, len - matcher.length());
+        start >= 0;) {
+        const qint64 begin =
+            std::max<qint64>(0, start - QHexBuffer::SEARCH_CHUNK + 1);
+        const QByteArray data = buffer->read(
+            begin, static_cast<int>(start - begin) + matcher.length());
+        const qint64 idx = matcher.lastIndexIn(
+            reinterpret_cast<const uchar*>(data.constData()), data.size(),
+            start - begin);
+
+        if(idx >= 0)
+            return begin + idx;
+
+        start = begin - 1;
+    }
+
+    return -1;
+}
+
+} // namespace
 
 QHexBuffer::QHexBuffer(QObject* parent): QObject{parent} {}
 uchar QHexBuffer::at(qint64 idx) { return this->read(idx, 1).at(0); }
 bool QHexBuffer::isEmpty() const { return this->length() <= 0; }
 
+qint64 QHexBuffer::find(const QByteArray& ba, qint64 from,
+                        Qt::CaseSensitivity cs) {
+    if(ba.isEmpty())
+        return -1;
+    return findForward(this, Horspool(ba, cs), from);
+}
+
+qint64 QHexBuffer::find(const QByteArray& ba, const QByteArray& mask,
+                        qint64 from) {
+    if(ba.isEmpty() || ba.size() != mask.size())
+        return -1;
+    return findForward(this, MaskedMatcher(ba, mask), from);
+}
+
+qint64 QHexBuffer::findLast(const QByteArray& ba, qint64 from,
+                            Qt::CaseSensitivity cs) {
+    if(ba.isEmpty())
+        return -1;
+    return findBackward(this, Horspool(ba, cs), from);
+}
+
+qint64 QHexBuffer::findLast(const QByteArray& ba, const QByteArray& mask,
+                            qint64 from) {
+    if(ba.isEmpty() || ba.size() != mask.size())
+        return -1;
+    return findBackward(this, MaskedMatcher(ba, mask), from);
+}
+
 void QHexBuffer::replace(qint64 offset, const QByteArray& data) {
     this->remove(offset, data.length());
     this->insert(offset, data);
@@ -15,6 +311,13 @@ bool QHexBuffer::accept(qint64 idx) const {
     return true;
 }
 
+void QHexBuffer::release() {}
+
+bool QHexBuffer::restore(bool replaced) {
+    Q_UNUSED(replaced);
+    return true;
+}
+
 void QHexBuffer::read(char* data, int size) {
     QBuffer* buffer = new QBuffer(this);
     buffer->setData(data, size);
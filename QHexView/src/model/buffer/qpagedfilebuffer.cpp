@@ -0,0 +1,207 @@
+#include <QHexView/model/buffer/qpagedfilebuffer.h>
+#include <QIODevice>
+#include <algorithm>
+
+QPagedFileBuffer::QPagedFileBuffer(QObject* parent): QHexBuffer{parent} {}
+
+QPagedFileBuffer::~QPagedFileBuffer() {
+    if(m_device && (m_device->parent() == this) && m_device->isOpen())
+        m_device->close();
+
+    m_device = nullptr;
+}
+
+uchar QPagedFileBuffer::at(qint64 idx) {
+    if(idx < 0 || idx >= m_length)
+        return 0;
+
+    const QByteArray& p = this->page(idx / PAGE_SIZE);
+    const qint64 pos = idx % PAGE_SIZE;
+    return pos < p.size() ? static_cast<uchar>(p.at(pos)) : 0;
+}
+
+qint64 QPagedFileBuffer::length() const { return m_length; }
+
+void QPagedFileBuffer::insert(qint64 offset, const QByteArray& data) {
+    Q_UNUSED(offset)
+    Q_UNUSED(data)
+    // Not supported: the data is addressed by page
+}
+
+void QPagedFileBuffer::replace(qint64 offset, const QByteArray& data) {
+    qint64 pos = offset;
+    qint64 done = 0;
+    const qint64 end = std::min<qint64>(offset + data.size(), m_length);
+
+    while(pos < end) {
+        const qint64 index = pos / PAGE_SIZE;
+        const qint64 start = pos % PAGE_SIZE;
+        const qint64 count = std::min<qint64>(PAGE_SIZE - start, end - pos);
+
+        auto it = m_dirty.find(index);
+        if(it == m_dirty.end()) {
+            // Move the page out of the cache so it can never be evicted
+            it = m_dirty.insert(index, this->page(index));
+            auto cached = m_cache.find(index);
+            if(cached != m_cache.end()) {
+                m_lru.erase(cached->lru);
+                m_cache.erase(cached);
+            }
+        }
+
+        it->replace(start, count, data.constData() + done, count);
+        pos += count;
+        done += count;
+    }
+}
+
+void QPagedFileBuffer::remove(qint64 offset, int length) {
+    Q_UNUSED(offset)
+    Q_UNUSED(length)
+    // Not supported: the data is addressed by page
+}
+
+QByteArray QPagedFileBuffer::read(qint64 offset, int length) {
+    if(offset < 0 || offset >= m_length || length <= 0)
+        return {};
+
+    length = static_cast<int>(std::min<qint64>(length, m_length - offset));
+
+    QByteArray res;
+    res.reserve(length);
+
+    qint64 pos = offset;
+    const qint64 end = offset + length;
+
+    while(pos < end) {
+        const QByteArray& p = this->page(pos / PAGE_SIZE);
+        const qint64 start = pos % PAGE_SIZE;
+        const qint64 count = std::min<qint64>(PAGE_SIZE - start, end - pos);
+
+        if(start >= p.size())
+            break;
+
+        res.append(p.constData() + start,
+                   std::min<qint64>(count, p.size() - start));
+        pos += count;
+    }
+
+    return res;
+}
+
+bool QPagedFileBuffer::read(QIODevice* device) {
+    m_device = device;
+    if(!m_device)
+        return false;
+
+    if(!m_device->isOpen())
+        m_device->open(QIODevice::ReadOnly);
+    if(!m_device->isOpen() || m_device->isSequential())
+        return false;
+
+    m_length = m_device->size();
+    m_cache.clear();
+    m_dirty.clear();
+    m_lru.clear();
+    return true;
+}
+
+void QPagedFileBuffer::write(QIODevice* device) {
+    if(device == m_device)
+        return;
+
+    const qint64 pages = (m_length + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    for(qint64 i = 0; i < pages; i++)
+        device->write(this->page(i));
+}
+
+qint64 QPagedFileBuffer::indexOf(const QByteArray& ba, qint64 from) {
+    if(ba.isEmpty() || from < 0)
+        return -1;
+
+    // Search page-sized windows that overlap by the pattern length
+    const qint64 overlap = ba.size() - 1;
+
+    for(qint64 pos = from; pos < m_length; pos += PAGE_SIZE) {
+        const QByteArray data =
+            this->read(pos, static_cast<int>(PAGE_SIZE + overlap));
+        const qint64 idx = data.indexOf(ba);
+
+        if(idx >= 0)
+            return pos + idx;
+    }
+
+    return -1;
+}
+
+qint64 QPagedFileBuffer::lastIndexOf(const QByteArray& ba, qint64 from) {
+    if(ba.isEmpty() || from < 0)
+        return -1;
+
+    const qint64 overlap = ba.size() - 1;
+    qint64 end = std::min<qint64>(from + ba.size(), m_length);
+
+    while(end > 0) {
+        const qint64 start = std::max<qint64>(0, end - PAGE_SIZE - overlap);
+        const QByteArray data =
+            this->read(start, static_cast<int>(end - start));
+        const qint64 idx = data.lastIndexOf(ba);
+
+        if(idx >= 0)
+            return start + idx;
+        if(start == 0)
+            break;
+
+        end = start + overlap;
+    }
+
+    return -1;
+}
+
+void QPagedFileBuffer::release() {
+    if(m_device)
+        m_device->close();
+}
+
+bool QPagedFileBuffer::restore(bool replaced) {
+    if(!m_device)
+        return false;
+
+    if(!m_device->isOpen() && !m_device->open(QIODevice::ReadOnly))
+        return false;
+
+    // Cached pages may come from the old file, read them again on demand
+    m_cache.clear();
+    m_lru.clear();
+
+    if(replaced) {
+        // The overwritten pages are part of the new file now
+        m_dirty.clear();
+        m_length = m_device->size();
+    }
+
+    return true;
+}
+
+const QByteArray& QPagedFileBuffer::page(qint64 index) {
+    auto dirty = m_dirty.constFind(index);
+    if(dirty != m_dirty.constEnd())
+        return *dirty;
+
+    auto it = m_cache.find(index);
+    if(it != m_cache.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->lru);
+        return it->data;
+    }
+
+    while(m_cache.size() >= MAX_PAGES) {
+        m_cache.remove(m_lru.back());
+        m_lru.pop_back();
+    }
+
+    m_device->seek(index * PAGE_SIZE);
+    m_lru.push_front(index);
+    it = m_cache.insert(index, {m_device->read(PAGE_SIZE), m_lru.begin()});
+    return it->data;
+}
@@ -0,0 +1,354 @@
+#include <QBuffer>
+#include <QFile>
+#include <QHexView/model/buffer/qpagedfilebuffer.h>
+#include <QHexView/model/buffer/qpiecetablebuffer.h>
+#include <algorithm>
+
+static const qint64 ADD_BLOCK_SIZE = 64 * 1024;
+static const qint64 SEARCH_WINDOW = 1024 * 1024;
+static const qint64 WRITE_CHUNK = 1024 * 1024;
+
+QPieceTableBuffer::QPieceTableBuffer(QObject* parent): QHexBuffer{parent} {}
+QPieceTableBuffer::~QPieceTableBuffer() { this->destroy(m_root); }
+
+uchar QPieceTableBuffer::at(qint64 idx) {
+    Node* n = m_root;
+
+    while(n) {
+        const qint64 l = total(n->left);
+
+        if(idx < l)
+            n = n->left;
+        else if(idx < l + n->piece.length) {
+            const qint64 pos = n->piece.start + idx - l;
+            const char* p = this->pointer(n->piece);
+            return p ? static_cast<uchar>(p[idx - l]) : m_pages->at(pos);
+        }
+        else {
+            idx -= l + n->piece.length;
+            n = n->right;
+        }
+    }
+
+    return 0;
+}
+
+qint64 QPieceTableBuffer::length() const { return total(m_root); }
+
+void QPieceTableBuffer::insert(qint64 offset, const QByteArray& data) {
+    if(data.isEmpty())
+        return;
+
+    offset = std::max<qint64>(0, std::min(offset, this->length()));
+
+    // Blocks are reserved up front and never grow past their capacity, so
+    // pointers into them stay valid and reads can share their storage
+    if(m_blocks.isEmpty() ||
+       m_blocks.last().capacity() - m_blocks.last().size() < data.size()) {
+        QByteArray block;
+        block.reserve(std::max<qint64>(ADD_BLOCK_SIZE, data.size()));
+        m_blocks.append(block);
+    }
+
+    QByteArray& block = m_blocks.last();
+    const Piece piece{static_cast<int>(m_blocks.size() - 1), block.size(),
+                      data.size()};
+    block.append(data);
+
+    Node *l, *r;
+    this->split(m_root, offset, l, r);
+    m_root = this->merge(this->merge(l, this->createNode(piece)), r);
+}
+
+void QPieceTableBuffer::remove(qint64 offset, int length) {
+    if(length <= 0 || offset < 0 || offset >= this->length())
+        return;
+
+    Node *l, *m, *r;
+    this->split(m_root, offset, l, r);
+    this->split(r, length, m, r);
+    this->destroy(m);
+    m_root = this->merge(l, r);
+}
+
+QByteArray QPieceTableBuffer::read(qint64 offset, int length) {
+    if(offset < 0 || length <= 0 || offset >= this->length())
+        return {};
+
+    const qint64 end = std::min<qint64>(offset + length, this->length());
+    QVector<Piece> pieces;
+    this->collect(m_root, 0, offset, end, pieces);
+
+    if(pieces.size() == 1) {
+        // Share the storage of the original or add block without copying
+        const char* p = this->pointer(pieces.first());
+        if(p)
+            return QByteArray::fromRawData(
+                p, static_cast<int>(pieces.first().length));
+    }
+
+    QByteArray res;
+    res.reserve(static_cast<int>(end - offset));
+
+    for(const Piece& piece : pieces) {
+        const char* p = this->pointer(piece);
+        if(p)
+            res.append(p, static_cast<int>(piece.length));
+        else
+            res.append(
+                m_pages->read(piece.start, static_cast<int>(piece.length)));
+    }
+
+    return res;
+}
+
+bool QPieceTableBuffer::read(QIODevice* device) {
+    this->release();
+    this->destroy(m_root);
+    m_root = nullptr;
+    m_blocks.clear();
+    m_file = nullptr;
+    m_original = nullptr;
+    m_originaldata.clear();
+
+    if(m_pages) {
+        m_pages->deleteLater();
+        m_pages = nullptr;
+    }
+
+    if(!device)
+        return false;
+
+    QBuffer* buffer = qobject_cast<QBuffer*>(device);
+    QFile* file = qobject_cast<QFile*>(device);
+    qint64 size = 0;
+
+    if(buffer) {
+        m_originaldata = buffer->data();
+        m_original = m_originaldata.constData();
+        size = m_originaldata.size();
+    }
+    else {
+        if(!device->isOpen())
+            device->open(QIODevice::ReadOnly);
+        if(!device->isOpen())
+            return false;
+
+        size = device->size();
+        uchar* mapped = file ? file->map(0, size) : nullptr;
+
+        if(file && !device->isSequential())
+            m_file = file;
+
+        if(mapped)
+            m_original = reinterpret_cast<const char*>(mapped);
+        else if(!device->isSequential()) {
+            // Files that cannot be mapped are read page by page
+            m_pages = new QPagedFileBuffer(this);
+            if(!m_pages->read(device))
+                return false;
+        }
+        else {
+            m_originaldata = device->readAll();
+            m_original = m_originaldata.constData();
+            size = m_originaldata.size();
+        }
+    }
+
+    if(size > 0)
+        m_root = this->createNode({-1, 0, size});
+    return true;
+}
+
+void QPieceTableBuffer::write(QIODevice* device) {
+    // Stream the pieces in order, never materializing the whole document
+    QVector<Piece> pieces;
+    this->collect(m_root, 0, 0, this->length(), pieces);
+
+    for(const Piece& piece : pieces) {
+        const char* p = this->pointer(piece);
+
+        for(qint64 pos = 0; pos < piece.length; pos += WRITE_CHUNK) {
+            const qint64 count = std::min(WRITE_CHUNK, piece.length - pos);
+            if(p)
+                device->write(p + pos, count);
+            else
+                device->write(m_pages->read(piece.start + pos,
+                                            static_cast<int>(count)));
+        }
+    }
+}
+
+void QPieceTableBuffer::release() {
+    if(!m_file)
+        return;
+
+    if(m_pages)
+        m_pages->release();
+    else if(m_original) {
+        m_file->unmap(reinterpret_cast<uchar*>(const_cast<char*>(m_original)));
+        m_original = nullptr;
+    }
+
+    m_file->close();
+}
+
+bool QPieceTableBuffer::restore(bool replaced) {
+    if(!m_file)
+        return true;
+
+    // The new file holds the whole document: start over with it as the
+    // original and drop the pieces pointing at the old one
+    if(replaced)
+        return this->read(m_file);
+
+    if(m_pages)
+        return m_pages->restore(false);
+
+    if(!m_file->isOpen() && !m_file->open(QIODevice::ReadOnly))
+        return false;
+
+    // Same contents as before, the pieces stay valid once it is mapped again
+    m_original =
+        reinterpret_cast<const char*>(m_file->map(0, m_file->size()));
+    return m_original;
+}
+
+qint64 QPieceTableBuffer::indexOf(const QByteArray& ba, qint64 from) {
+    if(ba.isEmpty() || from < 0)
+        return -1;
+
+    const qint64 overlap = ba.size() - 1;
+    const qint64 len = this->length();
+
+    for(qint64 pos = from; pos < len; pos += SEARCH_WINDOW) {
+        const QByteArray data =
+            this->read(pos, static_cast<int>(SEARCH_WINDOW + overlap));
+        const qint64 idx = data.indexOf(ba);
+
+        if(idx >= 0)
+            return pos + idx;
+    }
+
+    return -1;
+}
+
+qint64 QPieceTableBuffer::lastIndexOf(const QByteArray& ba, qint64 from) {
+    if(ba.isEmpty() || from < 0)
+        return -1;
+
+    const qint64 overlap = ba.size() - 1;
+    qint64 end = std::min<qint64>(from + ba.size(), this->length());
+
+    while(end > 0) {
+        const qint64 start = std::max<qint64>(0, end - SEARCH_WINDOW - overlap);
+        const QByteArray data =
+            this->read(start, static_cast<int>(end - start));
+        const qint64 idx = data.lastIndexOf(ba);
+
+        if(idx >= 0)
+            return start + idx;
+        if(start == 0)
+            break;
+
+        end = start + overlap;
+    }
+
+    return -1;
+}
+
+QPieceTableBuffer::Node* QPieceTableBuffer::createNode(const Piece& piece) {
+    // xorshift32 priorities keep the treap balanced in expectation
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return new Node{piece, piece.length, m_seed, nullptr, nullptr};
+}
+
+void QPieceTableBuffer::collect(Node* n, qint64 base, qint64 from, qint64 to,
+                                QVector<Piece>& pieces) const {
+    if(!n || from >= to || base >= to || base + n->total <= from)
+        return;
+
+    const qint64 start = base + total(n->left);
+    const qint64 end = start + n->piece.length;
+    this->collect(n->left, base, from, to, pieces);
+
+    if(start < to && end > from) {
+        const qint64 first = std::max(start, from);
+        const qint64 last = std::min(end, to);
+        pieces.append({n->piece.block, n->piece.start + first - start,
+                       last - first});
+    }
+
+    this->collect(n->right, end, from, to, pieces);
+}
+
+void QPieceTableBuffer::destroy(Node* n) {
+    if(!n)
+        return;
+
+    this->destroy(n->left);
+    this->destroy(n->right);
+    delete n;
+}
+
+QPieceTableBuffer::Node* QPieceTableBuffer::merge(Node* a, Node* b) {
+    if(!a)
+        return b;
+    if(!b)
+        return a;
+
+    if(a->priority > b->priority) {
+        a->right = this->merge(a->right, b);
+        update(a);
+        return a;
+    }
+
+    b->left = this->merge(a, b->left);
+    update(b);
+    return b;
+}
+
+const char* QPieceTableBuffer::pointer(const Piece& piece) const {
+    if(piece.block >= 0)
+        return m_blocks.at(piece.block).constData() + piece.start;
+    return m_original ? m_original + piece.start : nullptr;
+}
+
+void QPieceTableBuffer::split(Node* n, qint64 offset, Node*& l, Node*& r) {
+    if(!n) {
+        l = r = nullptr;
+        return;
+    }
+
+    const qint64 left = total(n->left);
+
+    if(offset <= left) {
+        this->split(n->left, offset, l, n->left);
+        update(n);
+        r = n;
+    }
+    else if(offset >= left + n->piece.length) {
+        this->split(n->right, offset - left - n->piece.length, n->right, r);
+        update(n);
+        l = n;
+    }
+    else {
+        // The offset falls inside this piece: cut it in two
+        const qint64 cut = offset - left;
+        Node* tail = this->createNode({n->piece.block, n->piece.start + cut,
+                                       n->piece.length - cut});
+        r = this->merge(tail, n->right);
+        n->piece.length = cut;
+        n->right = nullptr;
+        update(n);
+        l = n;
+    }
+}
+
+qint64 QPieceTableBuffer::total(const Node* n) { return n ? n->total : 0; }
+
+void QPieceTableBuffer::update(Node* n) {
+    n->total = total(n->left) + n->piece.length + total(n->right);
+}
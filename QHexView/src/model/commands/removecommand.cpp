@@ -15,6 +15,8 @@ void RemoveCommand::undo() {
 }
 
 void RemoveCommand::redo() {
-    m_data = m_buffer->read(m_offset, m_length); // Backup data
+    // Backup data, detached from buffers that share their storage
+    const QByteArray data = m_buffer->read(m_offset, m_length);
+    m_data = QByteArray(data.constData(), data.size());
     m_buffer->remove(m_offset, m_length);
 }
@@ -16,6 +16,9 @@ void ReplaceCommand::undo() {
 }
 
 void ReplaceCommand::redo() {
-    m_olddata = m_buffer->read(m_offset, m_data.length());
+    // Detached from buffers that share their storage, the original file may
+    // be unmapped while the command is still on the undo stack
+    const QByteArray olddata = m_buffer->read(m_offset, m_data.length());
+    m_olddata = QByteArray(olddata.constData(), olddata.size());
     m_buffer->replace(m_offset, m_data);
 }
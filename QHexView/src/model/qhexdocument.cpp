@@ -3,6 +3,8 @@
 #include <QHexView/model/buffer/qdevicebuffer.h>
 #include <QHexView/model/buffer/qmappedfilebuffer.h>
 #include <QHexView/model/buffer/qmemorybuffer.h>
+#include <QHexView/model/buffer/qpagedfilebuffer.h>
+#include <QHexView/model/buffer/qpiecetablebuffer.h>
 #include <QHexView/model/commands/insertcommand.h>
 #include <QHexView/model/commands/removecommand.h>
 #include <QHexView/model/commands/replacecommand.h>
@@ -30,6 +32,18 @@ qint64 QHexDocument::lastIndexOf(const QByteArray& ba, qint64 from) {
     return m_buffer->lastIndexOf(ba, from);
 }
 
+qint64 QHexDocument::find(const QByteArray& ba, qint64 from,
+                          Qt::CaseSensitivity cs, FindDirection fd) {
+    return fd == FindDirection::Backward ? m_buffer->findLast(ba, from, cs)
+                                         : m_buffer->find(ba, from, cs);
+}
+
+qint64 QHexDocument::find(const QByteArray& ba, const QByteArray& mask,
+                          qint64 from, FindDirection fd) {
+    return fd == FindDirection::Backward ? m_buffer->findLast(ba, mask, from)
+                                         : m_buffer->find(ba, mask, from);
+}
+
 bool QHexDocument::accept(qint64 idx) const { return m_buffer->accept(idx); }
 bool QHexDocument::isEmpty() const { return m_buffer->isEmpty(); }
 bool QHexDocument::isModified() const { return !m_undostack.isClean(); }
@@ -62,6 +76,9 @@ void QHexDocument::setData(QHexBuffer* buffer) {
 
 void QHexDocument::clearModified() { m_undostack.setClean(); }
 
+// Used when a save fails after the document was already marked clean
+void QHexDocument::markModified() { m_undostack.resetClean(); }
+
 qint64 QHexDocument::length() const {
     return m_buffer ? m_buffer->length() : 0;
 }
@@ -124,6 +141,16 @@ bool QHexDocument::saveTo(QIODevice* device) {
     return true;
 }
 
+void QHexDocument::release() { m_buffer->release(); }
+
+bool QHexDocument::restore(bool replaced) {
+    if(!m_buffer->restore(replaced))
+        return false;
+    if(replaced)
+        m_undostack.setClean();
+    return true;
+}
+
 QHexDocument* QHexDocument::fromBuffer(QHexBuffer* buffer, QObject* parent) {
     return new QHexDocument(buffer, parent);
 }
@@ -137,6 +164,17 @@ QHexDocument* QHexDocument::fromMappedFile(QString filename, QObject* parent) {
                                                        parent);
 }
 
+QHexDocument* QHexDocument::fromPagedFile(QString filename, QObject* parent) {
+    return QHexDocument::fromDevice<QPagedFileBuffer>(new QFile(filename),
+                                                      parent);
+}
+
+QHexDocument* QHexDocument::fromPieceTableFile(QString filename,
+                                               QObject* parent) {
+    return QHexDocument::fromDevice<QPieceTableBuffer>(new QFile(filename),
+                                                       parent);
+}
+
 QHexDocument* QHexDocument::create(QObject* parent) {
     return QHexDocument::fromMemory<QMemoryBuffer>({}, parent);
 }
@@ -77,23 +77,32 @@ bool check(QString& p, qint64& len) {
     return true;
 }
 
-bool match(const QByteArray& data, const QString& pattern) {
-    for(qint64 i = 0, idx = 0; (i <= (pattern.size() - 2)); i += 2, idx++) {
-        if(idx >= data.size())
-            return false;
+bool compile(QString p, QByteArray& bytes, QByteArray& mask) {
+    // Compiled once per search call, cheap enough not to need a cache
+    qint64 len = 0;
+    if(!PatternUtils::check(p, len))
+        return false;
 
+    bytes.resize(len);
+    mask.resize(len);
+
+    for(auto i = 0, idx = 0; i < p.size(); i += 2, idx++) {
 #if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-        QStringView hexb = QStringView{pattern}.mid(i, 2);
+        QStringView hexb = QStringView{p}.mid(i, 2);
 #else
-        const QStringRef& hexb = pattern.midRef(i, 2);
+        const QStringRef& hexb = p.midRef(i, 2);
 #endif
 
-        if(hexb == *WILDCARD_BYTE)
+        if(hexb == *WILDCARD_BYTE) {
+            bytes[idx] = 0;
+            mask[idx] = 0;
             continue;
+        }
 
         bool ok = false;
-        auto b = static_cast<char>(hexb.toUInt(&ok, 16));
-        if(!ok || (b != data.at(idx)))
+        bytes[idx] = static_cast<char>(hexb.toUInt(&ok, 16));
+        mask[idx] = static_cast<char>(0xFF);
+        if(!ok)
             return false;
     }
 
@@ -115,41 +124,6 @@ unsigned int countBits(uint val) {
     return QHexFindOptions::Int64;
 }
 
-template<typename Function>
-qint64 findIter(qint64 startoffset, QHexFindDirection fd,
-                const QHexView* hexview, Function&& f) {
-    QHexDocument* hexdocument = hexview->hexDocument();
-    qint64 offset = -1;
-
-    QHexFindDirection cfd = fd;
-    if(cfd == QHexFindDirection::All)
-        cfd = QHexFindDirection::Forward;
-
-    qint64 i = startoffset;
-
-    bool restartLoopOnce = true;
-
-    while(offset == -1 &&
-          (cfd == QHexFindDirection::Backward ? (i >= 0)
-                                              : (i < hexdocument->length()))) {
-        if(!f(i, offset))
-            break;
-
-        if(cfd == QHexFindDirection::Backward)
-            i--;
-        else
-            i++;
-
-        if(fd == QHexFindDirection::All && i >= hexdocument->length() &&
-           restartLoopOnce) {
-            i = 0;
-            restartLoopOnce = false;
-        }
-    }
-
-    return offset;
-}
-
 qint64 findDefault(const QByteArray& value, qint64 startoffset,
                    const QHexView* hexview, unsigned int options,
                    QHexFindDirection fd) {
@@ -157,50 +131,45 @@ qint64 findDefault(const QByteArray& value, qint64 startoffset,
     if(value.size() > hexdocument->length())
         return -1;
 
-    return findIter(
-        startoffset, fd, hexview,
-        [options, value, hexdocument](qint64 idx, qint64& offset) -> bool {
-            for(auto i = 0; i < value.size(); i++) {
-                qint64 curroffset = idx + i;
-
-                if(curroffset >= hexdocument->length()) {
-                    offset = -1;
-                    return false;
-                }
-
-                uchar ch1 = hexdocument->at(curroffset);
-                uchar ch2 = value.at(i);
-
-                if(!(options & QHexFindOptions::CaseSensitive)) {
-                    ch1 = std::tolower(ch1);
-                    ch2 = std::tolower(ch2);
-                }
-
-                if(ch1 != ch2)
-                    break;
-                if(i == value.size() - 1)
-                    offset = idx;
-            }
+    Qt::CaseSensitivity cs = (options & QHexFindOptions::CaseSensitive)
+                                 ? Qt::CaseSensitive
+                                 : Qt::CaseInsensitive;
+
+    if(fd == QHexFindDirection::Backward)
+        return hexdocument->find(value, startoffset, cs,
+                                 QHexDocument::FindDirection::Backward);
 
-            return true;
-        });
+    qint64 offset = hexdocument->find(value, startoffset, cs);
+
+    // Wrap around once when searching in all directions
+    if(offset == -1 && fd == QHexFindDirection::All && startoffset > 0)
+        offset = hexdocument->find(value, 0, cs);
+
+    return offset;
 }
 
 qint64 findWildcard(QString pattern, qint64 startoffset,
                     const QHexView* hexview, QHexFindDirection fd,
                     qint64& patternlen) {
     QHexDocument* hexdocument = hexview->hexDocument();
-    if(!PatternUtils::check(pattern, patternlen) ||
-       (patternlen >= hexdocument->length()))
+    QByteArray bytes, mask;
+    if(!PatternUtils::compile(pattern, bytes, mask) ||
+       (bytes.size() > hexdocument->length()))
         return -1;
 
-    return findIter(
-        startoffset, fd, hexview,
-        [hexdocument, pattern, patternlen](qint64 idx, qint64& offset) -> bool {
-            if(PatternUtils::match(hexdocument->read(idx, patternlen), pattern))
-                offset = idx;
-            return true;
-        });
+    patternlen = bytes.size();
+
+    if(fd == QHexFindDirection::Backward)
+        return hexdocument->find(bytes, mask, startoffset,
+                                 QHexDocument::FindDirection::Backward);
+
+    qint64 offset = hexdocument->find(bytes, mask, startoffset);
+
+    // Wrap around once when searching in all directions
+    if(offset == -1 && fd == QHexFindDirection::All && startoffset > 0)
+        offset = hexdocument->find(bytes, mask, 0);
+
+    return offset;
 }
 
 QByteArray variantToByteArray(QVariant value, QHexFindMode mode,
@@ -332,13 +301,25 @@ QPair<qint64, qint64> find(const QHexView* hexview, QVariant value,
     if(startoffset == -1)
         startoffset = static_cast<qint64>(hexview->offset());
 
+    bool wildcard = false;
+
     if(mode == QHexFindMode::Hex && QHEXVIEW_VARIANT_EQ(value, String)) {
+        QString pattern = value.toString();
+        wildcard = PatternUtils::check(pattern, size) &&
+                   pattern.contains(*PatternUtils::WILDCARD_BYTE);
+    }
+
+    if(wildcard) {
         offset = QHexUtils::findWildcard(value.toString(), startoffset, hexview,
                                          fd, size);
     }
     else {
         auto ba = variantToByteArray(value, mode, options);
 
+        // Only text is folded, binary values always match exactly
+        if(mode != QHexFindMode::Text)
+            options |= QHexFindOptions::CaseSensitive;
+
         if(!ba.isEmpty()) {
             offset =
                 QHexUtils::findDefault(ba, startoffset, hexview, options, fd);
@@ -0,0 +1,221 @@
+#include <QHexView/qhexrenderer.h>
+#include <QPainter>
+#include <QPalette>
+#include <QtMath>
+
+static_assert(sizeof(QHexRenderer::Style) == 4 * sizeof(quint32),
+              "Style is hashed as raw memory and must not have padding");
+
+void QHexRenderer::Style::setForeground(const QColor& c) {
+    if(c.isValid())
+        foreground = c.rgba();
+}
+
+void QHexRenderer::Style::setBackground(const QColor& c) {
+    if(!c.isValid())
+        return;
+
+    if(c.alpha()) {
+        background = c.rgba();
+        flags |= Background;
+    }
+    else
+        this->clearBackground();
+}
+
+void QHexRenderer::Style::setUnderline(const QColor& c) {
+    // A fully transparent color means "same as the text"
+    underline = c.isValid() ? c.rgba() : 0;
+    flags |= Underline;
+}
+
+QHexRenderer::QHexRenderer()
+    : m_fontmetrics(QFont()), m_cache(MAX_CACHED_LINES) {}
+
+QHexRenderer::Style QHexRenderer::defaultStyle() const {
+    return {m_foreground, 0, 0, 0};
+}
+
+QHexRenderer::Style QHexRenderer::style(const QTextCharFormat& cf) const {
+    Style s = this->defaultStyle();
+
+    if(cf.hasProperty(QTextFormat::ForegroundBrush))
+        s.setForeground(cf.foreground().color());
+    if(cf.hasProperty(QTextFormat::BackgroundBrush) &&
+       cf.background().style() != Qt::NoBrush)
+        s.setBackground(cf.background().color());
+    if(cf.underlineStyle() != QTextCharFormat::NoUnderline)
+        s.setUnderline(cf.underlineColor());
+    if(cf.fontWeight() > QFont::Normal)
+        s.flags |= Style::Bold;
+    if(cf.fontItalic())
+        s.flags |= Style::Italic;
+
+    return s;
+}
+
+void QHexRenderer::setup(const QFont& font, const QPalette& palette,
+                         QChar unprintablechar, QChar invalidchar, qreal dpr) {
+    QRgb base = palette.color(QPalette::Base).rgba();
+    QRgb foreground = palette.color(QPalette::Text).rgba();
+
+    if(!m_glyphs.isEmpty() && m_font == font && m_base == base &&
+       m_foreground == foreground && m_unprintablechar == unprintablechar &&
+       m_invalidchar == invalidchar && qFuzzyCompare(m_dpr, dpr))
+        return;
+
+    m_font = font;
+    m_fontmetrics = QFontMetricsF(font);
+    m_base = base;
+    m_foreground = foreground;
+    m_unprintablechar = unprintablechar;
+    m_invalidchar = invalidchar;
+    m_dpr = dpr;
+    this->clear();
+
+    m_glyphs.resize(GlyphCount);
+
+    for(int b = 0; b < 256; b++) {
+        m_glyphs[HexGlyph + b].setText(
+            QString("%1").arg(b, 2, 16, QLatin1Char('0')).toUpper());
+        m_glyphs[AsciiGlyph + b].setText(b < 0x80 && QChar::isPrint(b)
+                                             ? QString(QChar(b))
+                                             : QString(unprintablechar));
+    }
+
+    m_glyphs[InvalidGlyph].setText(QString(invalidchar));
+    m_glyphs[InvalidPairGlyph].setText(QString(invalidchar).repeated(2));
+    m_glyphs[BlankPairGlyph].setText(QString());
+
+    for(QStaticText& glyph : m_glyphs) {
+        glyph.setTextFormat(Qt::PlainText);
+        glyph.prepare(QTransform(), m_font);
+    }
+}
+
+void QHexRenderer::beginLine(const QColor& background) {
+    Style s = this->defaultStyle();
+    s.setBackground(background);
+
+    m_line.resize(1);
+    m_line[0] = Cell{NoGlyph, s};
+}
+
+void QHexRenderer::append(quint32 glyph, const Style& style) {
+    m_line.append(Cell{glyph, style});
+}
+
+void QHexRenderer::appendText(const QString& s, const Style& style) {
+    // Only meant for ascii text like addresses and spacing
+    for(QChar ch : s)
+        this->append(ch.unicode() < 0x80 ? AsciiGlyph + ch.unicode()
+                                         : InvalidGlyph,
+                     style);
+}
+
+void QHexRenderer::drawLine(QPainter* painter, QPointF pos) {
+    const QByteArray key = QByteArray::fromRawData(
+        reinterpret_cast<const char*>(m_line.constData()),
+        m_line.size() * static_cast<int>(sizeof(Cell)));
+
+    const QPixmap* pixmap = m_cache.object(key);
+
+    if(!pixmap) {
+        auto* rendered = new QPixmap(this->render());
+        // The lookup key points into m_line, the cache needs its own copy
+        m_cache.insert(QByteArray(key.constData(), key.size()), rendered);
+        pixmap = rendered;
+    }
+
+    painter->drawPixmap(pos, *pixmap);
+}
+
+qreal QHexRenderer::drawText(QPainter* painter, QPointF pos, const QString& s,
+                             const QTextCharFormat& cf) const {
+    QRectF r(pos.x(), pos.y(), s.size() * this->cellWidth(),
+             m_fontmetrics.height());
+    this->drawCell(painter, r, s, nullptr, this->style(cf));
+    return r.right();
+}
+
+void QHexRenderer::clear() { m_cache.clear(); }
+
+QPixmap QHexRenderer::render() const {
+    const qreal cw = this->cellWidth(), lh = m_fontmetrics.height();
+    qreal width = 0;
+
+    for(int i = 1; i < m_line.size(); i++)
+        width += QHexRenderer::cells(m_line.at(i).glyph) * cw;
+
+    QPixmap pixmap(qMax(1, qCeil(width * m_dpr)), qMax(1, qCeil(lh * m_dpr)));
+    pixmap.setDevicePixelRatio(m_dpr);
+    pixmap.fill(QColor::fromRgba(m_base));
+
+    QPainter painter(&pixmap);
+    painter.setFont(m_font);
+
+    const Style& row = m_line.first().style;
+    if(row.flags & Style::Background)
+        painter.fillRect(QRectF(0, 0, width, lh),
+                         QColor::fromRgba(row.background));
+
+    qreal x = 0;
+
+    for(int i = 1; i < m_line.size(); i++) {
+        const Cell& cell = m_line.at(i);
+        QRectF r(x, 0, QHexRenderer::cells(cell.glyph) * cw, lh);
+        this->drawCell(&painter, r, QString(), &m_glyphs.at(cell.glyph),
+                       cell.style);
+        x = r.right();
+    }
+
+    return pixmap;
+}
+
+void QHexRenderer::drawCell(QPainter* painter, const QRectF& r,
+                            const QString& s, const QStaticText* glyph,
+                            const Style& style) const {
+    if(style.flags & Style::Background)
+        painter->fillRect(r, QColor::fromRgba(style.background));
+
+    painter->setPen(QColor::fromRgba(style.foreground));
+
+    if(glyph && !(style.flags & (Style::Bold | Style::Italic)))
+        painter->drawStaticText(r.topLeft(), *glyph);
+    else {
+        QFont oldfont = painter->font(), f = m_font;
+        f.setBold(style.flags & Style::Bold);
+        f.setItalic(style.flags & Style::Italic);
+
+        painter->setFont(f);
+        painter->drawText(QPointF(r.left(), r.top() + m_fontmetrics.ascent()),
+                          glyph ? glyph->text() : s);
+        painter->setFont(oldfont);
+    }
+
+    if(style.flags & Style::Underline) {
+        qreal y =
+            r.top() + m_fontmetrics.ascent() + m_fontmetrics.underlinePos();
+
+        painter->setPen(QPen(QColor::fromRgba(qAlpha(style.underline)
+                                                  ? style.underline
+                                                  : style.foreground),
+                             m_fontmetrics.lineWidth()));
+        painter->drawLine(QLineF(r.left(), y, r.right(), y));
+    }
+}
+
+qreal QHexRenderer::cellWidth() const {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
+    return m_fontmetrics.horizontalAdvance(" ");
+#else
+    return m_fontmetrics.width(" ");
+#endif
+}
+
+int QHexRenderer::cells(quint32 glyph) {
+    if(glyph < AsciiGlyph || glyph == InvalidPairGlyph ||
+       glyph == BlankPairGlyph)
+        return 2;
+    return 1;
+}
@@ -9,8 +9,6 @@
 #include <QPainter>
 #include <QPalette>
 #include <QScrollBar>
-#include <QTextCursor>
-#include <QTextDocument>
 #include <QToolTip>
 #include <QWheelEvent>
 #include <QtGlobal>
@@ -410,18 +408,13 @@ void QHexView::setAutoWidth(bool r) {
 }
 
 void QHexView::paint(QPainter* painter) const {
-    QTextDocument doc;
-    doc.setDocumentMargin(0);
-    doc.setUndoRedoEnabled(false);
-    doc.setDefaultFont(this->font());
-
-    QTextCursor c(&doc);
-
-    this->drawHeader(c);
-    this->drawDocument(c);
+    m_hexrenderer.setup(this->font(), this->palette(), m_options.unprintablechar,
+                        m_options.invalidchar,
+                        painter->device()->devicePixelRatioF());
 
     painter->translate(-this->horizontalScrollBar()->value(), 0);
-    doc.drawContents(painter);
+    this->drawHeader(painter);
+    this->drawDocument(painter);
     this->drawSeparators(painter);
 }
 
@@ -561,7 +554,7 @@ void QHexView::drawSeparators(QPainter* p) const {
     p->setPen(oldpen);
 }
 
-void QHexView::drawHeader(QTextCursor& c) const {
+void QHexView::drawHeader(QPainter* p) const {
     if(m_options.hasFlag(QHexFlags::NoHeader))
         return;
 
@@ -571,6 +564,14 @@ void QHexView::drawHeader(QTextCursor& c) const {
         cf.setForeground(options.headercolor);
     };
 
+    QTextBlockFormat bf;
+    if(m_options.hasFlag(QHexFlags::StyledHeader))
+        bf.setBackground(this->palette().color(QPalette::Window));
+    if(m_hexdelegate)
+        m_hexdelegate->renderHeader(bf, this);
+    if(bf.hasProperty(QTextFormat::BackgroundBrush))
+        p->fillRect(this->headerRect(), bf.background());
+
     QString addresslabel;
     if(m_hexdelegate)
         addresslabel = m_hexdelegate->addressHeader(this);
@@ -582,7 +583,8 @@ void QHexView::drawHeader(QTextCursor& c) const {
     if(m_hexdelegate)
         m_hexdelegate->renderHeaderPart(addresslabel, QHexArea::Address, cf,
                                         this);
-    c.insertText(
+    qreal x = m_hexrenderer.drawText(
+        p, QPointF(0, 0),
         " " + QHexView::reduced(addresslabel, this->addressWidth()) + " ", cf);
 
     if(m_hexdelegate)
@@ -595,7 +597,7 @@ void QHexView::drawHeader(QTextCursor& c) const {
         hexlabel = m_options.hexlabel;
 
     if(hexlabel.isNull()) {
-        c.insertText(" ", {});
+        x += this->cellWidth();
 
         for(auto i = 0u; i < m_options.linelength; i += m_options.grouplength) {
             QString h = QString::number(i, 16)
@@ -614,19 +616,22 @@ void QHexView::drawHeader(QTextCursor& c) const {
                     this->palette().color(QPalette::HighlightedText));
             }
 
-            c.insertText(h, cf);
-            c.insertText(" ", {});
+            x = m_hexrenderer.drawText(p, QPointF(x, 0), h, cf);
+            x += this->cellWidth();
             RESET_FORMAT(m_options, cf);
         }
     }
     else {
         if(m_hexdelegate)
             m_hexdelegate->renderHeaderPart(hexlabel, QHexArea::Hex, cf, this);
-        c.insertText(
+        x = m_hexrenderer.drawText(
+            p, QPointF(x, 0),
             " " +
-            QHexView::reduced(
-                hexlabel, (this->hexColumnWidth() / this->cellWidth()) - 1) +
-            " ");
+                QHexView::reduced(
+                    hexlabel,
+                    (this->hexColumnWidth() / this->cellWidth()) - 1) +
+                " ",
+            {});
     }
 
     if(m_hexdelegate)
@@ -639,7 +644,7 @@ void QHexView::drawHeader(QTextCursor& c) const {
         asciilabel = m_options.asciilabel;
 
     if(asciilabel.isNull()) {
-        c.insertText(" ", {});
+        x += this->cellWidth();
 
         for(unsigned int i = 0; i < m_options.linelength; i++) {
             QString a = QString::number(i, 16).toUpper();
@@ -656,44 +661,36 @@ void QHexView::drawHeader(QTextCursor& c) const {
                     this->palette().color(QPalette::HighlightedText));
             }
 
-            c.insertText(a, cf);
+            x = m_hexrenderer.drawText(p, QPointF(x, 0), a, cf);
             RESET_FORMAT(m_options, cf);
         }
-
-        c.insertText(" ", {});
     }
     else {
         if(m_hexdelegate)
             m_hexdelegate->renderHeaderPart(asciilabel, QHexArea::Ascii, cf,
                                             this);
-        c.insertText(" " +
-                     QHexView::reduced(asciilabel, ((this->endColumnX() -
-                                                     this->asciiColumnX() -
-                                                     this->cellWidth()) /
-                                                    this->cellWidth()) -
-                                                       1) +
-                     " ");
+        m_hexrenderer.drawText(
+            p, QPointF(x, 0),
+            " " +
+                QHexView::reduced(asciilabel, ((this->endColumnX() -
+                                                this->asciiColumnX() -
+                                                this->cellWidth()) /
+                                               this->cellWidth()) -
+                                                  1) +
+                " ",
+            {});
     }
-
-    QTextBlockFormat bf;
-    if(m_options.hasFlag(QHexFlags::StyledHeader))
-        bf.setBackground(this->palette().color(QPalette::Window));
-    if(m_hexdelegate)
-        m_hexdelegate->renderHeader(bf, this);
-    c.setBlockFormat(bf);
-    c.insertBlock();
 }
 
-void QHexView::drawDocument(QTextCursor& c) const {
+void QHexView::drawDocument(QPainter* p) const {
     if(!m_hexdocument)
         return;
 
     qreal y = !m_options.hasFlag(QHexFlags::NoHeader) ? this->lineHeight() : 0;
     quint64 line = static_cast<quint64>(this->verticalScrollBar()->value());
 
-    QTextCharFormat addrformat;
-    addrformat.setForeground(
-        this->palette().color(QPalette::Normal, QPalette::Highlight));
+    const QHexRenderer::Style nostyle = m_hexrenderer.defaultStyle();
+    const quint32 space = QHexRenderer::AsciiGlyph + ' ';
 
     for(qint64 l = 0; m_hexdocument->isEmpty() ||
                       (line < this->lines() && l < this->visibleLines());
@@ -703,6 +700,14 @@ void QHexView::drawDocument(QTextCursor& c) const {
                               .rightJustified(this->addressWidth(), '0')
                               .toUpper();
 
+        QColor linebg;
+        if(m_options.linealternatebackground.isValid() && line % 2)
+            linebg = m_options.linealternatebackground;
+        else if(m_options.linebackground.isValid() && !(line % 2))
+            linebg = m_options.linebackground;
+
+        m_hexrenderer.beginLine(linebg);
+
         // Address Part
         QTextCharFormat acf;
         acf.setForeground(m_options.headercolor);
@@ -719,77 +724,60 @@ void QHexView::drawDocument(QTextCursor& c) const {
             acf.setForeground(this->palette().color(QPalette::HighlightedText));
         }
 
-        c.insertText(" " + addrstr + " ", acf);
+        m_hexrenderer.appendText(" " + addrstr + " ", m_hexrenderer.style(acf));
 
         QByteArray linebytes = this->getLine(line);
-        c.insertText(" ", {});
+        m_hexrenderer.append(space, nostyle);
 
         // Hex Part
         for(unsigned int column = 0u; column < m_options.linelength;) {
-            QTextCharFormat cf;
+            QHexRenderer::Style gapstyle = nostyle;
 
             for(unsigned int byteidx = 0u; byteidx < m_options.grouplength;
                 byteidx++, column++) {
-                QString s;
+                quint32 glyph = QHexRenderer::InvalidPairGlyph;
                 quint8 b{};
 
                 if(m_hexdocument->accept(
                        this->positionFromLineCol(line, column))) {
-                    s = linebytes.isEmpty() ||
-                                column >= static_cast<qint64>(linebytes.size())
-                            ? "  "
-                            : QString(QHexUtils::toHex(linebytes.mid(column, 1))
-                                          .toUpper());
                     b = static_cast<int>(column) < linebytes.size()
                             ? linebytes.at(column)
                             : 0x00;
+                    glyph = static_cast<int>(column) < linebytes.size()
+                                ? QHexRenderer::HexGlyph + b
+                                : QHexRenderer::BlankPairGlyph;
                 }
-                else
-                    s = QString(m_options.invalidchar).repeated(2);
 
-                cf = this->drawFormat(c, b, s, QHexArea::Hex, line, column,
-                                      static_cast<int>(column) <
-                                          linebytes.size());
+                gapstyle = this->drawFormat(glyph, b, QHexArea::Hex, line,
+                                            column,
+                                            static_cast<int>(column) <
+                                                linebytes.size());
             }
 
-            c.insertText(" ", cf);
+            m_hexrenderer.append(space, gapstyle);
         }
 
-        c.insertText(" ", {});
+        m_hexrenderer.append(space, nostyle);
 
         // Ascii Part
         for(unsigned int column = 0u; column < m_options.linelength; column++) {
-            QString s;
+            quint32 glyph = QHexRenderer::InvalidGlyph;
             quint8 b{};
 
             if(m_hexdocument->accept(this->positionFromLineCol(line, column))) {
-                s = linebytes.isEmpty() ||
-                            column >= static_cast<qint64>(linebytes.size())
-                        ? QChar(' ')
-                        : (QChar::isPrint(linebytes.at(column))
-                               ? QChar(linebytes.at(column))
-                               : m_options.unprintablechar);
-
                 b = static_cast<int>(column) < linebytes.size()
                         ? linebytes.at(column)
                         : 0x00;
+                glyph = static_cast<int>(column) < linebytes.size()
+                            ? QHexRenderer::AsciiGlyph + b
+                            : space;
             }
-            else
-                s = m_options.invalidchar;
 
-            this->drawFormat(c, b, s, QHexArea::Ascii, line, column,
+            this->drawFormat(glyph, b, QHexArea::Ascii, line, column,
                              static_cast<int>(column) < linebytes.size());
         }
 
-        QTextBlockFormat bf;
-
-        if(m_options.linealternatebackground.isValid() && line % 2)
-            bf.setBackground(m_options.linealternatebackground);
-        else if(m_options.linebackground.isValid() && !(line % 2))
-            bf.setBackground(m_options.linebackground);
-
-        c.setBlockFormat(bf);
-        c.insertBlock({});
+        m_hexrenderer.drawLine(p, QPointF(0, y));
         if(m_hexdocument->isEmpty())
             break;
     }
@@ -1014,25 +1002,30 @@ QHexArea QHexView::areaFromPoint(QPoint pt) const {
     return QHexArea::Extra;
 }
 
-QTextCharFormat QHexView::drawFormat(QTextCursor& c, quint8 b, const QString& s,
-                                     QHexArea area, qint64 line, qint64 column,
-                                     bool applyformat) const {
-    QTextCharFormat cf, selcf;
+QHexRenderer::Style QHexView::drawFormat(quint32 glyph, quint8 b,
+                                         QHexArea area, qint64 line,
+                                         qint64 column,
+                                         bool applyformat) const {
+    QHexRenderer::Style style = m_hexrenderer.defaultStyle(),
+                        selstyle = style;
     QHexPosition pos{line, column};
 
     if(applyformat) {
         auto offset = m_hexcursor->positionToOffset(pos);
-        bool hasdelegate =
-            m_hexdelegate && m_hexdelegate->render(offset, b, cf, this);
+        bool hasdelegate = false;
+
+        if(m_hexdelegate) {
+            QTextCharFormat cf;
+            hasdelegate = m_hexdelegate->render(offset, b, cf, this);
+            style = m_hexrenderer.style(cf);
+        }
 
         if(!hasdelegate) {
             auto it = m_options.bytecolors.find(b);
 
             if(it != m_options.bytecolors.end()) {
-                if(it->background.isValid())
-                    cf.setBackground(it->background);
-                if(it->foreground.isValid())
-                    cf.setForeground(it->foreground);
+                style.setBackground(it->background);
+                style.setForeground(it->foreground);
             }
         }
 
@@ -1044,59 +1037,52 @@ QTextCharFormat QHexView::drawFormat(QTextCursor& c, quint8 b, const QString& s,
                     continue;
 
                 if(!hasdelegate) {
-                    if(metadata.foreground.isValid())
-                        cf.setForeground(metadata.foreground);
+                    style.setForeground(metadata.foreground);
 
                     if(metadata.background.isValid()) {
-                        cf.setBackground(metadata.background);
+                        style.setBackground(metadata.background);
 
                         if(!metadata.foreground.isValid())
-                            cf.setForeground(
+                            style.setForeground(
                                 this->getReadableColor(metadata.background));
                     }
                 }
 
-                if(!metadata.comment.isEmpty()) {
-                    cf.setUnderlineColor(
+                if(!metadata.comment.isEmpty())
+                    style.setUnderline(
                         m_options.commentcolor.isValid()
                             ? m_options.commentcolor
                             : this->palette().color(QPalette::WindowText));
-                    cf.setUnderlineStyle(
-                        QTextCharFormat::UnderlineStyle::SingleUnderline);
-                }
 
                 if(offset == metadata.begin) // Remove previous metadata's
                                              // style, if needed
                 {
                     if(metadata.comment.isEmpty())
-                        selcf.setUnderlineStyle(
-                            QTextCharFormat::UnderlineStyle::NoUnderline);
-                    if(!metadata.foreground.isValid())
-                        selcf.setForeground(Qt::color1);
+                        selstyle.clearUnderline();
                     if(!metadata.background.isValid())
-                        selcf.setBackground(Qt::transparent);
+                        selstyle.clearBackground();
                 }
 
                 if(offset < metadata.end - 1 &&
                    column < this->getLastColumn(line))
-                    selcf = cf;
+                    selstyle = style;
             }
         }
 
         if(hasdelegate && column < this->getLastColumn(line))
-            selcf = cf;
+            selstyle = style;
     }
 
     if(this->hexCursor()->isSelected(line, column)) {
         auto offset = this->hexCursor()->positionToOffset(pos);
         auto selend = this->hexCursor()->selectionEndOffset();
 
-        cf.setBackground(
+        style.setBackground(
             this->palette().color(QPalette::Normal, QPalette::Highlight));
-        cf.setForeground(
+        style.setForeground(
             this->palette().color(QPalette::Normal, QPalette::HighlightedText));
         if(offset < selend && column < this->getLastColumn(line))
-            selcf = cf;
+            selstyle = style;
     }
 
     if(this->hexCursor()->position() == pos) {
@@ -1113,23 +1099,21 @@ QTextCharFormat QHexView::drawFormat(QTextCursor& c, quint8 b, const QString& s,
 
         switch(m_hexcursor->mode()) {
             case QHexCursor::Mode::Insert:
-                cf.setUnderlineColor(m_currentarea == area ? cursorbg
-                                                           : discursorbg);
-                cf.setUnderlineStyle(
-                    QTextCharFormat::UnderlineStyle::SingleUnderline);
+                style.setUnderline(m_currentarea == area ? cursorbg
+                                                         : discursorbg);
                 break;
 
             case QHexCursor::Mode::Overwrite:
-                cf.setBackground(m_currentarea == area ? cursorbg
-                                                       : discursorbg);
-                cf.setForeground(m_currentarea == area ? cursorfg
-                                                       : discursorfg);
+                style.setBackground(m_currentarea == area ? cursorbg
+                                                          : discursorbg);
+                style.setForeground(m_currentarea == area ? cursorfg
+                                                          : discursorfg);
                 break;
         }
     }
 
-    c.insertText(s, cf);
-    return selcf;
+    m_hexrenderer.append(glyph, style);
+    return selstyle;
 }
 
 void QHexView::moveNext(bool select) {
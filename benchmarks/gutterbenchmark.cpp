@@ -0,0 +1,107 @@
+#include <QImage>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QtTest>
+#include "sourcecodeedit.h"
+
+#define BENCHMARK_LINES 100000
+
+class GutterBenchmark : public QObject
+{
+    Q_OBJECT
+private:
+    SourceCodeEdit *m_Edit;
+    SourceCodeSidebarWidget *m_Sidebar;
+    static void paintPerLine(QPainter &painter, SourceCodeEdit *edit, QWidget *sidebar);
+    void scroll();
+private slots:
+    void cached();
+    void cleanupTestCase();
+    void initTestCase();
+    void perLine();
+};
+
+void GutterBenchmark::cached()
+{
+    QImage image(m_Sidebar->size(), QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        scroll();
+        m_Sidebar->render(&image);
+    }
+}
+
+void GutterBenchmark::cleanupTestCase()
+{
+    delete m_Edit;
+}
+
+void GutterBenchmark::initTestCase()
+{
+    // 十万行的文件，每次迭代向下翻一页后绘制行号栏
+    QStringList lines;
+    lines.reserve(BENCHMARK_LINES);
+    for (int i = 0; i < BENCHMARK_LINES; ++i) {
+        lines.append(QString("    invoke-virtual {p0, v%1}, Lcom/example/app/MainActivity;->update(I)V").arg(i % 16));
+    }
+    m_Edit = new SourceCodeEdit();
+    m_Edit->setPlainText(lines.join('\n'));
+    m_Edit->resize(1024, 768);
+    m_Edit->show();
+    m_Sidebar = m_Edit->findChild<SourceCodeSidebarWidget *>();
+    QVERIFY(m_Sidebar);
+}
+
+void GutterBenchmark::paintPerLine(QPainter &painter, SourceCodeEdit *edit, QWidget *sidebar)
+{
+    // 改为缓存数字之前的做法：每一行都创建字体和字符串，并重画分隔线
+    QTextBlock block = edit->firstVisibleBlockProxy();
+    int i = block.blockNumber();
+    int top = static_cast<int>(edit->blockBoundingGeometryProxy(block).translated(edit->contentOffsetProxy()).top());
+    int bottom = top + static_cast<int>(edit->blockBoundingRectProxy(block).height());
+    const QRect full = sidebar->rect();
+    painter.fillRect(full, sidebar->palette().color(QPalette::Base));
+    while (block.isValid() && (top <= full.bottom())) {
+        if (block.isVisible() && (bottom >= full.top())) {
+            QRect box(0, top, sidebar->width(), edit->fontMetrics().height());
+            QFont font = painter.font();
+            font.setFamily(edit->font().family());
+            font.setPointSize(edit->font().pointSize());
+            if (edit->textCursor().blockNumber() == i) {
+                painter.fillRect(box, sidebar->palette().color(QPalette::Highlight));
+                painter.setPen(sidebar->palette().color(QPalette::HighlightedText));
+                font.setWeight(QFont::Bold);
+            } else {
+                font.setWeight(QFont::Normal);
+                painter.setPen(sidebar->palette().color(QPalette::Text));
+            }
+            painter.setFont(font);
+            painter.drawText(box.left(), box.top(), box.width(), box.height(), Qt::AlignRight, QString::number(i + 1).append(' '));
+            painter.setPen(sidebar->palette().color(QPalette::Highlight));
+            painter.drawLine(full.topRight(), full.bottomRight());
+        }
+        block = block.next();
+        top = bottom;
+        bottom = (top + static_cast<int>(edit->blockBoundingRectProxy(block).height()));
+        ++i;
+    }
+}
+
+void GutterBenchmark::perLine()
+{
+    QImage image(m_Sidebar->size(), QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        scroll();
+        QPainter painter(&image);
+        paintPerLine(painter, m_Edit, m_Sidebar);
+    }
+}
+
+void GutterBenchmark::scroll()
+{
+    QScrollBar *bar = m_Edit->verticalScrollBar();
+    bar->setValue((bar->value() + bar->pageStep()) % (bar->maximum() + 1));
+}
+
+QTEST_MAIN(GutterBenchmark)
+#include "gutterbenchmark.moc"
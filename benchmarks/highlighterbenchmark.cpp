@@ -0,0 +1,190 @@
+#include <QFile>
+#include <QRegularExpression>
+#include <QSyntaxHighlighter>
+#include <QTextDocument>
+#include <QtTest>
+#include "themedsyntaxhighlighter.h"
+
+#define BENCHMARK_REPEAT 2000
+#define REGEXP_CRLF "[\\r\\n]"
+#define REGEXP_WHITESPACE "[\\s\\t]+"
+
+// 改为合并扫描之前的做法：每条规则各自对整行做一次 globalMatch，后面的规则覆盖前面的样式
+class LayeredSyntaxHighlighter : public QSyntaxHighlighter
+{
+public:
+    LayeredSyntaxHighlighter(const SyntaxHighlighterTheme &theme, const SyntaxHighlighterDefinitionList &definitions, QTextDocument *document)
+        : QSyntaxHighlighter(document), m_Definitions(definitions), m_Theme(theme)
+    {
+    }
+protected:
+    void highlightBlock(const QString &text) override
+    {
+        foreach (const SyntaxHighlighterDefinition &definition, m_Definitions) {
+            if (definition.multiline) {
+                setCurrentBlockState(0);
+                int i = 0;
+                if (previousBlockState() != 1) {
+                    i = text.indexOf(definition.regexp);
+                }
+                while (i >= 0) {
+                    QRegularExpressionMatch match = definition.end.match(text, i);
+                    int j = match.capturedStart();
+                    int length;
+                    if (j == -1) {
+                        setCurrentBlockState(1);
+                        length = (text.length() - i);
+                    } else {
+                        length = ((j - i) + match.capturedLength());
+                    }
+                    setFormat(i, length, m_Theme.value(definition.style));
+                    i = text.indexOf(definition.regexp, i + length);
+                }
+                continue;
+            }
+            QRegularExpressionMatchIterator iterator = definition.regexp.globalMatch(text);
+            while (iterator.hasNext()) {
+                QRegularExpressionMatch match = iterator.next();
+                setFormat(match.capturedStart(), match.capturedLength(), m_Theme.value(definition.style));
+            }
+        }
+    }
+private:
+    SyntaxHighlighterDefinitionList m_Definitions;
+    SyntaxHighlighterTheme m_Theme;
+};
+
+class HighlighterBenchmark : public QObject
+{
+    Q_OBJECT
+private:
+    static void addLanguages();
+    static SyntaxHighlighterDefinitionList baseline(const QString &language);
+    static QString sample(const QString &language);
+private slots:
+    void combined();
+    void combined_data();
+    void layered();
+    void layered_data();
+};
+
+void HighlighterBenchmark::addLanguages()
+{
+    QTest::addColumn<QString>("language");
+    QTest::newRow("java") << "java";
+    QTest::newRow("smali") << "smali";
+    QTest::newRow("xml") << "xml";
+}
+
+SyntaxHighlighterDefinitionList HighlighterBenchmark::baseline(const QString &language)
+{
+    // 合并扫描要求先匹配的规则排在前面，.def 文件因此重新排过序；逐条覆盖的做法使用调整之前的顺序，
+    // 包含的公共规则没有变化，仍从应用的资源中读取
+    SyntaxHighlighterDefinitionList definitions;
+    QFile file(QString(":/baseline/%1.def").arg(language));
+    if (!file.exists()) {
+        file.setFileName(QString(":/highlights/%1.def").arg(language));
+    }
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return definitions;
+    }
+    const QStringList lines = QString::fromUtf8(file.readAll()).split(QRegularExpression(REGEXP_CRLF), Qt::SkipEmptyParts);
+    foreach (const QString &line, lines) {
+        const QStringList pair = line.split(QRegularExpression(REGEXP_WHITESPACE), Qt::SkipEmptyParts);
+        if (pair.size() != 2) {
+            continue;
+        }
+        if (pair.first() == "@include") {
+            definitions << baseline(pair.last());
+            continue;
+        }
+        // 与应用一样在加载时编译，计时只包含匹配
+        SyntaxHighlighterDefinition definition;
+        definition.style = pair.first();
+        definition.multiline = definition.style.endsWith('?');
+        if (definition.multiline) {
+            definition.style.chop(1);
+            const QStringList parts = pair.last().split('|');
+            definition.regexp = QRegularExpression(parts.first());
+            definition.end = QRegularExpression(parts.last());
+            definition.end.optimize();
+        } else {
+            definition.regexp = QRegularExpression(pair.last());
+        }
+        definition.regexp.optimize();
+        definitions << definition;
+    }
+    return definitions;
+}
+
+void HighlighterBenchmark::combined()
+{
+    QFETCH(QString, language);
+    QTextDocument document(sample(language));
+    ThemedSyntaxHighlighter highlighter(ThemedSyntaxHighlighter::theme("light"), ThemedSyntaxHighlighter::definitions(language), &document);
+    QBENCHMARK {
+        highlighter.rehighlight();
+    }
+}
+
+void HighlighterBenchmark::combined_data()
+{
+    addLanguages();
+}
+
+void HighlighterBenchmark::layered()
+{
+    QFETCH(QString, language);
+    QTextDocument document(sample(language));
+    LayeredSyntaxHighlighter highlighter(ThemedSyntaxHighlighter::theme("light"), baseline(language), &document);
+    QBENCHMARK {
+        highlighter.rehighlight();
+    }
+}
+
+void HighlighterBenchmark::layered_data()
+{
+    addLanguages();
+}
+
+QString HighlighterBenchmark::sample(const QString &language)
+{
+    // 按反编译结果中常见的写法生成测试文本，每段重复多次
+    QString unit;
+    if (language == "smali") {
+        unit = ".method public onCreate(Landroid/os/Bundle;)V\n"
+               "    .locals 3\n"
+               "    .param p1, \"savedInstanceState\"    # Landroid/os/Bundle;\n"
+               "\n"
+               "    invoke-super {p0, p1}, Landroidx/appcompat/app/AppCompatActivity;->onCreate(Landroid/os/Bundle;)V\n"
+               "    const v0, 0x7f0c001c\n"
+               "    invoke-virtual {p0, v0}, Lcom/example/app/MainActivity;->setContentView(I)V\n"
+               "    const-string v1, \"main # screen\"\n"
+               "    iget-object v2, p0, Lcom/example/app/MainActivity;->binding:Lcom/example/app/databinding/MainBinding;\n"
+               "    if-eqz v2, :cond_0\n"
+               "    return-void\n"
+               ".end method\n\n";
+    } else if (language == "xml") {
+        unit = "<!-- toolbar\n"
+               "     with a title -->\n"
+               "<LinearLayout xmlns:android=\"http://schemas.android.com/apk/res/android\" android:layout_width=\"match_parent\">\n"
+               "    <TextView android:id=\"@id/title\" android:text=\"@string/app_name\" android:textSize=\"16.0sp\" />\n"
+               "    <ImageView android:layout_height=\"48.0dip\" android:src=\"@drawable/ic_launcher\" />\n"
+               "</LinearLayout>\n";
+    } else {
+        unit = "package com.example.app;\n"
+               "import android.os.Bundle;\n"
+               "/* the main\n"
+               "   screen */\n"
+               "@Override\n"
+               "public final class MainActivity extends AppCompatActivity {\n"
+               "    private static final int REQUEST_CODE = 0x2a;\n"
+               "    // keep the title\n"
+               "    protected void onCreate(Bundle state) { super.onCreate(state); setTitle(\"Main 42\"); }\n"
+               "}\n";
+    }
+    return unit.repeated(BENCHMARK_REPEAT);
+}
+
+QTEST_MAIN(HighlighterBenchmark)
+#include "highlighterbenchmark.moc"
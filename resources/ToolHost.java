@@ -0,0 +1,111 @@
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.InputStreamReader;
+import java.lang.reflect.InvocationTargetException;
+import java.lang.reflect.Method;
+import java.nio.charset.StandardCharsets;
+import java.security.Permission;
+import java.util.jar.JarFile;
+
+/**
+ * 常驻的 Java 工具宿主，由 APK Studio 首次使用时编译到应用数据目录后启动：
+ *
+ *   java -Xmx...m -cp tool.jar:DIR ToolHost tool.jar MARKER
+ *
+ * 没有 javac 时以源文件模式启动（需要 Java 11+）：
+ *
+ *   java -Xmx...m -cp tool.jar ToolHost.java tool.jar MARKER
+ *
+ * Java 18 起 SecurityManager 默认被禁用，无法拦截 System.exit，此时输出一行 "MARKER UNSUPPORTED" 后退出，
+ * 由 APK Studio 改用一次性进程。
+ * 每条命令从标准输入读取：第一行为参数个数 N，随后 N 行各为一个参数。
+ * 工具的输出直接写到标准输出，完成后输出一行 "MARKER 退出代码"。
+ */
+public class ToolHost {
+
+    private static class ExitTrap extends SecurityException {
+        final int code;
+
+        ExitTrap(int code) {
+            this.code = code;
+        }
+    }
+
+    private static int featureVersion() {
+        // Java 8 及以前为 1.x，之后为主版本号
+        String version = System.getProperty("java.specification.version");
+        if (version.startsWith("1.")) {
+            version = version.substring(2);
+        }
+        final int dot = version.indexOf('.');
+        return Integer.parseInt(dot < 0 ? version : version.substring(0, dot));
+    }
+
+    public static void main(String[] args) throws Exception {
+        final String marker = args[1];
+        String name;
+        try (JarFile jar = new JarFile(new File(args[0]))) {
+            name = jar.getManifest().getMainAttributes().getValue("Main-Class");
+        }
+        Method main = Class.forName(name.trim()).getMethod("main", String[].class);
+        boolean trapped = false;
+        try {
+            if (featureVersion() >= 18) {
+                throw new UnsupportedOperationException();
+            }
+            // 拦截工具内部的 System.exit，使 JVM 在命令之间保持存活
+            System.setSecurityManager(new SecurityManager() {
+                @Override
+                public void checkPermission(Permission permission) {
+                }
+
+                @Override
+                public void checkPermission(Permission permission, Object context) {
+                }
+
+                @Override
+                public void checkExit(int status) {
+                    throw new ExitTrap(status);
+                }
+            });
+            trapped = true;
+        } catch (Throwable ignored) {
+        }
+        if (!trapped) {
+            // 工具调用 System.exit 时宿主会随之退出，常驻没有意义
+            System.out.println(marker + " UNSUPPORTED");
+            System.out.flush();
+            Runtime.getRuntime().halt(0);
+        }
+        BufferedReader in = new BufferedReader(new InputStreamReader(System.in, StandardCharsets.UTF_8));
+        System.out.println(marker + " READY");
+        System.out.flush();
+        String line;
+        while ((line = in.readLine()) != null) {
+            final int count = Integer.parseInt(line.trim());
+            final String[] argv = new String[count];
+            for (int i = 0; i < count; i++) {
+                argv[i] = in.readLine();
+            }
+            int code = 0;
+            try {
+                main.invoke(null, (Object) argv);
+            } catch (InvocationTargetException e) {
+                Throwable cause = e.getCause();
+                if (cause instanceof ExitTrap) {
+                    code = ((ExitTrap) cause).code;
+                } else {
+                    cause.printStackTrace();
+                    code = 1;
+                }
+            } catch (ExitTrap e) {
+                code = e.code;
+            }
+            System.err.flush();
+            System.out.println();
+            System.out.println(marker + " " + code);
+            System.out.flush();
+        }
+        Runtime.getRuntime().halt(0);
+    }
+}
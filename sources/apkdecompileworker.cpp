@@ -1,7 +1,12 @@
 #include <QDebug>
 #include <QRegularExpression>
+#include <QThread>
+#include <QVersionNumber>
 #include "apkdecompileworker.h"
 #include "processutils.h"
+#include "versionresolveworker.h"
+
+#define APKTOOL_JOBS_VERSION 2, 7, 0
 
 ApkDecompileWorker::ApkDecompileWorker(const QString &apk, const QString &folder, const bool smali, const bool resources, const bool java, const QString &frameworkTag, const QString &extraArguments, QObject *parent)
     : QObject(parent), m_Apk(apk), m_Folder(folder), m_Java(java), m_Resources(resources), m_Smali(smali), m_FrameworkTag(frameworkTag), m_ExtraArguments(extraArguments)
@@ -21,10 +26,7 @@ void ApkDecompileWorker::decompile()
         return;
     }
     emit decompileProgress(25, tr("正在运行 apktool..."));
-    QString heap("-Xmx%1m");
-    heap = heap.arg(QString::number(ProcessUtils::javaHeapSize()));
     QStringList args;
-    args << heap << "-jar" << apktool;
     args << "d";
     if (!m_Smali) {
         args << "-s";
@@ -36,12 +38,19 @@ void ApkDecompileWorker::decompile()
         args << "-t" << m_FrameworkTag;
     }
     // 解析并添加额外参数
+    QStringList extraArgs;
     if (!m_ExtraArguments.isEmpty()) {
-        QStringList extraArgs = m_ExtraArguments.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+        extraArgs = m_ExtraArguments.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
         args << extraArgs;
     }
+    // 多 dex 的应用由 apktool 按 CPU 核心数并行反汇编；旧版本不认识 -j，版本未知时不添加
+    const QString version = VersionResolveWorker::cachedVersion("apktool", apktool);
+    if (!extraArgs.contains("-j") && !extraArgs.contains("--jobs")
+            && !version.isEmpty() && (QVersionNumber::fromString(version) >= QVersionNumber(APKTOOL_JOBS_VERSION))) {
+        args << "-j" << QString::number(QThread::idealThreadCount());
+    }
     args << "-o" << m_Folder << m_Apk;
-    ProcessResult result = ProcessUtils::runCommand(java, args);
+    ProcessResult result = ProcessUtils::runJar(apktool, args);
 #ifdef QT_DEBUG
     qDebug() << "Apktool 返回代码" << result.code;
 #endif
@@ -57,7 +66,7 @@ void ApkDecompileWorker::decompile()
             return;
         }
         args.clear();
-        args << "-r" << "-d" << m_Folder << m_Apk;
+        args << "-r" << "-j" << QString::number(QThread::idealThreadCount()) << "-d" << m_Folder << m_Apk;
         result = ProcessUtils::runCommand(jadx, args, PROCESS_TIMEOUT_SECS);
 #ifdef QT_DEBUG
         qDebug() << "Jadx 返回代码" << result.code;
@@ -20,10 +20,7 @@ void ApkRecompileWorker::recompile()
         emit recompileFailed(m_Folder);
         return;
     }
-    QString heap("-Xmx%1m");
-    heap = heap.arg(QString::number(ProcessUtils::javaHeapSize()));
     QStringList args;
-    args << heap << "-jar" << apktool;
     args << "b" << m_Folder;
     // Apktool 2.12.1+ 默认使用 aapt2，仅在需要使用 aapt1 时指定 --use-aapt1
     if (!m_Aapt2) {
@@ -34,7 +31,7 @@ void ApkRecompileWorker::recompile()
         QStringList extraArgs = m_ExtraArguments.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
         args << extraArgs;
     }
-    ProcessResult result = ProcessUtils::runCommand(java, args);
+    ProcessResult result = ProcessUtils::runJar(apktool, args);
 #ifdef QT_DEBUG
     qDebug() << "Apktool 返回代码" << result.code;
 #endif
@@ -19,10 +19,7 @@ void ApkSignWorker::sign()
         emit signFailed(m_Apk);
         return;
     }
-    QString heap("-Xmx%1m");
-    heap = heap.arg(QString::number(ProcessUtils::javaHeapSize()));
     QStringList args;
-    args << heap << "-jar" << uas;
     args << "-a" << m_Apk << "--allowResign" << "--overwrite";
     if (!m_Keystore.isEmpty() && !m_Alias.isEmpty()) {
         args << "--ks" << m_Keystore;
@@ -33,7 +30,7 @@ void ApkSignWorker::sign()
     if (!m_Zipalign) {
         args << "--skipZipAlign";
     }
-    ProcessResult result = ProcessUtils::runCommand(java, args);
+    ProcessResult result = ProcessUtils::runJar(uas, args);
 #ifdef QT_DEBUG
     qDebug() << "Uber APK Signer 返回代码" << result.code;
 #endif
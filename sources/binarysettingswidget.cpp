@@ -32,6 +32,8 @@ QLayout *BinarySettingsWidget::buildForm()
     m_SpinJavaHeap->setMinimum(10);
     m_SpinJavaHeap->setMaximum(65535);
     m_SpinJavaHeap->setSingleStep(1);
+    layout->addRow(tr("常驻 Java 工具进程？"), m_CheckToolHost = new QCheckBox(this));
+    m_CheckToolHost->setToolTip(tr("在后台保持 apktool 和 uber-apk-signer 的 JVM 运行，以省去每次启动的时间（Java 18 及以上版本不支持，将自动改用一次性进程）"));
     layout->addRow(tr("Apktool"), m_EditApktoolJar = new QLineEdit(this));
     child = new QHBoxLayout();
     child->addWidget(button = new QPushButton(tr("浏览..."), this));
@@ -87,6 +89,15 @@ QLayout *BinarySettingsWidget::buildForm()
     }
     m_EditUberApkSignerJar->setText(settings.value("uas_jar").toString());
     m_SpinJavaHeap->setValue(ProcessUtils::javaHeapSize());
+    m_CheckToolHost->setChecked(settings.value("java_tool_host", false).toBool());
+    if (!ProcessUtils::toolHostSupported()) {
+        // 保留用户的选择，换用受支持的 Java 后重新生效
+        const int version = ProcessUtils::javaVersion();
+        m_CheckToolHost->setEnabled(false);
+        m_CheckToolHost->setToolTip((version > 0)
+                                    ? tr("当前使用 Java %1，Java 18 及以上版本不支持常驻工具进程，将使用一次性进程。").arg(version)
+                                    : tr("尚未检测到 Java 版本，将使用一次性进程。"));
+    }
     return layout;
 }
 
@@ -174,6 +185,9 @@ void BinarySettingsWidget::save()
     settings.setValue("jadx_exe", m_EditJadxExe->text());
     settings.setValue("java_exe", m_EditJavaExe->text());
     settings.setValue("java_heap", m_SpinJavaHeap->value());
+    settings.setValue("java_tool_host", m_CheckToolHost->isChecked());
     settings.setValue("uas_jar", m_EditUberApkSignerJar->text());
     settings.sync();
+    ProcessUtils::clearToolCache();
+    ProcessUtils::stopToolHosts();
 }
@@ -13,6 +13,7 @@ public:
     explicit BinarySettingsWidget(QWidget *parent = nullptr);
 private:
     QCheckBox *m_CheckAapt2;
+    QCheckBox *m_CheckToolHost;
     QLineEdit *m_EditAdbExe;
     QLineEdit *m_EditApktoolJar;
     QLineEdit *m_EditJadxExe;
@@ -0,0 +1,36 @@
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include "directoryenumerateworker.h"
+
+#define ENUMERATE_BATCH_SIZE 256
+#define PROJECT_CACHE_DIR ".apkstudio"
+
+DirectoryEnumerateWorker::DirectoryEnumerateWorker(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void DirectoryEnumerateWorker::enumerate(const quint64 request, const QString &folder)
+{
+#ifdef QT_DEBUG
+    qDebug() << "正在枚举" << folder;
+#endif
+    // 只列出当前这一层，子目录在展开时再枚举；分批发出以便树视图边加载边显示
+    QDir dir(folder);
+    const QFileInfoList files = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot, QDir::DirsFirst);
+    QList<DirectoryEntry> entries;
+    entries.reserve(qMin(files.size(), ENUMERATE_BATCH_SIZE));
+    foreach (auto info, files) {
+        if (info.isDir() && (info.fileName() == PROJECT_CACHE_DIR)) {
+            // 索引缓存目录在 Windows 上不是隐藏的，不在项目树中显示
+            continue;
+        }
+        entries.append(DirectoryEntry{info.isDir(), info.fileName()});
+        if (entries.size() >= ENUMERATE_BATCH_SIZE) {
+            emit entriesEnumerated(request, entries, false);
+            entries.clear();
+        }
+    }
+    emit entriesEnumerated(request, entries, true);
+}
@@ -0,0 +1,26 @@
+#ifndef DIRECTORYENUMERATEWORKER_H
+#define DIRECTORYENUMERATEWORKER_H
+
+#include <QList>
+#include <QObject>
+
+struct DirectoryEntry
+{
+    bool dir;
+    QString name;
+};
+
+class DirectoryEnumerateWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit DirectoryEnumerateWorker(QObject *parent = nullptr);
+public slots:
+    void enumerate(const quint64 request, const QString &folder);
+signals:
+    void entriesEnumerated(const quint64 request, const QList<DirectoryEntry> &entries, const bool last);
+};
+
+Q_DECLARE_METATYPE(DirectoryEntry);
+
+#endif // DIRECTORYENUMERATEWORKER_H
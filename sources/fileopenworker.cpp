@@ -0,0 +1,126 @@
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QThread>
+#include "fileopenworker.h"
+#include "themedsyntaxhighlighter.h"
+
+#define INDEX_CHUNK_SIZE (64 * 1024 * 1024)
+#define READ_CHUNK_SIZE (1024 * 1024)
+#ifdef Q_OS_WIN
+#define SAVE_NEWLINE "\r\n"
+#else
+#define SAVE_NEWLINE "\n"
+#endif
+
+FileOpenWorker::FileOpenWorker(const QString &path, const FileType type, QObject *parent)
+    : QObject(parent), m_FilePath(path), m_Type(type)
+{
+}
+
+bool FileOpenWorker::indexLines(TextLineIndex &index) const
+{
+    QFile file(m_FilePath);
+    const qint64 size = file.open(QIODevice::ReadOnly) ? file.size() : -1;
+    const char *data = (size > 0) ? reinterpret_cast<const char *>(file.map(0, size)) : nullptr;
+    if ((size < 0) || ((size > 0) && !data)) {
+        // 无法映射时大小记为 -1，编辑器打开时会报告失败
+        index.size = -1;
+        return !isCancelled();
+    }
+    // 分块扫描换行符，每块之间检查是否已经取消
+    for (qint64 offset = 0; offset < size; offset += INDEX_CHUNK_SIZE) {
+        if (isCancelled()) {
+            return false;
+        }
+        TextPieceTable::indexLines(data + offset, qMin<qint64>(INDEX_CHUNK_SIZE, size - offset), index);
+    }
+    return !isCancelled();
+}
+
+bool FileOpenWorker::isCancelled() const
+{
+    // 标签页在加载完成前关闭时，主窗口通过 QThread::requestInterruption 取消
+    return thread()->isInterruptionRequested();
+}
+
+void FileOpenWorker::open()
+{
+#ifdef QT_DEBUG
+    qDebug() << "正在后台读取" << m_FilePath;
+#endif
+    if (m_Type == Image) {
+        // 图片在这里解码成 QImage，界面线程只需转换成 QPixmap
+        QImageReader reader(m_FilePath);
+        const QImage image = reader.read();
+        if (!isCancelled()) {
+            emit imageOpened(m_FilePath, image);
+        }
+        emit finished();
+        return;
+    }
+    if (m_Type == LargeText) {
+        // 超大文本文件只在这里扫描换行符，编辑器映射文件后直接使用这份索引
+        TextLineIndex index;
+        if (indexLines(index)) {
+            emit largeTextOpened(m_FilePath, index);
+        }
+        emit finished();
+        return;
+    }
+    QByteArray data;
+    if (!readAll(data)) {
+        emit finished();
+        return;
+    }
+    if (m_Type == Binary) {
+        // 记录打开时内容的摘要，改回原样后保存不需要重写文件
+        emit binaryOpened(m_FilePath, data, QCryptographicHash::hash(data, QCryptographicHash::Md5));
+        emit finished();
+        return;
+    }
+    const QString content = QString::fromUtf8(data);
+    data.clear();
+    const QByteArray hash = textHash(content);
+    // 提前编译该语言的高亮规则，界面线程创建高亮器时直接命中缓存
+    ThemedSyntaxHighlighter::definitions(QFileInfo(m_FilePath).suffix().toLower());
+    if (!isCancelled()) {
+        emit textOpened(m_FilePath, content, hash);
+    }
+    emit finished();
+}
+
+bool FileOpenWorker::readAll(QByteArray &data) const
+{
+    QFile file(m_FilePath);
+    const QIODevice::OpenMode mode = (m_Type == Text) ? (QIODevice::ReadOnly | QIODevice::Text) : QIODevice::ReadOnly;
+    if (!file.open(mode)) {
+        // 打不开时仍然交给编辑器，与同步打开时一样显示为空
+        return !isCancelled();
+    }
+    // 分块读取，每块之间检查是否已经取消
+    data.reserve(file.size());
+    QByteArray chunk;
+    while (!(chunk = file.read(READ_CHUNK_SIZE)).isEmpty()) {
+        if (isCancelled()) {
+            return false;
+        }
+        data.append(chunk);
+    }
+    return !isCancelled();
+}
+
+QByteArray FileOpenWorker::textHash(QString content)
+{
+    // 按 SourceCodeEdit::snapshot() 保存时的写法计算摘要：文档把这些字符都当作分段，不换行空格按普通空格保存
+    content.replace(QChar('\r'), QChar('\n'));
+    content.replace(QChar::ParagraphSeparator, QChar('\n'));
+    content.replace(QChar::LineSeparator, QChar('\n'));
+    content.replace(QChar::Nbsp, QChar(' '));
+    if (qstrcmp(SAVE_NEWLINE, "\n") != 0) {
+        content.replace(QChar('\n'), QLatin1String(SAVE_NEWLINE));
+    }
+    return QCryptographicHash::hash(content.toUtf8(), QCryptographicHash::Md5);
+}
@@ -0,0 +1,36 @@
+#ifndef FILEOPENWORKER_H
+#define FILEOPENWORKER_H
+
+#include <QByteArray>
+#include <QImage>
+#include <QObject>
+#include "textpiecetable.h"
+
+class FileOpenWorker : public QObject
+{
+    Q_OBJECT
+public:
+    enum FileType {
+        Binary,
+        Image,
+        LargeText,
+        Text
+    };
+    explicit FileOpenWorker(const QString &path, const FileType type, QObject *parent = nullptr);
+    void open();
+private:
+    QString m_FilePath;
+    FileType m_Type;
+    bool indexLines(TextLineIndex &index) const;
+    bool isCancelled() const;
+    bool readAll(QByteArray &data) const;
+    static QByteArray textHash(QString content);
+signals:
+    void binaryOpened(const QString &path, const QByteArray &data, const QByteArray &hash);
+    void finished();
+    void imageOpened(const QString &path, const QImage &image);
+    void largeTextOpened(const QString &path, const TextLineIndex &index);
+    void textOpened(const QString &path, const QString &content, const QByteArray &hash);
+};
+
+#endif // FILEOPENWORKER_H
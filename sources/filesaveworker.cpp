@@ -0,0 +1,32 @@
+#include <QDebug>
+#include <QSaveFile>
+#include "filesaveworker.h"
+
+FileSaveWorker::FileSaveWorker(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void FileSaveWorker::save(const QString &path, const QList<QByteArray> &chunks, const QByteArray &hash)
+{
+#ifdef QT_DEBUG
+    qDebug() << "正在后台保存" << path;
+#endif
+    emit fileSaved(path, hash, write(path, chunks));
+}
+
+bool FileSaveWorker::write(const QString &path, const QList<QByteArray> &chunks)
+{
+    // 先逐块写入临时文件，全部成功后再替换原文件，中途失败不会损坏原文件
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    foreach (const QByteArray &chunk, chunks) {
+        if (file.write(chunk) != chunk.size()) {
+            file.cancelWriting();
+            return false;
+        }
+    }
+    return file.commit();
+}
@@ -0,0 +1,20 @@
+#ifndef FILESAVEWORKER_H
+#define FILESAVEWORKER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+
+class FileSaveWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileSaveWorker(QObject *parent = nullptr);
+    static bool write(const QString &path, const QList<QByteArray> &chunks);
+public slots:
+    void save(const QString &path, const QList<QByteArray> &chunks, const QByteArray &hash);
+signals:
+    void fileSaved(const QString &path, const QByteArray &hash, const bool success);
+};
+
+#endif // FILESAVEWORKER_H
@@ -22,14 +22,14 @@
 #include <QTextCharFormat>
 #include <QTextCursor>
 #include <QTextStream>
-#include <QTimer>
 #include <QVBoxLayout>
 #include "findinfilesdialog.h"
+#include "largetextedit.h"
 #include "mainwindow.h"
 #include "sourcecodeedit.h"
 
 FindInFilesDialog::FindInFilesDialog(MainWindow *parent)
-    : QDialog(parent), m_MainWindow(parent), m_SearchRoot()
+    : QDialog(parent), m_MainWindow(parent), m_SearchRoot(), m_MatchedFiles(0)
 {
     setWindowTitle(tr("在文件中查找"));
     setMinimumSize(512, 384);
@@ -58,9 +58,9 @@ void FindInFilesDialog::buildUI()
     m_EditSearch->setPlaceholderText(tr("请输入搜索关键词..."));
     searchLayout->addWidget(m_EditSearch);
     
-    auto searchButton = new QPushButton(tr("搜索"), this);
-    connect(searchButton, &QPushButton::clicked, this, &FindInFilesDialog::handleSearch);
-    searchLayout->addWidget(searchButton);
+    m_ButtonSearch = new QPushButton(tr("搜索"), this);
+    connect(m_ButtonSearch, &QPushButton::clicked, this, &FindInFilesDialog::handleSearch);
+    searchLayout->addWidget(m_ButtonSearch);
     mainLayout->addLayout(searchLayout);
     
     // 选项组
@@ -100,7 +100,7 @@ void FindInFilesDialog::buildUI()
     m_ProgressBar = new QProgressBar(this);
     m_ProgressBar->setVisible(false);
     m_ProgressBar->setMinimum(0);
-    m_ProgressBar->setMaximum(0); // 不确定进度
+    m_ProgressBar->setMaximum(0); // 枚举到文件之前为不确定进度
     m_ProgressBar->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Maximum);
     mainLayout->addWidget(m_ProgressBar);
     
@@ -122,132 +122,6 @@ void FindInFilesDialog::setSearchRoot(const QString &rootPath)
     m_SearchRoot = rootPath;
 }
 
-QStringList FindInFilesDialog::getTextFileExtensions()
-{
-    // 匹配 MainWindow 中使用的扩展名
-    return QStringList() << "java" << "html" << "properties" << "smali" 
-                        << "txt" << "xml" << "yaml" << "yml" << "cpp" 
-                        << "h" << "c" << "hpp" << "cc" << "cxx" << "js" 
-                        << "ts" << "json" << "css" << "md" << "sh" << "bat" 
-                        << "cmake" << "py" << "gradle" << "kt" << "pro" 
-                        << "pri" << "qrc" << "ui" << "qml";
-}
-
-bool FindInFilesDialog::isTextFile(const QString &filePath)
-{
-    QFileInfo info(filePath);
-    QString extension = info.suffix().toLower();
-    return getTextFileExtensions().contains(extension);
-}
-
-void FindInFilesDialog::scanDirectory(const QString &dirPath, const QString &searchTerm,
-                                     bool caseSensitive, bool wholeWords, bool useRegexp)
-{
-    QDir dir(dirPath);
-    if (!dir.exists()) {
-        return;
-    }
-    
-    QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, 
-                                              QDir::Name | QDir::DirsFirst);
-    
-    for (const QFileInfo &info : entries) {
-        if (info.isDir()) {
-            // 递归扫描子目录
-            scanDirectory(info.absoluteFilePath(), searchTerm, caseSensitive, wholeWords, useRegexp);
-        } else if (info.isFile() && isTextFile(info.absoluteFilePath())) {
-            // 在文本文件中搜索
-            QFile file(info.absoluteFilePath());
-            if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-                continue;
-            }
-            
-            QTextStream in(&file);
-            in.setEncoding(QStringConverter::Utf8);
-            int lineNumber = 1;
-            
-            QRegularExpression regex;
-            if (useRegexp) {
-                QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
-                if (!caseSensitive) {
-                    options |= QRegularExpression::CaseInsensitiveOption;
-                }
-                regex = QRegularExpression(searchTerm, options);
-                if (!regex.isValid()) {
-                    continue;
-                }
-            }
-            
-            while (!in.atEnd()) {
-                QString line = in.readLine();
-                bool found = false;
-                int matchStart = -1;
-                int matchLength = 0;
-                
-                if (useRegexp) {
-                    QRegularExpressionMatch match = regex.match(line);
-                    if (match.hasMatch()) {
-                        found = true;
-                        matchStart = match.capturedStart();
-                        matchLength = match.capturedLength();
-                    }
-                } else {
-                    QString searchText = searchTerm;
-                    QString lineText = line;
-                    
-                    if (!caseSensitive) {
-                        searchText = searchText.toLower();
-                        lineText = lineText.toLower();
-                    }
-                    
-                    int pos = lineText.indexOf(searchText);
-                    if (pos >= 0) {
-                        if (wholeWords) {
-                            // 检查是否为全词匹配
-                            bool isWholeWord = true;
-                            if (pos > 0) {
-                                QChar prev = line.at(pos - 1);
-                                if (prev.isLetterOrNumber() || prev == '_') {
-                                    isWholeWord = false;
-                                }
-                            }
-                            if (pos + searchText.length() < line.length()) {
-                                QChar next = line.at(pos + searchText.length());
-                                if (next.isLetterOrNumber() || next == '_') {
-                                    isWholeWord = false;
-                                }
-                            }
-                            if (!isWholeWord) {
-                                pos = -1;
-                            }
-                        }
-                        
-                        if (pos >= 0) {
-                            found = true;
-                            matchStart = pos;
-                            matchLength = searchTerm.length();
-                        }
-                    }
-                }
-                
-                if (found) {
-                    SearchMatch match;
-                    match.filePath = info.absoluteFilePath();
-                    match.lineNumber = lineNumber;
-                    match.lineText = line;
-                    match.matchStart = matchStart;
-                    match.matchLength = matchLength;
-                    m_Matches.append(match);
-                }
-                
-                lineNumber++;
-            }
-            
-            file.close();
-        }
-    }
-}
-
 void FindInFilesDialog::performSearch()
 {
     QString searchTerm = m_EditSearch->text().trimmed();
@@ -261,14 +135,6 @@ void FindInFilesDialog::performSearch()
         return;
     }
     
-    m_Matches.clear();
-    m_ResultsList->clear();
-    m_PreviewText->clear();
-    
-    m_ProgressBar->setVisible(true);
-    m_LabelStatus->setText(tr("正在搜索..."));
-    QApplication::processEvents();
-    
     bool caseSensitive = m_CheckCase->isChecked();
     bool wholeWords = m_CheckWhole->isChecked();
     bool useRegexp = m_CheckRegexp->isChecked();
@@ -277,79 +143,152 @@ void FindInFilesDialog::performSearch()
         QRegularExpression testRegex(searchTerm);
         if (!testRegex.isValid()) {
             m_LabelStatus->setText(tr("无效的正则表达式：%1").arg(testRegex.errorString()));
-            m_ProgressBar->setVisible(false);
             return;
         }
     }
     
-    scanDirectory(m_SearchRoot, searchTerm, caseSensitive, wholeWords, useRegexp);
+    m_Matches.clear();
+    m_MatchedFiles = 0;
+    m_ResultsList->clear();
+    m_PreviewText->clear();
     
-    m_ProgressBar->setVisible(false);
-    updateResults();
+    m_ProgressBar->setMaximum(0);
+    m_ProgressBar->setValue(0);
+    m_ProgressBar->setVisible(true);
+    m_ButtonSearch->setText(tr("停止"));
+    m_LabelStatus->setText(tr("正在搜索..."));
+    
+    // 在后台线程中枚举文件并由线程池扫描，结果分批返回
+    auto thread = new QThread();
+    auto worker = new FindInFilesWorker(m_SearchRoot, searchTerm, caseSensitive, wholeWords, useRegexp);
+    worker->moveToThread(thread);
+    connect(thread, &QThread::started, worker, &FindInFilesWorker::search);
+    connect(worker, &FindInFilesWorker::finished, thread, &QThread::quit);
+    connect(worker, &FindInFilesWorker::matchesFound, this, &FindInFilesDialog::appendResults);
+    connect(worker, &FindInFilesWorker::searchFinished, this, &FindInFilesDialog::handleSearchFinished);
+    connect(worker, &FindInFilesWorker::searchProgress, this, &FindInFilesDialog::handleSearchProgress);
+    connect(worker, &FindInFilesWorker::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    m_SearchThread = thread;
+    thread->start();
 }
 
-void FindInFilesDialog::updateResults()
+void FindInFilesDialog::appendFileResults(const QList<SearchMatch> &matches)
 {
-    m_ResultsList->clear();
-    
-    int matchCount = m_Matches.size();
-    if (matchCount == 0) {
-        m_LabelStatus->setText(tr("未找到匹配项。"));
-        return;
-    }
-    
-    // 按文件分组匹配结果
-    QMap<QString, QList<SearchMatch>> fileMatches;
-    for (const SearchMatch &match : m_Matches) {
-        fileMatches[match.filePath].append(match);
+    const QString relativePath = QDir(m_SearchRoot).relativeFilePath(matches.first().filePath);
+
+    // 文件头项目
+    auto headerItem = new QListWidgetItem(QString("%1（%2 个匹配）").arg(relativePath).arg(matches.size()));
+    headerItem->setData(Qt::UserRole, QVariant::fromValue<QString>(QString())); // 空字符串表示这是标题
+    QFont headerFont = headerItem->font();
+    headerFont.setBold(true);
+    headerItem->setFont(headerFont);
+    // 使用适应当前主题的调色板颜色（浅色模式下为 AlternateBase，深色模式下为深灰色）
+    headerItem->setBackground(QBrush(palette().color(QPalette::AlternateBase)));
+    headerItem->setForeground(QBrush(palette().color(QPalette::Text)));
+    m_ResultsList->addItem(headerItem);
+
+    // 匹配项
+    foreach (const SearchMatch &match, matches) {
+        QString displayText = QString("  %1：%2").arg(match.lineNumber).arg(match.lineText.trimmed());
+        if (displayText.length() > 100) {
+            displayText = displayText.left(100) + "...";
+        }
+        auto item = new QListWidgetItem(displayText);
+        item->setData(Qt::UserRole, QVariant::fromValue<SearchMatch>(match));
+        // 使用中性样式 - Base 背景和 Text 前景色，正常字体粗细
+        item->setBackground(QBrush(palette().color(QPalette::Base)));
+        item->setForeground(QBrush(palette().color(QPalette::Text)));
+        QFont itemFont = item->font();
+        itemFont.setBold(false);
+        item->setFont(itemFont);
+        m_ResultsList->addItem(item);
     }
-    
-    // 将项目添加到列表
-    for (auto it = fileMatches.begin(); it != fileMatches.end(); ++it) {
-        QString filePath = it.key();
-        QFileInfo fileInfo(filePath);
-        QString fileName = fileInfo.fileName();
-        QString relativePath = QDir(m_SearchRoot).relativeFilePath(filePath);
-        
-        // 文件头项目
-        auto headerItem = new QListWidgetItem(QString("%1（%2 个匹配）").arg(relativePath).arg(it.value().size()));
-        headerItem->setData(Qt::UserRole, QVariant::fromValue<QString>(QString())); // 空字符串表示这是标题
-        QFont headerFont = headerItem->font();
-        headerFont.setBold(true);
-        headerItem->setFont(headerFont);
-        // 使用适应当前主题的调色板颜色（浅色模式下为 AlternateBase，深色模式下为深灰色）
-        headerItem->setBackground(QBrush(palette().color(QPalette::AlternateBase)));
-        headerItem->setForeground(QBrush(palette().color(QPalette::Text)));
-        m_ResultsList->addItem(headerItem);
-        
-        // 匹配项
-        for (const SearchMatch &match : it.value()) {
-            QString displayText = QString("  %1：%2").arg(match.lineNumber).arg(match.lineText.trimmed());
-            if (displayText.length() > 100) {
-                displayText = displayText.left(100) + "...";
-            }
-            auto item = new QListWidgetItem(displayText);
-            item->setData(Qt::UserRole, QVariant::fromValue<SearchMatch>(match));
-            // 使用中性样式 - Base 背景和 Text 前景色，正常字体粗细
-            item->setBackground(QBrush(palette().color(QPalette::Base)));
-            item->setForeground(QBrush(palette().color(QPalette::Text)));
-            QFont itemFont = item->font();
-            itemFont.setBold(false);
-            item->setFont(itemFont);
-            m_ResultsList->addItem(item);
+}
+
+void FindInFilesDialog::appendResults(const QList<SearchMatch> &matches)
+{
+    // 同一文件的匹配项总是在同一批结果中连续到达
+    int first = 0;
+    while (first < matches.size()) {
+        const QString filePath = matches.at(first).filePath;
+        int last = first;
+        while ((last < matches.size()) && (matches.at(last).filePath == filePath)) {
+            last++;
         }
+        appendFileResults(matches.mid(first, last - first));
+        m_MatchedFiles++;
+        first = last;
     }
-    
-    m_LabelStatus->setText(tr("找到 %1 个匹配项，分布在 %2 个文件中")
-                          .arg(matchCount)
-                          .arg(fileMatches.size()));
+    m_Matches.append(matches);
+}
+
+void FindInFilesDialog::handleSearchFinished(const int scanned, const bool cancelled, const bool limited)
+{
+    m_SearchThread = nullptr;
+    sortResults();
+    m_ProgressBar->setVisible(false);
+    m_ButtonSearch->setText(tr("搜索"));
+    QString status;
+    if (m_Matches.isEmpty()) {
+        status = tr("未找到匹配项。");
+    } else {
+        status = tr("找到 %1 个匹配项，分布在 %2 个文件中")
+                .arg(m_Matches.size())
+                .arg(m_MatchedFiles);
+    }
+    if (limited) {
+        status = tr("匹配项超过 %1 个，搜索已提前结束（已扫描 %2 个文件）。").arg(SEARCH_MAX_MATCHES).arg(scanned) + status;
+    } else if (cancelled) {
+        status = tr("搜索已停止（已扫描 %1 个文件）。").arg(scanned) + status;
+    }
+    m_LabelStatus->setText(status);
+}
+
+void FindInFilesDialog::handleSearchProgress(const int scanned, const int total)
+{
+    // 多个扫描线程的进度可能乱序到达
+    m_ProgressBar->setMaximum(total);
+    m_ProgressBar->setValue(qMax(m_ProgressBar->value(), scanned));
+    m_LabelStatus->setText(tr("正在搜索...已扫描 %1 / %2 个文件，找到 %3 个匹配项")
+                          .arg(m_ProgressBar->value())
+                          .arg(total)
+                          .arg(m_Matches.size()));
 }
 
 void FindInFilesDialog::handleSearch()
 {
+    // 搜索进行中时按钮用于停止
+    if (m_SearchThread) {
+        m_SearchThread->requestInterruption();
+        return;
+    }
     performSearch();
 }
 
+void FindInFilesDialog::sortResults()
+{
+    // 扫描线程的结果按完成的先后到达，结束后按路径重新排列，每次搜索的输出顺序一致
+    QMap<QString, QList<SearchMatch>> groups;
+    foreach (const SearchMatch &match, m_Matches) {
+        groups[match.filePath].append(match);
+    }
+    m_ResultsList->setUpdatesEnabled(false);
+    m_ResultsList->clear();
+    foreach (const QList<SearchMatch> &matches, groups) {
+        appendFileResults(matches);
+    }
+    m_ResultsList->setUpdatesEnabled(true);
+}
+
+void FindInFilesDialog::reject()
+{
+    if (m_SearchThread) {
+        m_SearchThread->requestInterruption();
+    }
+    QDialog::reject();
+}
+
 void FindInFilesDialog::handleResultSelectionChanged()
 {
     auto item = m_ResultsList->currentItem();
@@ -422,26 +361,37 @@ void FindInFilesDialog::onResultClicked(QListWidgetItem *item)
         // 先打开文件
         m_MainWindow->openFile(match.filePath);
         
-        // 稍等片刻让文件打开，然后跳转到对应行
-        QTimer::singleShot(100, [this, match]() {
-            auto widget = m_MainWindow->findTabWidget(match.filePath);
-            if (widget) {
-                auto edit = dynamic_cast<SourceCodeEdit *>(widget);
-                if (edit) {
-                    edit->gotoLine(match.lineNumber);
-                    
-                    // 高亮匹配的文本
-                    QTextCursor cursor = edit->textCursor();
-                    QTextBlock block = edit->document()->findBlockByLineNumber(match.lineNumber - 1);
-                    if (block.isValid()) {
-                        cursor.setPosition(block.position() + match.matchStart);
-                        cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor, match.matchLength);
-                        edit->setTextCursor(cursor);
-                        edit->ensureCursorVisible();
-                    }
+        // 标签页立即出现，文本内容在后台读取完成后再跳转到对应行
+        auto widget = m_MainWindow->findTabWidget(match.filePath);
+        auto edit = dynamic_cast<SourceCodeEdit *>(widget);
+        if (edit) {
+            auto select = [edit, match]() {
+                edit->gotoLine(match.lineNumber);
+                
+                // 高亮匹配的文本
+                QTextCursor cursor = edit->textCursor();
+                QTextBlock block = edit->document()->findBlockByLineNumber(match.lineNumber - 1);
+                if (block.isValid()) {
+                    cursor.setPosition(block.position() + match.matchStart);
+                    cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor, match.matchLength);
+                    edit->setTextCursor(cursor);
+                    edit->ensureCursorVisible();
                 }
+            };
+            if (edit->isLoading()) {
+                connect(edit, &SourceCodeEdit::loaded, edit, select, Qt::SingleShotConnection);
+            } else {
+                select();
             }
-        });
+        } else if (auto large = dynamic_cast<LargeTextEdit *>(widget)) {
+            large->gotoLine(match.lineNumber);
+        }
     }
 }
 
+FindInFilesDialog::~FindInFilesDialog()
+{
+    if (m_SearchThread) {
+        m_SearchThread->requestInterruption();
+    }
+}
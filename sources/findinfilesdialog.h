@@ -8,39 +8,32 @@
 #include <QLineEdit>
 #include <QListWidget>
 #include <QMainWindow>
+#include <QPointer>
 #include <QProgressBar>
+#include <QPushButton>
 #include <QSplitter>
 #include <QTextEdit>
-#include <QTreeWidget>
+#include <QThread>
+#include "findinfilesworker.h"
 
 class MainWindow;
 
-struct SearchMatch {
-    QString filePath;
-    int lineNumber;
-    QString lineText;
-    int matchStart;
-    int matchLength;
-    
-    bool operator==(const SearchMatch &other) const {
-        return filePath == other.filePath && lineNumber == other.lineNumber;
-    }
-};
-
-Q_DECLARE_METATYPE(SearchMatch)
-
 class FindInFilesDialog : public QDialog
 {
     Q_OBJECT
 public:
     explicit FindInFilesDialog(MainWindow *parent = nullptr);
+    ~FindInFilesDialog();
     void setSearchRoot(const QString &rootPath);
+public slots:
+    void reject() override;
 private:
     MainWindow *m_MainWindow;
     QLineEdit *m_EditSearch;
     QCheckBox *m_CheckCase;
     QCheckBox *m_CheckWhole;
     QCheckBox *m_CheckRegexp;
+    QPushButton *m_ButtonSearch;
     QListWidget *m_ResultsList;
     QTextEdit *m_PreviewText;
     QLabel *m_LabelStatus;
@@ -48,18 +41,20 @@ private:
     QSplitter *m_Splitter;
     QString m_SearchRoot;
     QList<SearchMatch> m_Matches;
+    int m_MatchedFiles;
+    QPointer<QThread> m_SearchThread;
     
     void buildUI();
     void performSearch();
-    void updateResults();
+    void appendResults(const QList<SearchMatch> &matches);
+    void appendFileResults(const QList<SearchMatch> &matches);
+    void sortResults();
     void onResultClicked(QListWidgetItem *item);
-    void scanDirectory(const QString &dirPath, const QString &searchTerm, 
-                      bool caseSensitive, bool wholeWords, bool useRegexp);
-    bool isTextFile(const QString &filePath);
-    QStringList getTextFileExtensions();
     void highlightMatchInPreview(const QString &text, int matchStart, int matchLength);
 private slots:
     void handleSearch();
+    void handleSearchFinished(const int scanned, const bool cancelled, const bool limited);
+    void handleSearchProgress(const int scanned, const int total);
     void handleResultSelectionChanged();
 };
 
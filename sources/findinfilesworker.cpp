@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <cstring>
+#include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include "findinfilesworker.h"
+#include "trigramindex.h"
+
+#define PROJECT_CACHE_DIR ".apkstudio"
+#define SEARCH_BATCH_SIZE 32
+
+static bool isWordChar(const QChar c)
+{
+    return c.isLetterOrNumber() || (c == '_');
+}
+
+FindInFilesWorker::FindInFilesWorker(const QString &folder, const QString &term, const bool caseSensitive, const bool wholeWords, const bool regexp, QObject *parent)
+    : QObject(parent), m_ByteSearch(false), m_CaseSensitive(caseSensitive), m_Folder(QDir::cleanPath(folder)), m_Found(0), m_Limited(false), m_Scanned(0), m_Term(term), m_Total(0), m_UseRegexp(regexp), m_WholeWords(wholeWords)
+{
+    if (!regexp) {
+        // 普通文本直接在 UTF-8 字节上查找；忽略大小写时只能折叠 ASCII，关键词含非 ASCII 字符则按行解码查找
+        m_Needle = term.toUtf8();
+        const bool ascii = std::all_of(m_Needle.cbegin(), m_Needle.cend(), [](const char c) {
+            return uchar(c) < 0x80;
+        });
+        m_ByteSearch = caseSensitive || ascii;
+        if (m_ByteSearch && !caseSensitive) {
+            m_Needle = m_Needle.toLower();
+            // Horspool 跳转表，按折叠后的字节索引
+            const uchar *fold = TrigramIndex::foldTable();
+            m_Skip.fill(m_Needle.size());
+            for (int i = 0; i < m_Needle.size() - 1; ++i) {
+                m_Skip[fold[uchar(m_Needle.at(i))]] = m_Needle.size() - 1 - i;
+            }
+        }
+    }
+    if (regexp) {
+        // 只编译一次，由所有扫描线程共享
+        QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+        if (!caseSensitive) {
+            options |= QRegularExpression::CaseInsensitiveOption;
+        }
+        m_Regexp = QRegularExpression(term, options);
+        m_Regexp.optimize();
+    }
+}
+
+const char *FindInFilesWorker::findNeedle(const char *begin, const char *end) const
+{
+    const int length = m_Needle.size();
+    const char *needle = m_Needle.constData();
+    if (m_CaseSensitive) {
+        // 用 memchr 定位首字节（C 库中为向量化实现），再比较其余字节
+        const char *p = begin;
+        while ((end - p) >= length) {
+            p = static_cast<const char *>(memchr(p, needle[0], (end - p) - length + 1));
+            if (!p) {
+                return nullptr;
+            }
+            if (memcmp(p + 1, needle + 1, length - 1) == 0) {
+                return p;
+            }
+            p++;
+        }
+        return nullptr;
+    }
+    // 忽略大小写时使用 Horspool 算法，比较时即时折叠
+    const uchar *fold = TrigramIndex::foldTable();
+    const uchar last = uchar(needle[length - 1]);
+    const uchar *p = reinterpret_cast<const uchar *>(begin);
+    const uchar *stop = reinterpret_cast<const uchar *>(end) - length;
+    while (p <= stop) {
+        const uchar c = fold[p[length - 1]];
+        if (c == last) {
+            int i = 0;
+            while ((i < length - 1) && (fold[p[i]] == uchar(needle[i]))) {
+                i++;
+            }
+            if (i == length - 1) {
+                return reinterpret_cast<const char *>(p);
+            }
+        }
+        p += m_Skip[c];
+    }
+    return nullptr;
+}
+
+bool FindInFilesWorker::indexedCandidates(QStringList &files) const
+{
+    // 直接用已经建立的三元组索引回答查询，索引由打开项目时的后台任务更新，这里不再遍历整个项目
+    TrigramIndex index(m_Folder);
+    if (!index.load()) {
+        return false;
+    }
+    QStringList candidates = index.candidates(m_Needle);
+    // 索引更新之后保存过的文件可能包含新的匹配，也一并扫描
+    QSet<QString> seen(candidates.cbegin(), candidates.cend());
+    foreach (const QString &path, TrigramIndex::dirtyFiles(m_Folder)) {
+        if (!seen.contains(path)) {
+            seen.insert(path);
+            candidates.append(path);
+        }
+    }
+    // 只检查入选的文件是否仍然存在，内容在扫描时核对
+    foreach (const QString &path, candidates) {
+        if (isCancelled()) {
+            return true;
+        }
+        if (QFileInfo(path).isFile()) {
+            files.append(path);
+        }
+    }
+    return true;
+}
+
+bool FindInFilesWorker::isCancelled() const
+{
+    // 由对话框通过 QThread::requestInterruption 请求停止，扫描线程也可以安全读取
+    return thread()->isInterruptionRequested();
+}
+
+bool FindInFilesWorker::isTextFile(const QString &name)
+{
+    // 匹配 MainWindow 中使用的扩展名
+    static const QSet<QString> extensions = {
+        "java", "html", "properties", "smali",
+        "txt", "xml", "yaml", "yml", "cpp",
+        "h", "c", "hpp", "cc", "cxx", "js",
+        "ts", "json", "css", "md", "sh", "bat",
+        "cmake", "py", "gradle", "kt", "pro",
+        "pri", "qrc", "ui", "qml"
+    };
+    const int dot = name.lastIndexOf('.');
+    return (dot >= 0) && extensions.contains(name.mid(dot + 1).toLower());
+}
+
+bool FindInFilesWorker::isWholeWord(const char *begin, const char *end, const char *first, const char *last)
+{
+    // 检查是否为全词匹配，边界上的非 ASCII 字符需要解码后判断
+    if (first > begin) {
+        const char *p = first - 1;
+        while ((p > begin) && ((uchar(*p) & 0xC0) == 0x80)) {
+            p--;
+        }
+        const QString prev = (uchar(*p) < 0x80) ? QString(QChar(*p)) : QString::fromUtf8(p, first - p);
+        if (!prev.isEmpty() && isWordChar(prev.at(prev.size() - 1))) {
+            return false;
+        }
+    }
+    if (last < end) {
+        const uchar lead = uchar(*last);
+        const int size = (lead < 0x80) ? 1 : ((lead >= 0xF0) ? 4 : ((lead >= 0xE0) ? 3 : 2));
+        const QString next = QString::fromUtf8(last, qMin<qint64>(size, end - last));
+        if (!next.isEmpty() && isWordChar(next.at(0))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FindInFilesWorker::matchLine(const QString &line, int &start, int &length) const
+{
+    if (m_UseRegexp) {
+        QRegularExpressionMatch match = m_Regexp.match(line);
+        if (!match.hasMatch()) {
+            return false;
+        }
+        start = match.capturedStart();
+        length = match.capturedLength();
+        return true;
+    }
+    const int pos = line.indexOf(m_Term, 0, m_CaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    if (pos < 0) {
+        return false;
+    }
+    if (m_WholeWords) {
+        // 检查是否为全词匹配
+        if (pos > 0) {
+            QChar prev = line.at(pos - 1);
+            if (prev.isLetterOrNumber() || prev == '_') {
+                return false;
+            }
+        }
+        if (pos + m_Term.length() < line.length()) {
+            QChar next = line.at(pos + m_Term.length());
+            if (next.isLetterOrNumber() || next == '_') {
+                return false;
+            }
+        }
+    }
+    start = pos;
+    length = m_Term.length();
+    return true;
+}
+
+QList<SearchMatch> FindInFilesWorker::scanBytes(const QString &path) const
+{
+    QList<SearchMatch> matches;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || (file.size() == 0)) {
+        return matches;
+    }
+    // 优先映射文件，映射失败时再读入内存
+    QByteArray buffer;
+    qint64 size = file.size();
+    const char *data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data) {
+        buffer = file.readAll();
+        data = buffer.constData();
+        size = buffer.size();
+    }
+    const char *begin = data;
+    const char *end = data + size;
+    if ((size >= 3) && (memcmp(begin, "\xEF\xBB\xBF", 3) == 0)) {
+        begin += 3;
+    }
+    const char *counted = begin;
+    int lineNumber = 1;
+    const char *from = begin;
+    const char *hit;
+    while ((hit = findNeedle(from, end))) {
+        if (m_WholeWords && !isWholeWord(begin, end, hit, hit + m_Needle.size())) {
+            from = hit + 1;
+            continue;
+        }
+        // 只有命中的文件才统计行号，并且只统计到命中位置
+        lineNumber += std::count(counted, hit, '\n');
+        counted = hit;
+        const char *lineStart = hit;
+        while ((lineStart > begin) && (lineStart[-1] != '\n')) {
+            lineStart--;
+        }
+        const char *lineEnd = static_cast<const char *>(memchr(hit, '\n', end - hit));
+        if (!lineEnd) {
+            lineEnd = end;
+        }
+        const char *textEnd = lineEnd;
+        if ((textEnd > lineStart) && (textEnd[-1] == '\r')) {
+            textEnd--;
+        }
+        SearchMatch match;
+        match.filePath = path;
+        match.lineNumber = lineNumber;
+        match.lineText = QString::fromUtf8(lineStart, textEnd - lineStart);
+        match.matchStart = QString::fromUtf8(lineStart, hit - lineStart).size();
+        match.matchLength = QString::fromUtf8(hit, m_Needle.size()).size();
+        matches.append(match);
+        // 与按行查找一致，每行只报告第一个匹配
+        if (lineEnd == end) {
+            break;
+        }
+        from = lineEnd + 1;
+    }
+    return matches;
+}
+
+QList<SearchMatch> FindInFilesWorker::scanFile(const QString &path) const
+{
+    if (m_ByteSearch) {
+        return scanBytes(path);
+    }
+    QList<SearchMatch> matches;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return matches;
+    }
+    const QString content = QString::fromUtf8(file.readAll());
+    file.close();
+    int lineNumber = 1;
+    int begin = 0;
+    while (begin < content.size()) {
+        int end = content.indexOf('\n', begin);
+        if (end < 0) {
+            end = content.size();
+        }
+        int length = end - begin;
+        if ((length > 0) && (content.at(end - 1) == '\r')) {
+            length--;
+        }
+        const QString line = content.mid(begin, length);
+        int start;
+        int size;
+        if (matchLine(line, start, size)) {
+            matches.append(SearchMatch{path, lineNumber, line, start, size});
+        }
+        begin = end + 1;
+        lineNumber++;
+    }
+    return matches;
+}
+
+void FindInFilesWorker::scanFiles(const QStringList &files)
+{
+    QList<SearchMatch> matches;
+    int scanned = 0;
+    foreach (auto path, files) {
+        if (isCancelled()) {
+            break;
+        }
+        matches.append(scanFile(path));
+        scanned++;
+    }
+    if (!matches.isEmpty()) {
+        emit matchesFound(matches);
+        if (m_Found.fetchAndAddRelaxed(matches.size()) + matches.size() >= SEARCH_MAX_MATCHES) {
+            // 结果过多时停止，避免结果列表拖慢界面；与用户取消区分开
+            m_Limited.storeRelaxed(true);
+            thread()->requestInterruption();
+        }
+    }
+    emit searchProgress(m_Scanned.fetchAndAddRelaxed(scanned) + scanned, m_Total.loadRelaxed());
+}
+
+void FindInFilesWorker::search()
+{
+    emit started();
+#ifdef QT_DEBUG
+    QElapsedTimer timer;
+    timer.start();
+#endif
+    // 当前线程只负责准备文件列表，文件内容分批交给线程池扫描
+    QThreadPool pool;
+    QStringList batch;
+    auto dispatch = [this, &pool, &batch](const bool flush) {
+        if (!batch.isEmpty() && (flush || (batch.size() >= SEARCH_BATCH_SIZE))) {
+            pool.start([this, files = batch] {
+                scanFiles(files);
+            });
+            batch.clear();
+        }
+    };
+    QStringList candidates;
+    if (m_ByteSearch && (m_Needle.size() >= 3) && indexedCandidates(candidates)) {
+        // 普通文本可以借助三元组索引缩小范围；正则表达式无法从中提取三元组，没有索引时也全部扫描
+        foreach (auto path, candidates) {
+            if (isCancelled()) {
+                break;
+            }
+            batch.append(path);
+            m_Total.fetchAndAddRelaxed(1);
+            dispatch(false);
+        }
+    } else {
+        QDirIterator it(m_Folder, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext() && !isCancelled()) {
+            const QString path = it.next();
+            // 跳过索引缓存目录中的文件
+            if (!isTextFile(it.fileName()) || path.contains(QLatin1String("/" PROJECT_CACHE_DIR "/"))) {
+                continue;
+            }
+            batch.append(path);
+            m_Total.fetchAndAddRelaxed(1);
+            dispatch(false);
+        }
+    }
+    if (!isCancelled()) {
+        dispatch(true);
+    }
+    emit searchProgress(m_Scanned.loadRelaxed(), m_Total.loadRelaxed());
+    pool.waitForDone();
+#ifdef QT_DEBUG
+    qDebug() << "搜索完成，扫描了" << m_Scanned.loadRelaxed() << "个文件，用时" << timer.elapsed() << "毫秒";
+#endif
+    const bool limited = m_Limited.loadRelaxed();
+    emit searchFinished(m_Scanned.loadRelaxed(), isCancelled() && !limited, limited);
+    emit finished();
+}
@@ -0,0 +1,64 @@
+#ifndef FINDINFILESWORKER_H
+#define FINDINFILESWORKER_H
+
+#include <array>
+#include <QAtomicInteger>
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QRegularExpression>
+
+#define SEARCH_MAX_MATCHES 20000
+
+struct SearchMatch {
+    QString filePath;
+    int lineNumber;
+    QString lineText;
+    int matchStart;
+    int matchLength;
+    
+    bool operator==(const SearchMatch &other) const {
+        return filePath == other.filePath && lineNumber == other.lineNumber;
+    }
+};
+
+Q_DECLARE_METATYPE(SearchMatch)
+
+class FindInFilesWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FindInFilesWorker(const QString &folder, const QString &term, const bool caseSensitive, const bool wholeWords, const bool regexp, QObject *parent = nullptr);
+    static bool isTextFile(const QString &name);
+    void search();
+private:
+    bool m_ByteSearch;
+    bool m_CaseSensitive;
+    QString m_Folder;
+    QAtomicInteger<int> m_Found;
+    QAtomicInteger<bool> m_Limited;
+    QByteArray m_Needle;
+    QRegularExpression m_Regexp;
+    QAtomicInteger<int> m_Scanned;
+    std::array<int, 256> m_Skip;
+    QString m_Term;
+    QAtomicInteger<int> m_Total;
+    bool m_UseRegexp;
+    bool m_WholeWords;
+    const char *findNeedle(const char *begin, const char *end) const;
+    bool indexedCandidates(QStringList &files) const;
+    bool isCancelled() const;
+    static bool isWholeWord(const char *begin, const char *end, const char *first, const char *last);
+    bool matchLine(const QString &line, int &start, int &length) const;
+    QList<SearchMatch> scanBytes(const QString &path) const;
+    QList<SearchMatch> scanFile(const QString &path) const;
+    void scanFiles(const QStringList &files);
+signals:
+    void finished();
+    void matchesFound(const QList<SearchMatch> &matches);
+    void searchFinished(const int scanned, const bool cancelled, const bool limited);
+    void searchProgress(const int scanned, const int total);
+    void started();
+};
+
+#endif // FINDINFILESWORKER_H
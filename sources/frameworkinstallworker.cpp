@@ -0,0 +1,34 @@
+#include <QDebug>
+#include <QDir>
+#include "frameworkinstallworker.h"
+#include "processutils.h"
+
+FrameworkInstallWorker::FrameworkInstallWorker(const QString &apk, const QString &tag, QObject *parent)
+    : QObject(parent), m_Apk(apk), m_Tag(tag)
+{
+}
+
+void FrameworkInstallWorker::install()
+{
+    emit started();
+#ifdef QT_DEBUG
+    qDebug() << "正在安装框架" << m_Apk;
+#endif
+    const QString apktool = ProcessUtils::apktoolJar();
+    QStringList args;
+    args << "if" << QDir::toNativeSeparators(m_Apk);
+    if (!m_Tag.isEmpty()) {
+        args << "-t" << m_Tag;
+    }
+    ProcessResult result = ProcessUtils::runJar(apktool, args);
+#ifdef QT_DEBUG
+    qDebug() << "Apktool 返回代码" << result.code;
+#endif
+    if (result.code != 0) {
+        const QStringList &lines = result.error.isEmpty() ? result.output : result.error;
+        emit frameworkInstallFailed(lines.join("\n"));
+    } else {
+        emit frameworkInstallFinished(result.output.join("\n"));
+    }
+    emit finished();
+}
@@ -0,0 +1,22 @@
+#ifndef FRAMEWORKINSTALLWORKER_H
+#define FRAMEWORKINSTALLWORKER_H
+
+#include <QObject>
+
+class FrameworkInstallWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameworkInstallWorker(const QString &apk, const QString &tag = QString(), QObject *parent = nullptr);
+    void install();
+private:
+    QString m_Apk;
+    QString m_Tag;
+signals:
+    void finished();
+    void frameworkInstallFailed(const QString &output);
+    void frameworkInstallFinished(const QString &output);
+    void started();
+};
+
+#endif // FRAMEWORKINSTALLWORKER_H
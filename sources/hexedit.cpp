@@ -1,10 +1,16 @@
-#include <QFile>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QSaveFile>
 #include <QVBoxLayout>
-#include <QHexView/model/buffer/qmemorybuffer.h>
+#include <QHexView/model/buffer/qpiecetablebuffer.h>
+#include "filesaveworker.h"
 #include "hexedit.h"
 
+#define LARGE_BINARY_FILE_SIZE (64 * 1024 * 1024)
+#define SAVE_CHUNK_SIZE (1024 * 1024)
+
 HexEdit::HexEdit(QWidget *parent)
-    : QWidget(parent)
+    : QWidget(parent), m_Loading(false), m_Streamed(false)
 {
     auto layout = new QVBoxLayout();
     layout->addWidget(m_HexView = new QHexView(this));
@@ -17,20 +23,127 @@ QString HexEdit::filePath()
     return m_FilePath;
 }
 
+bool HexEdit::isLargeFile(const qint64 size)
+{
+    return size > LARGE_BINARY_FILE_SIZE;
+}
+
+bool HexEdit::isStreamed() const
+{
+    return m_Streamed;
+}
+
 void HexEdit::open(const QString &path)
 {
-    auto document = QHexDocument::fromFile(path);
-    m_HexView->setDocument(document);
+    // 大文件映射后作为片段表的原始内容，无法映射时按页读取，打开耗时和内存占用与文件大小无关
+    QHexDocument *document = nullptr;
+    m_Streamed = isLargeFile(QFileInfo(path).size());
+    if (m_Streamed) {
+        document = QHexDocument::fromPieceTableFile(path);
+    }
+    if (!document) {
+        m_Streamed = false;
+        document = QHexDocument::fromFile(path);
+    }
+    setDocument(document);
+    m_FilePath = path;
+}
+
+void HexEdit::open(const QString &path, const QByteArray &data, const QByteArray &hash)
+{
+    // 片段表中插入和删除字节不需要移动后面的全部内容
+    setDocument(QHexDocument::fromMemory<QPieceTableBuffer>(data));
+    m_SavedHash = hash;
+    m_HexView->setReadOnly(false);
     m_FilePath = path;
+    m_Loading = false;
 }
 
 bool HexEdit::save()
 {
-    QFile file(m_FilePath);
-    if (file.open(QFile::WriteOnly)) {
-        m_HexView->hexDocument()->saveTo(&file);
-        file.close();
+    QHexDocument *document = m_HexView->hexDocument();
+    if (m_Streamed) {
+        // 不整体读入内存，片段依次写入临时文件后替换原文件
+        if (!document->isModified()) {
+            return true;
+        }
+        QSaveFile file(m_FilePath);
+        if (!file.open(QIODevice::WriteOnly) || !document->saveTo(&file)) {
+            return false;
+        }
+        // 替换原文件前先释放映射并关闭原文件，Windows 上无法替换仍被打开的文件
+        document->release();
+        if (!file.commit()) {
+            // 原文件没有被替换，重新打开后未保存的修改仍然有效
+            document->restore(false);
+            return false;
+        }
+        // 之后改为读取新文件，旧文件的内容和缓存的页不再使用
+        if (!document->restore(true)) {
+            open(m_FilePath);
+        }
         return true;
     }
-    return false;
+    QList<QByteArray> chunks;
+    QByteArray hash;
+    if (!snapshot(chunks, hash)) {
+        // 内容还没有读完时保存会把文件清空；没有修改时不需要写入
+        return !m_Loading;
+    }
+    const bool success = FileSaveWorker::write(m_FilePath, chunks);
+    setSaved(hash, success);
+    return success;
+}
+
+void HexEdit::setDocument(QHexDocument *document)
+{
+    m_PendingHash.clear();
+    m_SavedHash.clear();
+    m_HexView->setDocument(document);
+}
+
+void HexEdit::setLoading(const QString &path)
+{
+    // 内容由后台线程读取，完成前不允许编辑
+    m_FilePath = path;
+    m_Loading = true;
+    m_HexView->setReadOnly(true);
+}
+
+void HexEdit::setSaved(const QByteArray &hash, const bool success)
+{
+    if (success) {
+        m_SavedHash = hash;
+    } else if (hash == m_PendingHash) {
+        // 写入失败，恢复修改标记，下次保存时重新写入
+        m_PendingHash = m_SavedHash;
+        m_HexView->hexDocument()->markModified();
+    }
+}
+
+bool HexEdit::snapshot(QList<QByteArray> &chunks, QByteArray &hash)
+{
+    QHexDocument *document = m_HexView->hexDocument();
+    if (m_Loading || !document || !document->isModified()) {
+        return false;
+    }
+    // 按块读出缓冲区内容并计算摘要，写入交给 FileSaveWorker；分块合起来是整个文件的副本
+    QCryptographicHash digest(QCryptographicHash::Md5);
+    const qint64 length = document->length();
+    for (qint64 offset = 0; offset < length; offset += SAVE_CHUNK_SIZE) {
+        // 片段表可能直接返回内部数据的引用，交给保存线程前先复制
+        const QByteArray view = document->read(offset, int(qMin<qint64>(SAVE_CHUNK_SIZE, length - offset)));
+        const QByteArray chunk(view.constData(), view.size());
+        digest.addData(chunk);
+        chunks.append(chunk);
+    }
+    hash = digest.result();
+    // 交给保存线程时就清除修改标记，写入失败时由 setSaved() 恢复
+    document->clearModified();
+    if (hash == (m_PendingHash.isEmpty() ? m_SavedHash : m_PendingHash)) {
+        // 内容与上次保存（或正在保存）的相同，跳过写入
+        return false;
+    }
+    m_PendingHash = hash;
+    return true;
 }
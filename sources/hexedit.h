@@ -10,11 +10,22 @@ class HexEdit : public QWidget
 private:
     QString m_FilePath;
     QHexView *m_HexView;
+    bool m_Loading;
+    QByteArray m_PendingHash;
+    QByteArray m_SavedHash;
+    bool m_Streamed;
+    void setDocument(QHexDocument *document);
 public:
     explicit HexEdit(QWidget *parent = nullptr);
     QString filePath();
+    static bool isLargeFile(const qint64 size);
+    bool isStreamed() const;
     void open(const QString &path);
+    void open(const QString &path, const QByteArray &data, const QByteArray &hash = QByteArray());
     bool save();
+    void setLoading(const QString &path);
+    void setSaved(const QByteArray &hash, const bool success);
+    bool snapshot(QList<QByteArray> &chunks, QByteArray &hash);
 };
 
 #endif // HEXEDIT_H
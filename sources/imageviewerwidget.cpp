@@ -32,6 +32,14 @@ void ImageViewerWidget::open(const QString &path)
     m_Image->setPixmap(QPixmap(path));
 }
 
+void ImageViewerWidget::open(const QString &path, const QImage &image)
+{
+    m_FilePath = path;
+    m_Image->setPixmap(QPixmap::fromImage(image));
+    viewport()->setCursor(Qt::OpenHandCursor);
+    zoomReset();
+}
+
 void ImageViewerWidget::keyPressEvent(QKeyEvent *event)
 {
     if (event->modifiers().testFlag(Qt::ControlModifier)) {
@@ -44,6 +52,13 @@ void ImageViewerWidget::keyPressEvent(QKeyEvent *event)
     QScrollArea::keyPressEvent(event);
 }
 
+void ImageViewerWidget::setLoading(const QString &path)
+{
+    // 图片由后台线程解码，完成前显示等待光标
+    m_FilePath = path;
+    viewport()->setCursor(Qt::BusyCursor);
+}
+
 void ImageViewerWidget::zoomIn()
 {
     zoomInOut(1.25);
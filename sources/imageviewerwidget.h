@@ -1,6 +1,7 @@
 #ifndef IMAGEVIEWERWIDGET_H
 #define IMAGEVIEWERWIDGET_H
 
+#include <QImage>
 #include <QKeyEvent>
 #include <QLabel>
 #include <QPixmap>
@@ -19,6 +20,8 @@ public:
     explicit ImageViewerWidget(QWidget *parent = nullptr);
     QString filePath();
     void open(const QString &path);
+    void open(const QString &path, const QImage &image);
+    void setLoading(const QString &path);
     void zoomIn();
     void zoomOut();
     void zoomReset();
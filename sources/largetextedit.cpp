@@ -0,0 +1,695 @@
+#include <climits>
+#include <QApplication>
+#include <QClipboard>
+#include <QInputMethod>
+#include <QInputMethodEvent>
+#include <QKeyEvent>
+#include <QMimeData>
+#include <QPainter>
+#include <QScrollBar>
+#include <QSettings>
+#include <QThread>
+#include "largetextedit.h"
+#include "largetextsaveworker.h"
+
+#define GUTTER_PADDING 6
+#define TAB_STOP_WIDTH 4
+#define TABS_TO_SPACES true
+#define TEXT_MARGIN 4
+
+LargeTextEdit::LargeTextEdit(QWidget *parent)
+    : QAbstractScrollArea(parent), m_Anchor{0, 0}, m_Cursor{0, 0}, m_LineWidth(0), m_Loading(false), m_Newline("\n"), m_SaveThread(nullptr), m_SaveWorker(nullptr)
+{
+    qRegisterMetaType<TextLineIndex>("TextLineIndex");
+    QSettings settings;
+    QFont font;
+#ifdef Q_OS_WIN
+    font.setFamily(settings.value("editor_font", "Courier New").toString());
+#elif defined(Q_OS_MACOS)
+    font.setFamily(settings.value("editor_font", "Monaco").toString());
+#else
+    font.setFamily(settings.value("editor_font", "Ubuntu Mono").toString());
+#endif
+    font.setFixedPitch(true);
+    font.setPointSize(settings.value("editor_font_size", 10).toInt());
+    font.setStyleHint(QFont::Monospace);
+    setFont(font);
+    setAttribute(Qt::WA_InputMethodEnabled);
+    setFocusPolicy(Qt::StrongFocus);
+    setFrameStyle(QFrame::NoFrame);
+    viewport()->setCursor(Qt::IBeamCursor);
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, viewport(), QOverload<>::of(&QWidget::update));
+    connect(horizontalScrollBar(), &QScrollBar::valueChanged, viewport(), QOverload<>::of(&QWidget::update));
+}
+
+LargeTextEdit::~LargeTextEdit()
+{
+    // 保存线程还在读取原文件的映射，取消并等它结束后才能释放；没有提交的临时文件会被删除
+    if (m_SaveThread) {
+        m_SaveThread->requestInterruption();
+        m_SaveThread->quit();
+        m_SaveThread->wait();
+    }
+}
+
+bool LargeTextEdit::canPaste() const
+{
+    const QMimeData *data = QApplication::clipboard()->mimeData();
+    return data && data->hasText();
+}
+
+int LargeTextEdit::columnAt(const QString &text, const int display)
+{
+    int current = 0;
+    for (int i = 0; i < text.length(); ++i) {
+        const int next = (text.at(i) == '\t') ? (((current / TAB_STOP_WIDTH) + 1) * TAB_STOP_WIDTH) : (current + 1);
+        if (display < ((current + next + 1) / 2)) {
+            return i;
+        }
+        current = next;
+    }
+    return text.length();
+}
+
+void LargeTextEdit::copy()
+{
+    if (hasSelection()) {
+        QApplication::clipboard()->setText(selectedText());
+    }
+}
+
+int LargeTextEdit::cursorColumn() const
+{
+    return m_Cursor.column;
+}
+
+qint64 LargeTextEdit::cursorLine() const
+{
+    return m_Cursor.line;
+}
+
+void LargeTextEdit::cut()
+{
+    if (hasSelection() && isEditable()) {
+        copy();
+        Position start;
+        Position end;
+        selection(start, end);
+        removeRange(start, end);
+        edited();
+    }
+}
+
+int LargeTextEdit::displayColumn(const QString &text, const int column)
+{
+    int display = 0;
+    for (int i = 0; (i < column) && (i < text.length()); ++i) {
+        display = (text.at(i) == '\t') ? (((display / TAB_STOP_WIDTH) + 1) * TAB_STOP_WIDTH) : (display + 1);
+    }
+    return display;
+}
+
+void LargeTextEdit::edited()
+{
+    updateScrollBars();
+    ensureCursorVisible();
+    viewport()->update();
+    emit undoAvailable(m_Table.canUndo());
+    emit redoAvailable(m_Table.canRedo());
+    emit copyAvailable(hasSelection());
+    emit cursorPositionChanged();
+    updateInputMethod();
+}
+
+void LargeTextEdit::ensureCursorVisible()
+{
+    const qint64 first = verticalScrollBar()->value();
+    const int visible = qMax(1, visibleLines() - 1);
+    if (m_Cursor.line < first) {
+        verticalScrollBar()->setValue(int(m_Cursor.line));
+    } else if (m_Cursor.line >= (first + visible)) {
+        verticalScrollBar()->setValue(int(m_Cursor.line - visible + 1));
+    }
+    const int advance = fontMetrics().horizontalAdvance(' ');
+    const int x = displayColumn(lineText(m_Cursor.line), m_Cursor.column) * advance;
+    const int width = viewport()->width() - gutterWidth() - (TEXT_MARGIN * 2);
+    if (x > (horizontalScrollBar()->maximum() + width)) {
+        horizontalScrollBar()->setMaximum(x);
+    }
+    if (x < horizontalScrollBar()->value()) {
+        horizontalScrollBar()->setValue(x);
+    } else if (x > (horizontalScrollBar()->value() + width)) {
+        horizontalScrollBar()->setValue(x - width);
+    }
+}
+
+QString LargeTextEdit::expandTabs(const QString &text)
+{
+    if (!text.contains('\t')) {
+        return text;
+    }
+    QString expanded;
+    expanded.reserve(text.length() + TAB_STOP_WIDTH);
+    foreach (const QChar c, text) {
+        if (c == '\t') {
+            expanded.append(QString(TAB_STOP_WIDTH - (expanded.length() % TAB_STOP_WIDTH), ' '));
+        } else {
+            expanded.append(c);
+        }
+    }
+    return expanded;
+}
+
+QString LargeTextEdit::filePath()
+{
+    return m_FilePath;
+}
+
+void LargeTextEdit::gotoLine(const qint64 no)
+{
+    moveTo(Position{qBound<qint64>(0, no - 1, lineCount() - 1), 0}, false);
+}
+
+void LargeTextEdit::handleSaveWritten(const bool success, const TextLineIndex &index)
+{
+    // 临时文件已经写完；替换原文件前先释放映射，Windows 上无法替换仍被映射的文件
+    bool saved = false;
+    bool valid = true;
+    if (success) {
+        m_Table.release();
+        saved = m_SaveWorker->commit();
+        // 替换成功后映射新文件，直接使用写入时建立的索引；否则重新映射原文件，未保存的修改仍然有效
+        valid = saved ? m_Table.open(m_FilePath, index) : m_Table.remap();
+    }
+    m_SaveThread->quit();
+    m_SaveThread = nullptr;
+    m_SaveWorker = nullptr;
+    m_Cursor.line = qMin(m_Cursor.line, lineCount() - 1);
+    m_Cursor.column = qMin(m_Cursor.column, int(lineText(m_Cursor.line).length()));
+    m_Anchor = m_Cursor;
+    edited();
+    emit fileSaved(m_FilePath, saved);
+    if (!valid) {
+        emit openFailed(m_FilePath);
+    }
+}
+
+int LargeTextEdit::gutterWidth() const
+{
+    return fontMetrics().horizontalAdvance(QString::number(lineCount())) + (GUTTER_PADDING * 2);
+}
+
+bool LargeTextEdit::hasSelection() const
+{
+    return (m_Anchor.line != m_Cursor.line) || (m_Anchor.column != m_Cursor.column);
+}
+
+void LargeTextEdit::inputMethodEvent(QInputMethodEvent *event)
+{
+    // 输入法正在组合的文字只显示在光标处，确认后才写入片段表
+    if (!isEditable()) {
+        event->ignore();
+        return;
+    }
+    const bool replace = (event->replacementLength() > 0) && !hasSelection();
+    if (replace) {
+        // 输入法要求替换光标附近已经输入的文字
+        const int length = lineText(m_Cursor.line).length();
+        Position start = m_Cursor;
+        start.column = qBound(0, m_Cursor.column + event->replacementStart(), length);
+        Position end = start;
+        end.column = qMin(start.column + event->replacementLength(), length);
+        removeRange(start, end);
+    }
+    if (!event->commitString().isEmpty()) {
+        insertText(event->commitString());
+    }
+    m_Preedit = event->preeditString();
+    if (replace || !event->commitString().isEmpty()) {
+        edited();
+    } else {
+        ensureCursorVisible();
+        viewport()->update();
+        updateInputMethod();
+    }
+    event->accept();
+}
+
+QVariant LargeTextEdit::inputMethodQuery(Qt::InputMethodQuery query) const
+{
+    switch (query) {
+    case Qt::ImCursorRectangle: {
+        // 候选窗口跟随光标，坐标相对于本控件
+        const int height = fontMetrics().height();
+        const int x = gutterWidth() + TEXT_MARGIN - horizontalScrollBar()->value() + (displayColumn(lineText(m_Cursor.line), m_Cursor.column) * fontMetrics().horizontalAdvance(' '));
+        const int y = int(m_Cursor.line - verticalScrollBar()->value()) * height;
+        return QRect(x, y, 2, height).translated(viewport()->pos());
+    }
+    case Qt::ImAnchorPosition:
+        return (m_Anchor.line == m_Cursor.line) ? m_Anchor.column : m_Cursor.column;
+    case Qt::ImCurrentSelection:
+        return (m_Anchor.line == m_Cursor.line) ? selectedText() : QString();
+    case Qt::ImCursorPosition:
+        return m_Cursor.column;
+    case Qt::ImEnabled:
+        return isEditable();
+    case Qt::ImFont:
+        return font();
+    case Qt::ImHints:
+        return int(Qt::ImhMultiLine);
+    case Qt::ImSurroundingText:
+        return lineText(m_Cursor.line);
+    default:
+        return QAbstractScrollArea::inputMethodQuery(query);
+    }
+}
+
+void LargeTextEdit::insertText(QString text)
+{
+    if (hasSelection()) {
+        Position start;
+        Position end;
+        selection(start, end);
+        removeRange(start, end);
+    }
+    // 统一换行符，与文件原有的风格保持一致
+    text.replace("\r\n", "\n");
+    text.replace('\r', '\n');
+    const QStringList lines = text.split('\n');
+    QByteArray bytes = text.toUtf8();
+    if (m_Newline != "\n") {
+        bytes.replace('\n', m_Newline);
+    }
+    m_Table.insert(offsetOf(m_Cursor), bytes);
+    if (lines.size() > 1) {
+        m_Cursor.line += lines.size() - 1;
+        m_Cursor.column = lines.last().length();
+    } else {
+        m_Cursor.column += text.length();
+    }
+    m_Anchor = m_Cursor;
+}
+
+bool LargeTextEdit::isEditable() const
+{
+    // 索引还没有建立或者正在后台保存时不能修改
+    return !m_Loading && !m_SaveThread;
+}
+
+bool LargeTextEdit::isModified() const
+{
+    return m_Table.isModified();
+}
+
+bool LargeTextEdit::isRedoAvailable() const
+{
+    return m_Table.canRedo();
+}
+
+bool LargeTextEdit::isUndoAvailable() const
+{
+    return m_Table.canUndo();
+}
+
+void LargeTextEdit::keyPressEvent(QKeyEvent *event)
+{
+    const bool select = event->modifiers().testFlag(Qt::ShiftModifier);
+    const bool control = event->modifiers().testFlag(Qt::ControlModifier);
+    if (event == QKeySequence::Copy) {
+        copy();
+    } else if (event == QKeySequence::Cut) {
+        cut();
+    } else if (event == QKeySequence::Paste) {
+        paste();
+    } else if (event == QKeySequence::Undo) {
+        undo();
+    } else if (event == QKeySequence::Redo) {
+        redo();
+    } else if (event == QKeySequence::SelectAll) {
+        m_Anchor = Position{0, 0};
+        moveTo(Position{lineCount() - 1, int(lineText(lineCount() - 1).length())}, true);
+    } else {
+        Position target = m_Cursor;
+        const int length = lineText(m_Cursor.line).length();
+        switch (event->key()) {
+        case Qt::Key_Left:
+            if (target.column > 0) {
+                target.column--;
+            } else if (target.line > 0) {
+                target.line--;
+                target.column = lineText(target.line).length();
+            }
+            moveTo(target, select);
+            break;
+        case Qt::Key_Right:
+            if (target.column < length) {
+                target.column++;
+            } else if (target.line < (lineCount() - 1)) {
+                target.line++;
+                target.column = 0;
+            }
+            moveTo(target, select);
+            break;
+        case Qt::Key_Up:
+        case Qt::Key_Down:
+        case Qt::Key_PageUp:
+        case Qt::Key_PageDown: {
+            const qint64 step = ((event->key() == Qt::Key_Up) || (event->key() == Qt::Key_Down)) ? 1 : qMax(1, visibleLines() - 1);
+            const bool up = (event->key() == Qt::Key_Up) || (event->key() == Qt::Key_PageUp);
+            target.line = qBound<qint64>(0, target.line + (up ? -step : step), lineCount() - 1);
+            target.column = qMin(target.column, int(lineText(target.line).length()));
+            moveTo(target, select);
+            break;
+        }
+        case Qt::Key_Home:
+            moveTo(control ? Position{0, 0} : Position{target.line, 0}, select);
+            break;
+        case Qt::Key_End:
+            if (control) {
+                target.line = lineCount() - 1;
+                target.column = lineText(target.line).length();
+            } else {
+                target.column = length;
+            }
+            moveTo(target, select);
+            break;
+        case Qt::Key_Backspace:
+        case Qt::Key_Delete:
+            if (!isEditable()) {
+                break;
+            }
+            if (hasSelection()) {
+                Position start;
+                Position end;
+                selection(start, end);
+                removeRange(start, end);
+            } else if (event->key() == Qt::Key_Backspace) {
+                if (target.column > 0) {
+                    target.column--;
+                } else if (target.line > 0) {
+                    target.line--;
+                    target.column = lineText(target.line).length();
+                }
+                removeRange(target, m_Cursor);
+            } else {
+                if (target.column < length) {
+                    target.column++;
+                } else if (target.line < (lineCount() - 1)) {
+                    target.line++;
+                    target.column = 0;
+                }
+                removeRange(m_Cursor, target);
+            }
+            edited();
+            break;
+        case Qt::Key_Enter:
+        case Qt::Key_Return:
+            if (isEditable()) {
+                insertText("\n");
+                edited();
+            }
+            break;
+        case Qt::Key_Tab:
+            if (isEditable()) {
+                insertText(TABS_TO_SPACES ? QString(TAB_STOP_WIDTH, ' ') : QString('\t'));
+                edited();
+            }
+            break;
+        default: {
+            const QString text = event->text();
+            if (!text.isEmpty() && text.at(0).isPrint() && !control) {
+                if (isEditable()) {
+                    insertText(text);
+                    edited();
+                }
+                break;
+            }
+            QAbstractScrollArea::keyPressEvent(event);
+            return;
+        }
+        }
+    }
+    event->accept();
+}
+
+qint64 LargeTextEdit::lineCount() const
+{
+    return m_Table.lineCount();
+}
+
+QString LargeTextEdit::lineText(const qint64 line) const
+{
+    // 只解码需要显示或编辑的那一行
+    return QString::fromUtf8(m_Table.line(line));
+}
+
+void LargeTextEdit::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons().testFlag(Qt::LeftButton)) {
+        moveTo(positionAt(event->pos()), true);
+    }
+}
+
+void LargeTextEdit::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        moveTo(positionAt(event->pos()), event->modifiers().testFlag(Qt::ShiftModifier));
+    }
+}
+
+void LargeTextEdit::moveTo(const Position &position, const bool select)
+{
+    const bool selected = hasSelection();
+    m_Cursor = position;
+    if (!select) {
+        m_Anchor = m_Cursor;
+    }
+    ensureCursorVisible();
+    viewport()->update();
+    if (selected != hasSelection()) {
+        emit copyAvailable(hasSelection());
+    }
+    emit cursorPositionChanged();
+    updateInputMethod();
+}
+
+qint64 LargeTextEdit::offsetOf(const Position &position) const
+{
+    return m_Table.lineOffset(position.line) + lineText(position.line).left(position.column).toUtf8().size();
+}
+
+void LargeTextEdit::open(const QString &path, const TextLineIndex &index)
+{
+    m_Loading = false;
+    if (!m_Table.open(path, index)) {
+        emit openFailed(path);
+        return;
+    }
+    m_FilePath = path;
+    // 沿用文件第一行的换行符风格
+    if (m_Table.lineCount() > 1) {
+        const qint64 offset = m_Table.lineOffset(1);
+        if ((offset >= 2) && (m_Table.read(offset - 2, 1) == "\r")) {
+            m_Newline = "\r\n";
+        }
+    }
+    m_Anchor = m_Cursor = Position{0, 0};
+    updateScrollBars();
+    viewport()->update();
+}
+
+void LargeTextEdit::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(viewport());
+    const QFontMetrics metrics = fontMetrics();
+    const int height = metrics.height();
+    const int advance = metrics.horizontalAdvance(' ');
+    const int gutter = gutterWidth();
+    const int left = gutter + TEXT_MARGIN - horizontalScrollBar()->value();
+    const qint64 first = verticalScrollBar()->value();
+    const QColor text = palette().color(QPalette::Text);
+    QColor current = text;
+    current.setAlpha(25);
+    painter.fillRect(event->rect(), palette().color(QPalette::Base));
+    painter.setFont(font());
+    if (m_Loading) {
+        painter.setPen(palette().color(QPalette::PlaceholderText));
+        painter.drawText(viewport()->rect(), Qt::AlignCenter, tr("正在加载..."));
+        return;
+    }
+    Position start;
+    Position end;
+    selection(start, end);
+    int widest = 0;
+    for (int row = 0; (row * height) < viewport()->height(); ++row) {
+        const qint64 line = first + row;
+        if (line >= lineCount()) {
+            break;
+        }
+        const int top = row * height;
+        QString content = lineText(line);
+        int composed = -1;
+        if ((line == m_Cursor.line) && !m_Preedit.isEmpty()) {
+            // 输入法正在组合的文字插在光标处显示
+            content.insert(m_Cursor.column, m_Preedit);
+            composed = m_Cursor.column + m_Preedit.length();
+        }
+        const QString shown = expandTabs(content);
+        widest = qMax(widest, int(shown.length()) * advance);
+        if (line == m_Cursor.line) {
+            painter.fillRect(QRect(0, top, viewport()->width(), height), current);
+        }
+        if (hasSelection() && (line >= start.line) && (line <= end.line)) {
+            const int from = (line == start.line) ? displayColumn(content, start.column) : 0;
+            const int to = (line == end.line) ? displayColumn(content, end.column) : (shown.length() + 1);
+            painter.fillRect(QRect(left + (from * advance), top, (to - from) * advance, height), palette().color(QPalette::Highlight));
+        }
+        painter.setPen(text);
+        painter.drawText(left, top + metrics.ascent(), shown);
+        if (composed >= 0) {
+            const int from = left + (displayColumn(content, m_Cursor.column) * advance);
+            const int to = left + (displayColumn(content, composed) * advance);
+            painter.drawLine(from, top + height - 1, to, top + height - 1);
+        }
+        if ((line == m_Cursor.line) && hasFocus()) {
+            painter.fillRect(QRect(left + (displayColumn(content, (composed >= 0) ? composed : m_Cursor.column) * advance), top, 2, height), text);
+        }
+    }
+    // 行号栏最后绘制，覆盖水平滚动后移到左侧的文本
+    painter.fillRect(QRect(0, 0, gutter, viewport()->height()), palette().color(QPalette::Base));
+    for (int row = 0; (row * height) < viewport()->height(); ++row) {
+        const qint64 line = first + row;
+        if (line >= lineCount()) {
+            break;
+        }
+        QFont number = font();
+        number.setWeight((line == m_Cursor.line) ? QFont::Bold : QFont::Normal);
+        painter.setFont(number);
+        painter.setPen(text);
+        painter.drawText(QRect(0, row * height, gutter - GUTTER_PADDING, height), Qt::AlignRight | Qt::AlignVCenter, QString::number(line + 1));
+    }
+    painter.setPen(palette().color(QPalette::Highlight));
+    painter.drawLine(gutter - 1, 0, gutter - 1, viewport()->height());
+    if (widest > m_LineWidth) {
+        m_LineWidth = widest;
+        updateScrollBars();
+    }
+}
+
+void LargeTextEdit::paste()
+{
+    if (canPaste() && isEditable()) {
+        insertText(QApplication::clipboard()->text());
+        edited();
+    }
+}
+
+LargeTextEdit::Position LargeTextEdit::positionAt(const QPoint &point) const
+{
+    const int height = fontMetrics().height();
+    const qint64 line = qBound<qint64>(0, verticalScrollBar()->value() + (point.y() / height), lineCount() - 1);
+    const int x = point.x() - gutterWidth() - TEXT_MARGIN + horizontalScrollBar()->value();
+    const QString content = lineText(line);
+    return Position{line, columnAt(content, qMax(0, x) / qMax(1, fontMetrics().horizontalAdvance(' ')))};
+}
+
+void LargeTextEdit::redo()
+{
+    if (isEditable() && m_Table.redo()) {
+        m_Cursor.line = qMin(m_Cursor.line, lineCount() - 1);
+        m_Cursor.column = qMin(m_Cursor.column, int(lineText(m_Cursor.line).length()));
+        m_Anchor = m_Cursor;
+        edited();
+    }
+}
+
+void LargeTextEdit::removeRange(const Position &start, const Position &end)
+{
+    const qint64 from = offsetOf(start);
+    m_Table.remove(from, offsetOf(end) - from);
+    m_Anchor = m_Cursor = start;
+}
+
+void LargeTextEdit::resizeEvent(QResizeEvent *event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateScrollBars();
+}
+
+bool LargeTextEdit::save()
+{
+    if (m_Loading) {
+        return false;
+    }
+    // 正在保存时编辑器是只读的，不会产生新的修改；没有修改时不重写整个文件
+    if (m_SaveThread || !m_Table.isModified()) {
+        return true;
+    }
+    // 片段在后台线程写入临时文件，写完后回到界面线程替换原文件
+    m_SaveThread = new QThread();
+    m_SaveWorker = new LargeTextSaveWorker(m_FilePath, m_Table.snapshot());
+    m_SaveWorker->moveToThread(m_SaveThread);
+    connect(m_SaveThread, &QThread::started, m_SaveWorker, &LargeTextSaveWorker::write);
+    connect(m_SaveWorker, &LargeTextSaveWorker::written, this, &LargeTextEdit::handleSaveWritten);
+    connect(m_SaveThread, &QThread::finished, m_SaveWorker, &QObject::deleteLater);
+    connect(m_SaveThread, &QThread::finished, m_SaveThread, &QObject::deleteLater);
+    m_SaveThread->start();
+    return true;
+}
+
+QString LargeTextEdit::selectedText() const
+{
+    Position start;
+    Position end;
+    selection(start, end);
+    const qint64 from = offsetOf(start);
+    return QString::fromUtf8(m_Table.read(from, offsetOf(end) - from));
+}
+
+void LargeTextEdit::selection(Position &start, Position &end) const
+{
+    const bool reversed = (m_Cursor.line < m_Anchor.line) || ((m_Cursor.line == m_Anchor.line) && (m_Cursor.column < m_Anchor.column));
+    start = reversed ? m_Cursor : m_Anchor;
+    end = reversed ? m_Anchor : m_Cursor;
+}
+
+void LargeTextEdit::setLoading(const QString &path)
+{
+    // 换行符索引由后台线程建立，完成前只显示占位提示
+    m_FilePath = path;
+    m_Loading = true;
+    viewport()->update();
+}
+
+void LargeTextEdit::undo()
+{
+    if (isEditable() && m_Table.undo()) {
+        m_Cursor.line = qMin(m_Cursor.line, lineCount() - 1);
+        m_Cursor.column = qMin(m_Cursor.column, int(lineText(m_Cursor.line).length()));
+        m_Anchor = m_Cursor;
+        edited();
+    }
+}
+
+void LargeTextEdit::updateInputMethod()
+{
+    if (hasFocus()) {
+        QApplication::inputMethod()->update(Qt::ImCursorRectangle | Qt::ImCursorPosition | Qt::ImAnchorPosition | Qt::ImSurroundingText | Qt::ImCurrentSelection);
+    }
+}
+
+void LargeTextEdit::updateScrollBars()
+{
+    const int visible = visibleLines();
+    verticalScrollBar()->setPageStep(visible);
+    verticalScrollBar()->setRange(0, int(qBound<qint64>(0, lineCount() - visible, INT_MAX)));
+    const int width = viewport()->width() - gutterWidth() - (TEXT_MARGIN * 2);
+    horizontalScrollBar()->setPageStep(width);
+    horizontalScrollBar()->setSingleStep(fontMetrics().horizontalAdvance(' '));
+    horizontalScrollBar()->setRange(0, qMax(0, m_LineWidth - width));
+}
+
+int LargeTextEdit::visibleLines() const
+{
+    return qMax(1, viewport()->height() / fontMetrics().height());
+}
@@ -0,0 +1,88 @@
+#ifndef LARGETEXTEDIT_H
+#define LARGETEXTEDIT_H
+
+#include <QAbstractScrollArea>
+#include "textpiecetable.h"
+
+class LargeTextSaveWorker;
+class QThread;
+
+class LargeTextEdit : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    explicit LargeTextEdit(QWidget *parent = nullptr);
+    ~LargeTextEdit();
+    bool canPaste() const;
+    int cursorColumn() const;
+    qint64 cursorLine() const;
+    QString filePath();
+    void gotoLine(const qint64 no);
+    bool hasSelection() const;
+    QVariant inputMethodQuery(Qt::InputMethodQuery query) const override;
+    bool isModified() const;
+    bool isRedoAvailable() const;
+    bool isUndoAvailable() const;
+    qint64 lineCount() const;
+    bool save();
+    void setLoading(const QString &path);
+public slots:
+    void copy();
+    void cut();
+    void open(const QString &path, const TextLineIndex &index);
+    void paste();
+    void redo();
+    void undo();
+protected:
+    void inputMethodEvent(QInputMethodEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+private:
+    struct Position
+    {
+        qint64 line;
+        int column;
+    };
+    Position m_Anchor;
+    Position m_Cursor;
+    QString m_FilePath;
+    int m_LineWidth;
+    bool m_Loading;
+    QByteArray m_Newline;
+    QString m_Preedit;
+    QThread *m_SaveThread;
+    LargeTextSaveWorker *m_SaveWorker;
+    TextPieceTable m_Table;
+    static int columnAt(const QString &text, const int display);
+    static int displayColumn(const QString &text, const int column);
+    void edited();
+    void ensureCursorVisible();
+    static QString expandTabs(const QString &text);
+    int gutterWidth() const;
+    void insertText(QString text);
+    bool isEditable() const;
+    QString lineText(const qint64 line) const;
+    void moveTo(const Position &position, const bool select);
+    qint64 offsetOf(const Position &position) const;
+    Position positionAt(const QPoint &point) const;
+    void removeRange(const Position &start, const Position &end);
+    QString selectedText() const;
+    void selection(Position &start, Position &end) const;
+    void updateInputMethod();
+    void updateScrollBars();
+    int visibleLines() const;
+private slots:
+    void handleSaveWritten(const bool success, const TextLineIndex &index);
+signals:
+    void copyAvailable(const bool available);
+    void cursorPositionChanged();
+    void fileSaved(const QString &path, const bool success);
+    void openFailed(const QString &path);
+    void redoAvailable(const bool available);
+    void undoAvailable(const bool available);
+};
+
+#endif // LARGETEXTEDIT_H
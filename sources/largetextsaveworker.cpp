@@ -0,0 +1,34 @@
+#include <QDebug>
+#include <QSaveFile>
+#include <QThread>
+#include "largetextsaveworker.h"
+
+LargeTextSaveWorker::LargeTextSaveWorker(const QString &path, const TextPieceTable::Snapshot &snapshot, QObject *parent)
+    : QObject(parent), m_File(nullptr), m_FilePath(path), m_Snapshot(snapshot)
+{
+}
+
+bool LargeTextSaveWorker::commit()
+{
+    // 由界面线程在释放原文件的映射之后调用，此时后台线程只在等待事件
+    return m_File && m_File->commit();
+}
+
+void LargeTextSaveWorker::write()
+{
+#ifdef QT_DEBUG
+    qDebug() << "正在后台保存" << m_FilePath;
+#endif
+    // 先写入临时文件，替换原文件要等界面线程释放映射后再进行
+    m_File = new QSaveFile(m_FilePath, this);
+    TextLineIndex index;
+    const bool success = m_File->open(QIODevice::WriteOnly) && m_Snapshot.write(m_File, index, [] {
+        return QThread::currentThread()->isInterruptionRequested();
+    });
+    if (!success) {
+        m_File->cancelWriting();
+    }
+    // 之后不再读取原文件的映射
+    m_Snapshot = TextPieceTable::Snapshot();
+    emit written(success, index);
+}
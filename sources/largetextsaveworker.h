@@ -0,0 +1,24 @@
+#ifndef LARGETEXTSAVEWORKER_H
+#define LARGETEXTSAVEWORKER_H
+
+#include <QObject>
+#include "textpiecetable.h"
+
+class QSaveFile;
+
+class LargeTextSaveWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LargeTextSaveWorker(const QString &path, const TextPieceTable::Snapshot &snapshot, QObject *parent = nullptr);
+    bool commit();
+    void write();
+private:
+    QSaveFile *m_File;
+    QString m_FilePath;
+    TextPieceTable::Snapshot m_Snapshot;
+signals:
+    void written(const bool success, const TextLineIndex &index);
+};
+
+#endif // LARGETEXTSAVEWORKER_H
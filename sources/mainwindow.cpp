@@ -1,3 +1,4 @@
+#include <climits>
 #include <QApplication>
 #include <QClipboard>
 #include <QCloseEvent>
@@ -23,11 +24,11 @@
 #include <QStandardPaths>
 #include <QStatusBar>
 #include <QTabWidget>
+#include <QTextBlock>
 #include <QTextStream>
 #include <QTextDocumentFragment>
 #include <QThread>
 #include <QTimer>
-#include <QTreeWidgetItem>
 #include <QUrl>
 #include "adbinstallworker.h"
 #include "apkdecompiledialog.h"
@@ -36,17 +37,26 @@
 #include "apksignworker.h"
 #include "desktopdatabaseupdateworker.h"
 #include "deviceselectiondialog.h"
+#include "fileopenworker.h"
+#include "filesaveworker.h"
 #include "findinfilesdialog.h"
+#include "findinfilesworker.h"
 #include "findreplacedialog.h"
+#include "frameworkinstallworker.h"
 #include "hexedit.h"
 #include "imageviewerwidget.h"
+#include "largetextedit.h"
+#include "resourcexref.h"
+#include "resourcexrefworker.h"
 #include "tooldownloaddialog.h"
 #include "tooldownloadworker.h"
+#include "trigramindex.h"
 #include "versionresolveworker.h"
 #include "mainwindow.h"
 #include "settingsdialog.h"
 #include "signingconfigdialog.h"
 #include "sourcecodeedit.h"
+#include "symbolsearchdialog.h"
 
 #define CODE_RESTART 60600
 
@@ -55,9 +65,16 @@
 #define COLOR_OUTPUT 0xffffff
 #define COLOR_ERROR 0xfb0a2a
 
+#define CONSOLE_MAX_BLOCKS 10000
+
 #define IMAGE_EXTENSIONS "gif|jpeg|jpg|png"
 #define TEXT_EXTENSIONS "java|html|properties|smali|txt|xml|yaml|yml"
 
+#define LARGE_TEXT_FILE_SIZE (32 * 1024 * 1024)
+
+#define PROJECT_FILTER_DELAY_MSECS 200
+#define PROJECT_FILTER_MAX_MATCHES 2000
+
 #define URL_CONTRIBUTE "https://github.com/vaibhavpandeyvpz/apkstudio"
 #define URL_DOCUMENTATION "https://vaibhavpandey.com/apkstudio/"
 #define URL_ISSUES "https://github.com/vaibhavpandeyvpz/apkstudio/issues"
@@ -66,19 +83,27 @@
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 600
 
-MainWindow::MainWindow(const QMap<QString, QString> &versions, QWidget *parent)
-    : QMainWindow(parent), m_FindReplaceDialog(nullptr), m_FindInFilesDialog(nullptr)
+MainWindow::MainWindow(QWidget *parent)
+    : QMainWindow(parent), m_FindReplaceDialog(nullptr), m_FindInFilesDialog(nullptr),
+      m_SaveThread(new QThread(this)),
+      m_SaveWorker(new FileSaveWorker)
 {
+    // 保存在同一个后台线程中按顺序进行，同一文件的多次保存不会乱序
+    m_SaveWorker->moveToThread(m_SaveThread);
+    connect(this, &MainWindow::saveRequested, m_SaveWorker, &FileSaveWorker::save);
+    connect(m_SaveWorker, &FileSaveWorker::fileSaved, this, &MainWindow::handleFileSaved);
+    m_SaveThread->start();
     addDockWidget(Qt::LeftDockWidgetArea, m_DockProject = buildProjectsDock());
     addDockWidget(Qt::LeftDockWidgetArea, m_DockFiles = buildFilesDock());
     addDockWidget(Qt::BottomDockWidgetArea, m_DockConsole = buildConsoleDock());
+    addDockWidget(Qt::RightDockWidgetArea, m_DockOutline = buildOutlineDock());
     addToolBar(Qt::LeftToolBarArea, m_MainToolBar = buildMainToolBar());
     // 安装事件过滤器，当工具栏通过上下文菜单隐藏/显示时同步菜单操作
     m_MainToolBar->installEventFilter(this);
     setCentralWidget(buildCentralWidget());
     setMenuBar(buildMenuBar());
     setMinimumSize(WINDOW_WIDTH, WINDOW_HEIGHT);
-    setStatusBar(buildStatusBar(versions));
+    setStatusBar(buildStatusBar());
     updateWindowTitle();
     
 #ifdef Q_OS_LINUX
@@ -101,6 +126,7 @@ MainWindow::MainWindow(const QMap<QString, QString> &versions, QWidget *parent)
     m_ActionViewProject->setChecked(m_DockProject->isVisible());
     m_ActionViewFiles->setChecked(m_DockFiles->isVisible());
     m_ActionViewConsole->setChecked(m_DockConsole->isVisible());
+    m_ActionViewOutline->setChecked(m_DockOutline->isVisible());
     m_ActionViewToolBar->setChecked(m_MainToolBar->isVisible());
     
     // 确保主窗口获得焦点而不是搜索框
@@ -119,58 +145,19 @@ MainWindow::MainWindow(const QMap<QString, QString> &versions, QWidget *parent)
                 openFile(file);
             }
         }
-        bool missing = false;
-        foreach (const QString &binary, versions.keys()) {
-            if (versions[binary].isEmpty()) {
-#ifdef QT_DEBUG
-                qDebug() << binary << "缺失";
-#endif
-                missing = true;
-                break;
-            }
-        }
-        if (missing) {
-            QMessageBox msgBox(this);
-            msgBox.setWindowTitle(tr("需求"));
-            msgBox.setText(tr("一个或多个必需的第三方二进制文件缺失。"));
-            msgBox.setInformativeText(tr("是否要自动下载它们或手动配置？"));
-            QPushButton *downloadButton = msgBox.addButton(tr("下载"), QMessageBox::AcceptRole);
-            QPushButton *settingsButton = msgBox.addButton(tr("设置"), QMessageBox::ActionRole);
-            msgBox.addButton(tr("取消"), QMessageBox::RejectRole);
-            
-            int result = msgBox.exec();
-            if (msgBox.clickedButton() == downloadButton) {
-                // 下载所有缺失的工具
-                QList<ToolDownloadWorker::ToolType> toolsToDownload;
-                foreach (const QString &binary, versions.keys()) {
-                    if (versions[binary].isEmpty()) {
-                        if (binary == "java") {
-                            toolsToDownload.append(ToolDownloadWorker::Java);
-                        } else if (binary == "apktool") {
-                            toolsToDownload.append(ToolDownloadWorker::Apktool);
-                        } else if (binary == "jadx") {
-                            toolsToDownload.append(ToolDownloadWorker::Jadx);
-                        } else if (binary == "adb") {
-                            toolsToDownload.append(ToolDownloadWorker::Adb);
-                        } else if (binary == "uas") {
-                            toolsToDownload.append(ToolDownloadWorker::UberApkSigner);
-                        }
-                    }
-                }
-                
-                if (!toolsToDownload.isEmpty()) {
-                    ToolDownloadDialog downloadDialog(toolsToDownload, this);
-                    if (downloadDialog.exec() == QDialog::Accepted && downloadDialog.wasSuccessful()) {
-                        // 重启应用以检测新下载的工具
-                        QApplication::exit(CODE_RESTART);
-                    }
-                }
-            } else if (msgBox.clickedButton() == settingsButton) {
-                // 设置
-                (new SettingsDialog(1, this))->exec();
-            }
-        }
     });
+    
+    // 在后台并行检查工具版本，状态栏随结果逐项更新
+    auto thread = new QThread();
+    auto worker = new VersionResolveWorker;
+    worker->moveToThread(thread);
+    connect(worker, &VersionResolveWorker::versionResolved, this, &MainWindow::handleVersionResolved);
+    connect(worker, &VersionResolveWorker::finished, this, &MainWindow::handleVersionResolveFinished);
+    connect(thread, &QThread::started, worker, &VersionResolveWorker::resolve);
+    connect(worker, &VersionResolveWorker::finished, thread, &QThread::quit);
+    connect(worker, &VersionResolveWorker::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
 }
 
 QWidget *MainWindow::buildCentralWidget()
@@ -218,7 +205,10 @@ QDockWidget *MainWindow::buildConsoleDock()
     m_EditConsole->setReadOnly(true);
     m_EditConsole->setTabStopDistance(4 * metrics.horizontalAdvance('8'));
     m_EditConsole->setWordWrapMode(QTextOption::NoWrap);
+    // 限制控制台保留的行数，长时间运行的 apktool/jadx 不会让内存无限增长
+    m_EditConsole->document()->setMaximumBlockCount(CONSOLE_MAX_BLOCKS);
     connect(ProcessOutput::instance(), &ProcessOutput::commandFinished, this, &MainWindow::handleCommandFinished);
+    connect(ProcessOutput::instance(), &ProcessOutput::commandOutput, this, &MainWindow::handleCommandOutput);
     connect(ProcessOutput::instance(), &ProcessOutput::commandStarting, this, &MainWindow::handleCommandStarting);
     setContentsMargins(2, 2, 2, 2);
     dock->setObjectName("ConsoleDock");
@@ -326,6 +316,9 @@ QMenuBar *MainWindow::buildMenuBar()
     m_ActionReplace->setEnabled(false);
     m_ActionGoto = edit->addAction(tr("转到行"), this, &MainWindow::handleActionGoto);
     m_ActionGoto->setEnabled(false);
+    m_ActionGotoSymbol = edit->addAction(tr("转到符号"), this, &MainWindow::handleActionGotoSymbol, QKeySequence("Ctrl+Shift+O"));
+    m_ActionFindUsages = edit->addAction(tr("查找用法"), this, &MainWindow::handleActionFindUsages, QKeySequence("Alt+F7"));
+    m_ActionFindUsages->setEnabled(false);
     edit->addSeparator();
     edit->addAction(tr("设置"), this, &MainWindow::handleActionSettings, QKeySequence::Preferences);
     auto view = menubar->addMenu(tr("视图"));
@@ -353,6 +346,14 @@ QMenuBar *MainWindow::buildMenuBar()
             m_ActionViewConsole->setChecked(isVisible);
         }
     });
+    m_ActionViewOutline = view->addAction(tr("大纲"));
+    m_ActionViewOutline->setCheckable(true);
+    connect(m_ActionViewOutline, &QAction::toggled, m_DockOutline, &QDockWidget::setVisible);
+    connect(m_DockOutline, &QDockWidget::visibilityChanged, [this](bool isVisible) {
+        if (!(windowState() & Qt::WindowMinimized)) {
+            m_ActionViewOutline->setChecked(isVisible);
+        }
+    });
     view->addSeparator();
     m_ActionViewToolBar = view->addAction(tr("侧边栏"));
     m_ActionViewToolBar->setCheckable(true);
@@ -383,6 +384,20 @@ QMenuBar *MainWindow::buildMenuBar()
     return menubar;
 }
 
+QDockWidget *MainWindow::buildOutlineDock()
+{
+    auto dock = new QDockWidget(tr("大纲"), this);
+    m_ListOutline = new QListWidget(this);
+    m_ListOutline->setMinimumWidth(240);
+    m_ListOutline->setUniformItemSizes(true);
+    connect(m_ListOutline, &QListWidget::itemActivated, this, &MainWindow::handleOutlineActivated);
+    // 大纲来自项目的 smali 符号索引，索引更新后刷新当前文件的大纲
+    connect(m_ProjectsModel, &ProjectTreeModel::smaliIndexed, this, &MainWindow::updateOutline);
+    dock->setObjectName("OutlineDock");
+    dock->setWidget(m_ListOutline);
+    return dock;
+}
+
 QDockWidget *MainWindow::buildProjectsDock()
 {
     auto dock = new QDockWidget(tr("项目"), this);
@@ -395,9 +410,24 @@ QDockWidget *MainWindow::buildProjectsDock()
     m_SearchProjects->setPlaceholderText(tr("在项目中搜索..."));
     m_SearchProjects->setClearButtonEnabled(true);
     connect(m_SearchProjects, &QLineEdit::textChanged, this, &MainWindow::handleProjectsSearchChanged);
+    // 输入停顿后再过滤，避免每个按键都重新查询
+    m_SearchProjectsTimer = new QTimer(this);
+    m_SearchProjectsTimer->setInterval(PROJECT_FILTER_DELAY_MSECS);
+    m_SearchProjectsTimer->setSingleShot(true);
+    connect(m_SearchProjectsTimer, &QTimer::timeout, [=] {
+        filterProjectTreeItems(m_SearchProjects->text());
+    });
     layout->addWidget(m_SearchProjects);
     
-    m_ProjectsTree = new QTreeWidget(this);
+    m_ProjectsModel = new ProjectTreeModel(this);
+    connect(m_ProjectsModel, &ProjectTreeModel::pathRevealed, this, &MainWindow::handleTreePathRevealed);
+    connect(m_ProjectsModel, &ProjectTreeModel::projectIndexed, [=] {
+        // 索引建立完成后用完整结果重新过滤
+        if (!m_SearchProjects->text().isEmpty()) {
+            filterProjectTreeItems(m_SearchProjects->text());
+        }
+    });
+    m_ProjectsTree = new QTreeView(this);
     m_ProjectsTree->header()->hide();
     m_ProjectsTree->setContextMenuPolicy(Qt::CustomContextMenu);
     m_ProjectsTree->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -405,8 +435,18 @@ QDockWidget *MainWindow::buildProjectsDock()
     m_ProjectsTree->setSelectionBehavior(QAbstractItemView::SelectItems);
     m_ProjectsTree->setSelectionMode(QAbstractItemView::SingleSelection);
     m_ProjectsTree->setSortingEnabled(false);
-    connect(m_ProjectsTree, &QTreeWidget::customContextMenuRequested, this, &MainWindow::handleTreeContextMenu);
-    connect(m_ProjectsTree, &QTreeWidget::doubleClicked, this, &MainWindow::handleTreeDoubleClicked);
+    m_ProjectsTree->setUniformRowHeights(true);
+    m_ProjectsProxyModel = new ProjectTreeFilterModel(this);
+    m_ProjectsProxyModel->setSourceModel(m_ProjectsModel);
+    connect(m_ProjectsProxyModel, &QAbstractItemModel::rowsInserted, [=](const QModelIndex &parent) {
+        // 搜索时命中项所在的目录陆续加载，加载到的目录随之展开
+        if (m_ProjectsProxyModel->isFiltering() && parent.isValid()) {
+            m_ProjectsTree->expand(parent);
+        }
+    });
+    m_ProjectsTree->setModel(m_ProjectsProxyModel);
+    connect(m_ProjectsTree, &QTreeView::customContextMenuRequested, this, &MainWindow::handleTreeContextMenu);
+    connect(m_ProjectsTree, &QTreeView::doubleClicked, this, &MainWindow::handleTreeDoubleClicked);
     connect(m_ProjectsTree->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::handleTreeSelectionChanged);
     layout->addWidget(m_ProjectsTree);
     
@@ -416,7 +456,34 @@ QDockWidget *MainWindow::buildProjectsDock()
     return dock;
 }
 
-QStatusBar *MainWindow::buildStatusBar(const QMap<QString, QString> &versions)
+void MainWindow::buildResourceXref(const QString &folder)
+{
+    // 在后台扫描 public.xml 和全部 smali 文件，之后查找资源引用不再需要遍历项目
+    if (m_XrefBuilding.contains(folder)) {
+        // 重复触发时等待正在进行的任务
+        return;
+    }
+    const QDateTime started = QDateTime::currentDateTime();
+    m_XrefBuilding.insert(folder, started);
+    auto thread = new QThread();
+    auto worker = new ResourceXrefWorker(folder);
+    worker->moveToThread(thread);
+    connect(thread, &QThread::started, worker, &ResourceXrefWorker::build);
+    connect(worker, &ResourceXrefWorker::finished, thread, &QThread::quit);
+    connect(worker, &ResourceXrefWorker::xrefBuilt, this, [=](const QString &project, const bool success) {
+        m_XrefBuilding.remove(project);
+        if (success) {
+            // 记录开始扫描的时间，扫描期间保存的文件仍然视为索引之后的修改
+            m_XrefBuilt.insert(project, started);
+            m_StatusMessage->setText(tr("已建立 %1 的资源索引。").arg(QFileInfo(project).fileName()));
+        }
+    });
+    connect(worker, &ResourceXrefWorker::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+}
+
+QStatusBar *MainWindow::buildStatusBar()
 {
     auto buildSeparator = [=] {
         auto frame = new QFrame(this);
@@ -424,16 +491,23 @@ QStatusBar *MainWindow::buildStatusBar(const QMap<QString, QString> &versions)
         frame->setSizePolicy(QSizePolicy::Minimum, QSizePolicy::Expanding);
         return frame;
     };
+    // 版本在后台解析完成后由 handleVersionResolved 填入
+    auto buildVersionLabel = [=](const QString &binary, const QString &title) {
+        auto label = new QLabel(QString(title).append(": ..."), this);
+        label->setProperty("title", title);
+        m_VersionLabels.insert(binary, label);
+        return label;
+    };
     auto statusbar = new QStatusBar(this);
-    statusbar->addPermanentWidget(new QLabel(tr("Java").append(": ").append(versions["java"]), this));
+    statusbar->addPermanentWidget(buildVersionLabel("java", tr("Java")));
     statusbar->addPermanentWidget(buildSeparator());
-    statusbar->addPermanentWidget(new QLabel(tr("Apktool").append(": ").append(versions["apktool"]), this));
+    statusbar->addPermanentWidget(buildVersionLabel("apktool", tr("Apktool")));
     statusbar->addPermanentWidget(buildSeparator());
-    statusbar->addPermanentWidget(new QLabel(tr("Jadx").append(": ").append(versions["jadx"]), this));
+    statusbar->addPermanentWidget(buildVersionLabel("jadx", tr("Jadx")));
     statusbar->addPermanentWidget(buildSeparator());
-    statusbar->addPermanentWidget(new QLabel(tr("ADB").append(": ").append(versions["adb"]), this));
+    statusbar->addPermanentWidget(buildVersionLabel("adb", tr("ADB")));
     statusbar->addPermanentWidget(buildSeparator());
-    statusbar->addPermanentWidget(new QLabel(tr("Uber APK Signer").append(": ").append(versions["uas"]), this));
+    statusbar->addPermanentWidget(buildVersionLabel("uas", tr("Uber APK Signer")));
     statusbar->addPermanentWidget(new QWidget(this), 1);
     statusbar->addPermanentWidget(m_StatusCursor = new QLabel("0:0", this));
     statusbar->addPermanentWidget(buildSeparator());
@@ -482,8 +556,11 @@ int MainWindow::findTabIndex(const QString &path)
         auto edit = dynamic_cast<SourceCodeEdit *>(widget);
         auto hex = dynamic_cast<HexEdit *>(widget);
         auto viewer = dynamic_cast<ImageViewerWidget *>(widget);
+        auto large = dynamic_cast<LargeTextEdit *>(widget);
         if (edit) {
             path2 = edit->filePath();
+        } else if (large) {
+            path2 = large->filePath();
         } else if (hex) {
             path2 = hex->filePath();
         } else if (viewer) {
@@ -557,12 +634,12 @@ void MainWindow::openApkFile(const QString &apkPath)
 
 void MainWindow::handleActionBuild()
 {
-    auto active = m_ProjectsTree->currentItem();
-    if (!active) {
-        active = m_ProjectsTree->topLevelItem(0);
+    QModelIndex active = m_ProjectsTree->currentIndex();
+    if (!active.isValid()) {
+        active = m_ProjectsModel->index(0, 0);
     }
-    while (active->data(0, Qt::UserRole + 1).toInt() != Project) {
-        active = active->parent();
+    while (active.data(Qt::UserRole + 1).toInt() != Project) {
+        active = active.parent();
     }
     QSettings settings;
     auto appt2 = settings.value("use_aapt2", true).toBool();
@@ -581,7 +658,7 @@ void MainWindow::handleActionBuild()
     }
     
     auto thread = new QThread();
-    auto worker = new ApkRecompileWorker(active->data(0, Qt::UserRole + 2).toString(), appt2, extraArguments);
+    auto worker = new ApkRecompileWorker(active.data(Qt::UserRole + 2).toString(), appt2, extraArguments);
     worker->moveToThread(thread);
     connect(worker, &ApkRecompileWorker::recompileFailed, this, &MainWindow::handleRecompileFailed);
     connect(worker, &ApkRecompileWorker::recompileFinished, this, &MainWindow::handleRecompileFinished);
@@ -624,13 +701,21 @@ void MainWindow::handleActionContribute()
 void MainWindow::handleActionCopy()
 {
     auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
-    edit->copy();
+    if (edit) {
+        edit->copy();
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(m_TabEditors->currentWidget())) {
+        large->copy();
+    }
 }
 
 void MainWindow::handleActionCut()
 {
     auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
-    edit->cut();
+    if (edit) {
+        edit->cut();
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(m_TabEditors->currentWidget())) {
+        large->cut();
+    }
 }
 
 void MainWindow::handleActionDocumentation()
@@ -680,6 +765,49 @@ void MainWindow::handleActionFindInFiles()
     m_FindInFilesDialog->activateWindow();
 }
 
+void MainWindow::handleActionFindUsages()
+{
+    auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
+    if (!edit) {
+        return;
+    }
+    // 优先使用选中的签名，否则取光标所在行定义或调用的符号
+    QString target = edit->textCursor().selectedText().trimmed();
+    const QString root = findProjectRoot(edit->filePath());
+    if (!root.isEmpty()) {
+        // 资源编号、R 类字段或 public.xml 中的条目直接在资源交叉索引中查找引用
+        ResourceXref xref(root);
+        if (m_XrefBuilding.contains(root)) {
+            m_StatusMessage->setText(tr("正在建立 %1 的资源索引。").arg(QFileInfo(root).fileName()));
+        } else if (!xref.load()) {
+            if (!xref.exists() && QFile::exists(QDir(root).filePath("res/values/public.xml"))) {
+                buildResourceXref(root);
+            }
+        } else if (m_XrefModified.contains(root) && (m_XrefModified.value(root) > m_XrefBuilt.value(root, xref.modified()))) {
+            // 索引建立后又保存过 smali 文件或 public.xml，引用和行号可能已经变化
+            buildResourceXref(root);
+            m_StatusMessage->setText(tr("正在建立 %1 的资源索引。").arg(QFileInfo(root).fileName()));
+        } else if (const quint32 id = xref.find(target.isEmpty() ? edit->textCursor().block().text() : target)) {
+            const QString name = xref.name(id);
+            QList<SmaliSymbol> symbols;
+            foreach (const ResourceReference &reference, xref.references(id)) {
+                symbols.append(SmaliSymbol{'r', reference.line, name, reference.path});
+            }
+            auto dialog = new SymbolSearchDialog(SmaliIndex(root), SymbolSearchDialog::Usages, this);
+            dialog->setResults(QString("%1 (0x%2)").arg(name).arg(id, 8, 16, QChar('0')), symbols);
+            dialog->show();
+            return;
+        }
+    }
+    if (target.isEmpty()) {
+        const QString owner = SmaliIndex::target(edit->document()->firstBlock().text(), QString());
+        target = SmaliIndex::target(edit->textCursor().block().text(), owner);
+    }
+    auto dialog = new SymbolSearchDialog(m_ProjectsModel->smaliIndex(edit->filePath()), SymbolSearchDialog::Usages, this);
+    dialog->setQuery(target);
+    dialog->show();
+}
+
 void MainWindow::handleActionFolder()
 {
     QSettings settings;
@@ -699,6 +827,14 @@ void MainWindow::handleActionFolder()
 void MainWindow::handleActionGoto()
 {
     auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
+    auto large = dynamic_cast<LargeTextEdit *>(m_TabEditors->currentWidget());
+    if (large) {
+        const int line = QInputDialog::getInt(this, tr("转到行"), tr("输入行号："), int(large->cursorLine() + 1), 1, int(qMin<qint64>(large->lineCount(), INT_MAX)));
+        if (line > 0) {
+            large->gotoLine(line);
+        }
+        return;
+    }
     QTextCursor cursor = edit->textCursor();
     const int line = QInputDialog::getInt(this, tr("转到行"), tr("输入行号："), cursor.blockNumber() + 1, 1, edit->document()->lineCount());
     if (line > 0) {
@@ -706,10 +842,29 @@ void MainWindow::handleActionGoto()
     }
 }
 
+void MainWindow::handleActionGotoSymbol()
+{
+    QString path;
+    if (auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget())) {
+        path = edit->filePath();
+    }
+    const QStringList roots = getProjectRoots();
+    if (path.isEmpty() && !roots.isEmpty()) {
+        path = roots.first();
+    }
+    SmaliIndex index = m_ProjectsModel->smaliIndex(path);
+    if (index.isEmpty() && roots.isEmpty()) {
+        QMessageBox::information(this, tr("转到符号"), tr("没有打开的项目文件夹。请先打开一个项目。"));
+        return;
+    }
+    auto dialog = new SymbolSearchDialog(index, SymbolSearchDialog::Definitions, this);
+    dialog->show();
+}
+
 void MainWindow::handleActionInstall()
 {
-    auto selected = m_ProjectsTree->selectedItems().first();
-    const QString path = selected->data(0, Qt::UserRole + 2).toString();
+    auto selected = m_ProjectsTree->selectionModel()->selectedIndexes().first();
+    const QString path = selected.data(Qt::UserRole + 2).toString();
 #ifdef QT_DEBUG
     qDebug() << "用户希望安装" << path;
 #endif
@@ -774,39 +929,34 @@ void MainWindow::handleActionInstallFramework()
         return;
     }
     
-    QString heap("-Xmx%1m");
-    heap = heap.arg(QString::number(ProcessUtils::javaHeapSize()));
-    QStringList args;
-    args << heap << "-jar" << apktool;
-    args << "if" << QDir::toNativeSeparators(frameworkPath);
-    if (!tag.trimmed().isEmpty()) {
-        args << "-t" << tag.trimmed();
-    }
-    
-    ProcessResult result = ProcessUtils::runCommand(java, args);
-    
-    if (result.code == 0) {
-        QString message = tr("框架安装成功！");
-        if (!result.output.isEmpty()) {
-            message += "\n\n" + result.output.join("\n");
-        }
-        QMessageBox::information(this, tr("成功"), message);
-    } else {
-        QString error = tr("框架安装失败！");
-        if (!result.error.isEmpty()) {
-            error += "\n\n" + result.error.join("\n");
-        } else if (!result.output.isEmpty()) {
-            error += "\n\n" + result.output.join("\n");
-        }
-        QMessageBox::warning(this, tr("错误"), error);
-    }
+    // apktool 在后台线程运行，界面线程不再嵌套事件循环等待
+    auto thread = new QThread();
+    auto worker = new FrameworkInstallWorker(frameworkPath, tag.trimmed());
+    worker->moveToThread(thread);
+    connect(worker, &FrameworkInstallWorker::frameworkInstallFailed, this, &MainWindow::handleFrameworkInstallFailed);
+    connect(worker, &FrameworkInstallWorker::frameworkInstallFinished, this, &MainWindow::handleFrameworkInstallFinished);
+    connect(thread, &QThread::started, worker, &FrameworkInstallWorker::install);
+    connect(worker, &FrameworkInstallWorker::finished, thread, &QThread::quit);
+    connect(worker, &FrameworkInstallWorker::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    thread->start();
+    m_ProgressDialog = new QProgressDialog(this);
+    m_ProgressDialog->setCancelButton(nullptr);
+    m_ProgressDialog->setLabelText(tr("正在运行 apktool..."));
+    m_ProgressDialog->setRange(0, 100);
+    m_ProgressDialog->setValue(50);
+    m_ProgressDialog->setWindowFlags(m_ProgressDialog->windowFlags() & ~Qt::WindowCloseButtonHint);
+    m_ProgressDialog->setWindowTitle(tr("安装框架"));
+    m_ProgressDialog->exec();
 }
 
 void MainWindow::handleActionPaste()
 {
     auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
-    if (edit->canPaste()) {
+    if (edit && edit->canPaste()) {
         edit->paste();
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(m_TabEditors->currentWidget())) {
+        large->paste();
     }
 }
 
@@ -818,7 +968,11 @@ void MainWindow::handleActionQuit()
 void MainWindow::handleActionRedo()
 {
     auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
-    edit->redo();
+    if (edit) {
+        edit->redo();
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(m_TabEditors->currentWidget())) {
+        large->redo();
+    }
 }
 
 void MainWindow::handleActionReplace()
@@ -835,16 +989,22 @@ void MainWindow::handleActionReportIssues()
 void MainWindow::handleActionSave()
 {
     auto i = m_TabEditors->currentIndex();
-    if (i >= 0) {
-        saveTab(i);
+    if ((i >= 0) && !saveTab(i)) {
+        m_StatusMessage->setText(tr("保存 %1 失败。").arg(m_TabEditors->tabText(i)));
     }
 }
 
 void MainWindow::handleActionSaveAll()
 {
     int i = m_TabEditors->count();
+    QStringList failed;
     for (int j = 0; j < i; j++) {
-        saveTab(j);
+        if (!saveTab(j)) {
+            failed.append(m_TabEditors->tabText(j));
+        }
+    }
+    if (!failed.isEmpty()) {
+        m_StatusMessage->setText(tr("保存 %1 失败。").arg(failed.join(", ")));
     }
 }
 
@@ -860,8 +1020,8 @@ void MainWindow::handleActionSettings()
 
 void MainWindow::handleActionSign()
 {
-    auto selected = m_ProjectsTree->selectedItems().first();
-    const QString path = selected->data(0, Qt::UserRole + 2).toString();
+    auto selected = m_ProjectsTree->selectionModel()->selectedIndexes().first();
+    const QString path = selected.data(Qt::UserRole + 2).toString();
 #ifdef QT_DEBUG
     qDebug() << "用户希望签名" << path;
 #endif
@@ -898,7 +1058,11 @@ void MainWindow::handleActionSign()
 void MainWindow::handleActionUndo()
 {
     auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
-    edit->undo();
+    if (edit) {
+        edit->undo();
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(m_TabEditors->currentWidget())) {
+        large->undo();
+    }
 }
 
 void MainWindow::handleClipboardDataChanged()
@@ -909,28 +1073,34 @@ void MainWindow::handleClipboardDataChanged()
     auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
     if (edit) {
         m_ActionPaste->setEnabled(edit && edit->canPaste());
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(m_TabEditors->currentWidget())) {
+        m_ActionPaste->setEnabled(large->canPaste());
     }
 }
 
 void MainWindow::handleCommandFinished(const ProcessResult &result)
 {
+    // 标准输出已经通过 handleCommandOutput 实时显示，这里只输出错误和退出代码
     if (!result.error.isEmpty()) {
         m_EditConsole->setTextColor(QColor(COLOR_ERROR));
         foreach (auto line, result.error) {
             m_EditConsole->append(line);
         }
     }
-    if (!result.output.isEmpty()) {
-        m_EditConsole->setTextColor(QColor(COLOR_OUTPUT));
-        foreach (auto line, result.output) {
-            m_EditConsole->append(line);
-        }
-    }
     m_EditConsole->setTextColor(QColor(COLOR_CODE));
     m_EditConsole->append(QString("进程退出，代码 %1。").arg(result.code));
     m_EditConsole->append(QString());
 }
 
+void MainWindow::handleCommandOutput(const QStringList &lines)
+{
+    m_EditConsole->setTextColor(QColor(COLOR_OUTPUT));
+    foreach (auto line, lines) {
+        m_EditConsole->append(line);
+    }
+    ProcessOutput::instance()->releaseCommandOutput();
+}
+
 void MainWindow::handleCommandStarting(const QString &exe, const QStringList &args)
 {
     QString line = "$ " + exe;
@@ -953,6 +1123,8 @@ void MainWindow::handleCursorPositionChanged()
         QTextCursor cursor = edit->textCursor();
         const QString position = QString("%1:%2").arg(cursor.blockNumber() + 1).arg(cursor.positionInBlock() + 1);
         m_StatusCursor->setText(position);
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(m_TabEditors->currentWidget())) {
+        m_StatusCursor->setText(QString("%1:%2").arg(large->cursorLine() + 1).arg(large->cursorColumn() + 1));
     } else {
         m_StatusCursor->setText("0:0");
     }
@@ -972,6 +1144,7 @@ void MainWindow::handleDecompileFinished(const QString &apk, const QString &fold
     m_ProgressDialog->close();
     m_ProgressDialog->deleteLater();
     m_StatusMessage->setText(tr("反编译完成。"));
+    buildResourceXref(folder);
     openProject(folder);
 }
 
@@ -1023,48 +1196,114 @@ void MainWindow::handleFilesSelectionChanged(const QItemSelection &selected, con
     }
 }
 
+void MainWindow::handleFileSaved(const QString &path, const QByteArray &hash, const bool success)
+{
+#ifdef QT_DEBUG
+    qDebug() << "保存完成" << path << success;
+#endif
+    const QString name = QFileInfo(path).fileName();
+    auto widget = findTabWidget(path);
+    if (auto edit = dynamic_cast<SourceCodeEdit *>(widget)) {
+        edit->setSaved(hash, success);
+    } else if (auto hex = dynamic_cast<HexEdit *>(widget)) {
+        hex->setSaved(hash, success);
+    }
+    if (!success) {
+        m_StatusMessage->setText(tr("保存 %1 失败。").arg(name));
+        return;
+    }
+    m_StatusMessage->setText(tr("已保存 %1。").arg(name));
+    const QString root = findProjectRoot(path);
+    if (!root.isEmpty() && path.endsWith(".smali", Qt::CaseInsensitive)) {
+        // 只重新解析这个文件，并把它的符号追加到项目的索引日志中
+        m_ProjectsModel->indexSmali(root, path);
+    }
+    if (!root.isEmpty() && (path.endsWith(".smali", Qt::CaseInsensitive) || (name == "public.xml"))) {
+        // 资源交叉索引在下次查找引用时重新建立
+        m_XrefModified.insert(root, QDateTime::currentDateTime());
+    }
+    if (!root.isEmpty() && FindInFilesWorker::isTextFile(name)) {
+        // 全文搜索直接扫描保存过的文件，三元组索引在后台更新时再重新读取它
+        TrigramIndex::markDirty(root, QStringList(path));
+    }
+}
+
 void MainWindow::handleFilesSearchChanged(const QString &text)
 {
     m_FilesProxyModel->setFilterFixedString(text);
 }
 
+void MainWindow::handleLargeTextOpenFailed(const QString &path)
+{
+    // 文件无法映射时不保留标签页
+    m_StatusMessage->setText(tr("无法打开 %1。").arg(QFileInfo(path).fileName()));
+    handleTabCloseRequested(findTabIndex(path));
+}
+
+void MainWindow::handleOutlineActivated(QListWidgetItem *item)
+{
+    auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
+    if (edit) {
+        edit->gotoLine(item->data(Qt::UserRole).toInt());
+        edit->setFocus();
+    }
+}
+
 void MainWindow::handleProjectsSearchChanged(const QString &text)
 {
-    for (int i = 0; i < m_ProjectsTree->topLevelItemCount(); ++i) {
-        filterProjectTreeItems(m_ProjectsTree->topLevelItem(i), text);
+    if (text.isEmpty()) {
+        m_SearchProjectsTimer->stop();
+        filterProjectTreeItems(text);
+    } else {
+        m_SearchProjectsTimer->start();
     }
 }
 
-void MainWindow::filterProjectTreeItems(QTreeWidgetItem *item, const QString &filter)
+void MainWindow::filterProjectTreeItems(const QString &filter)
 {
-    if (!item) {
+    if (filter.isEmpty()) {
+        m_ProjectsModel->cancelMatch();
+        m_ProjectsProxyModel->clearFilterPaths();
         return;
     }
-    
-    bool visible = false;
-    QString itemText = item->text(0);
-    
-    // 检查此项是否匹配过滤器
-    if (filter.isEmpty() || itemText.contains(filter, Qt::CaseInsensitive)) {
-        visible = true;
-    }
-    
-    // 递归检查子项
-    for (int i = 0; i < item->childCount(); ++i) {
-        QTreeWidgetItem *child = item->child(i);
-        filterProjectTreeItems(child, filter);
-        // 如果有任何子项可见，则此项也应当可见
-        if (!child->isHidden()) {
-            visible = true;
+    // 在后台建立的文件名索引中查找，只把命中项及其上级目录交给视图
+    m_ProjectsProxyModel->setFilterPaths(m_ProjectsModel->match(filter, PROJECT_FILTER_MAX_MATCHES));
+    // 展开仍有可见子项的目录，使匹配项直接可见
+    QList<QModelIndex> pending;
+    pending.append(QModelIndex());
+    while (!pending.isEmpty()) {
+        const QModelIndex parent = pending.takeLast();
+        const int count = m_ProjectsProxyModel->rowCount(parent);
+        for (int i = 0; i < count; ++i) {
+            const QModelIndex child = m_ProjectsProxyModel->index(i, 0, parent);
+            if (m_ProjectsProxyModel->rowCount(child) > 0) {
+                m_ProjectsTree->expand(child);
+                pending.append(child);
+            }
         }
     }
-    
-    item->setHidden(!visible);
-    
-    // 如果此项可见，展开其父项
-    if (visible && item->parent()) {
-        item->parent()->setExpanded(true);
+}
+
+void MainWindow::handleFrameworkInstallFailed(const QString &output)
+{
+    m_ProgressDialog->close();
+    m_ProgressDialog->deleteLater();
+    QString error = tr("框架安装失败！");
+    if (!output.isEmpty()) {
+        error += "\n\n" + output;
+    }
+    QMessageBox::warning(this, tr("错误"), error);
+}
+
+void MainWindow::handleFrameworkInstallFinished(const QString &output)
+{
+    m_ProgressDialog->close();
+    m_ProgressDialog->deleteLater();
+    QString message = tr("框架安装成功！");
+    if (!output.isEmpty()) {
+        message += "\n\n" + output;
     }
+    QMessageBox::information(this, tr("成功"), message);
 }
 
 void MainWindow::handleInstallFailed(const QString &apk)
@@ -1097,41 +1336,22 @@ void MainWindow::handleRecompileFinished(const QString &folder)
     m_ProgressDialog->close();
     m_ProgressDialog->deleteLater();
     m_StatusMessage->setText(tr("重新编译完成。"));
-    QTreeWidgetItem *focus = nullptr;
-    for (int i = 0; i < m_ProjectsTree->topLevelItemCount(); i++) {
-        auto parent = m_ProjectsTree->topLevelItem(i);
-        if (folder != parent->data(0, Qt::UserRole + 2).toString()) {
-            continue;
-        }
+    const QModelIndex project = m_ProjectsModel->project(folder);
+    if (!project.isValid()) {
+        return;
+    }
 #ifdef QT_DEBUG
-        qDebug() << "找到项目" << folder;
+    qDebug() << "找到项目" << folder;
 #endif
-        reloadChildren(parent);
-        auto dist = m_ProjectsTree->findItems(".apk", Qt::MatchEndsWith | Qt::MatchRecursive, 0);
-        foreach (auto child, dist) {
-            if (child->data(0, Qt::UserRole + 1).toInt() == File) {
-                const QString path = child->data(0, Qt::UserRole + 2).toString();
+    m_ProjectsModel->reload(project);
+    // 项目树按需加载，直接在 dist 目录中查找输出文件，再逐级展开定位
+    QDir dist(QDir(folder).filePath("dist"));
+    const QFileInfoList apks = dist.entryInfoList(QStringList() << "*.apk", QDir::Files);
+    if (!apks.isEmpty()) {
 #ifdef QT_DEBUG
-                qDebug() << "找到文件" << path;
+        qDebug() << "找到文件" << apks.first().absoluteFilePath();
 #endif
-                if (path.startsWith(folder)) {
-                    focus = child;
-                    break;
-                }
-            }
-        }
-    }
-    if (focus) {
-        auto parent = focus->parent();
-        while (parent) {
-            if (!parent->isExpanded()) {
-                m_ProjectsTree->expandItem(parent);
-            }
-            parent = parent->parent();
-        }
-        m_ProjectsTree->scrollToItem(focus);
-        m_ProjectsTree->selectionModel()->clearSelection();
-        focus->setSelected(true);
+        m_ProjectsModel->reveal(apks.first().absoluteFilePath());
     }
 }
 
@@ -1149,13 +1369,10 @@ void MainWindow::handleSignFinished(const QString &apk)
     m_ProgressDialog->close();
     m_ProgressDialog->deleteLater();
     m_StatusMessage->setText(tr("签名完成。"));
-    auto selected = m_ProjectsTree->selectedItems().first();
-    auto parent = selected->parent();
-    reloadChildren(parent);
-    selected = parent->child(0);
-    m_ProjectsTree->scrollToItem(selected);
-    m_ProjectsTree->selectionModel()->clearSelection();
-    selected->setSelected(true);
+    auto selected = m_ProjectsTree->selectionModel()->selectedIndexes().first();
+    const QString path = selected.data(Qt::UserRole + 2).toString();
+    m_ProjectsModel->reload(m_ProjectsProxyModel->mapToSource(selected.parent()));
+    m_ProjectsModel->reveal(path);
 }
 
 void MainWindow::handleTabChanged(const int index)
@@ -1168,8 +1385,11 @@ void MainWindow::handleTabChanged(const int index)
     auto edit = dynamic_cast<SourceCodeEdit *>(widget);
     auto hex = dynamic_cast<HexEdit *>(widget);
     auto viewer = dynamic_cast<ImageViewerWidget *>(widget);
+    auto large = dynamic_cast<LargeTextEdit *>(widget);
     if (edit) {
         path = edit->filePath();
+    } else if (large) {
+        path = large->filePath();
     } else if (hex) {
         path = hex->filePath();
     } else if (viewer) {
@@ -1203,9 +1423,11 @@ void MainWindow::handleTabChanged(const int index)
     m_ActionUndo->setEnabled(false);
     m_ActionFind->setEnabled(edit);
     m_ActionReplace->setEnabled(edit);
-    m_ActionSave->setEnabled(edit || hex);
-    m_ActionSaveAll->setEnabled(edit || hex);
-    m_ActionGoto->setEnabled(edit);
+    m_ActionSave->setEnabled(edit || large || hex);
+    m_ActionSaveAll->setEnabled(edit || large || hex);
+    m_ActionGoto->setEnabled(edit || large);
+    m_ActionFindUsages->setEnabled(edit);
+    updateOutline();
     for (auto conn: m_EditorConnections) {
         disconnect(conn);
     }
@@ -1225,6 +1447,17 @@ void MainWindow::handleTabChanged(const int index)
         if (m_FindReplaceDialog) {
             m_FindReplaceDialog->setTextEdit(edit);
         }
+    } else if (large) {
+        m_EditorConnections << connect(large, &LargeTextEdit::copyAvailable, m_ActionCopy, &QAction::setEnabled);
+        m_EditorConnections << connect(large, &LargeTextEdit::copyAvailable, m_ActionCut, &QAction::setEnabled);
+        m_EditorConnections << connect(large, &LargeTextEdit::redoAvailable, m_ActionRedo, &QAction::setEnabled);
+        m_EditorConnections << connect(large, &LargeTextEdit::undoAvailable, m_ActionUndo, &QAction::setEnabled);
+        m_EditorConnections << connect(large, &LargeTextEdit::cursorPositionChanged, this, &MainWindow::handleCursorPositionChanged);
+        m_ActionCut->setEnabled(large->hasSelection());
+        m_ActionCopy->setEnabled(large->hasSelection());
+        m_ActionPaste->setEnabled(large->canPaste());
+        m_ActionRedo->setEnabled(large->isRedoAvailable());
+        m_ActionUndo->setEnabled(large->isUndoAvailable());
     }
     handleCursorPositionChanged();
 }
@@ -1239,8 +1472,11 @@ void MainWindow::handleTabCloseRequested(const int index)
     auto edit = dynamic_cast<SourceCodeEdit *>(widget);
     auto hex = dynamic_cast<HexEdit *>(widget);
     auto viewer = dynamic_cast<ImageViewerWidget *>(widget);
+    auto large = dynamic_cast<LargeTextEdit *>(widget);
     if (edit) {
         path = edit->filePath();
+    } else if (large) {
+        path = large->filePath();
     } else if (hex) {
         path = hex->filePath();
     } else if (viewer) {
@@ -1274,6 +1510,8 @@ void MainWindow::handleTabCloseRequested(const int index)
     m_ActionCopy->setEnabled(false);
     m_ActionPaste->setEnabled(false);
     m_TabEditors->removeTab(index);
+    // 编辑器销毁时同时取消仍在进行的后台读取
+    widget->deleteLater();
     if (m_TabEditors->count() == 0) {
         m_CentralStack->setCurrentIndex(0);
         // 关闭所有标签页时清除搜索框
@@ -1289,12 +1527,12 @@ void MainWindow::handleTabCloseRequested(const int index)
 void MainWindow::handleTreeContextMenu(const QPoint &point)
 {
     QMenu menu(this);
-    auto item = m_ProjectsTree->itemAt(point);
-    if (item) {
-        const int type = item->data(0, Qt::UserRole + 1).toInt();
-        const QString path = item->data(0, Qt::UserRole + 2).toString();
+    const QPersistentModelIndex item = m_ProjectsTree->indexAt(point);
+    if (item.isValid()) {
+        const int type = item.data(Qt::UserRole + 1).toInt();
+        const QString path = item.data(Qt::UserRole + 2).toString();
 #ifdef QT_DEBUG
-        qDebug() << "为" << item->text(0) << "在" << point << "请求上下文菜单";
+        qDebug() << "为" << item.data().toString() << "在" << point << "请求上下文菜单";
 #endif
         if (type == File) {
             auto open = menu.addAction(tr("打开"));
@@ -1342,7 +1580,7 @@ void MainWindow::handleTreeContextMenu(const QPoint &point)
         if (type != File) {
             auto refresh = menu.addAction(tr("刷新"));
             connect(refresh, &QAction::triggered, [=] {
-                reloadChildren(item);
+                m_ProjectsModel->reload(m_ProjectsProxyModel->mapToSource(item));
             });
         }
     } else {
@@ -1353,10 +1591,10 @@ void MainWindow::handleTreeContextMenu(const QPoint &point)
         menu.addSeparator();
     }
     auto collapse = menu.addAction(tr("全部折叠"));
-    if (m_ProjectsTree->topLevelItemCount() == 0) {
+    if (m_ProjectsModel->rowCount() == 0) {
         collapse->setEnabled(false);
     } else {
-        connect(collapse, &QAction::triggered, m_ProjectsTree, &QTreeWidget::collapseAll);
+        connect(collapse, &QAction::triggered, m_ProjectsTree, &QTreeView::collapseAll);
     }
     menu.exec(m_ProjectsTree->mapToGlobal(point));
 }
@@ -1378,6 +1616,25 @@ void MainWindow::handleTreeDoubleClicked(const QModelIndex &index)
     }
 }
 
+void MainWindow::handleTreePathRevealed(const QModelIndex &source)
+{
+    // 被搜索过滤隐藏的项无法定位
+    const QModelIndex index = m_ProjectsProxyModel->mapFromSource(source);
+    if (!index.isValid()) {
+        return;
+    }
+    auto parent = index.parent();
+    while (parent.isValid()) {
+        if (!m_ProjectsTree->isExpanded(parent)) {
+            m_ProjectsTree->expand(parent);
+        }
+        parent = parent.parent();
+    }
+    m_ProjectsTree->scrollTo(index);
+    m_ProjectsTree->selectionModel()->clearSelection();
+    m_ProjectsTree->selectionModel()->select(index, QItemSelectionModel::Select);
+}
+
 void MainWindow::handleTreeSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected)
 {
     Q_UNUSED(deselected)
@@ -1393,6 +1650,70 @@ void MainWindow::handleTreeSelectionChanged(const QItemSelection &selected, cons
     m_ActionSign->setEnabled(apk);
 }
 
+void MainWindow::handleVersionResolved(const QString &binary, const QString &version)
+{
+    m_Versions.insert(binary, version);
+    auto label = m_VersionLabels.value(binary);
+    if (label) {
+        label->setText(label->property("title").toString().append(": ").append(version));
+    }
+}
+
+void MainWindow::handleVersionResolveFinished()
+{
+    bool missing = false;
+    foreach (const QString &binary, m_Versions.keys()) {
+        if (m_Versions[binary].isEmpty()) {
+#ifdef QT_DEBUG
+            qDebug() << binary << "缺失";
+#endif
+            missing = true;
+            break;
+        }
+    }
+    if (missing) {
+        QMessageBox msgBox(this);
+        msgBox.setWindowTitle(tr("需求"));
+        msgBox.setText(tr("一个或多个必需的第三方二进制文件缺失。"));
+        msgBox.setInformativeText(tr("是否要自动下载它们或手动配置？"));
+        QPushButton *downloadButton = msgBox.addButton(tr("下载"), QMessageBox::AcceptRole);
+        QPushButton *settingsButton = msgBox.addButton(tr("设置"), QMessageBox::ActionRole);
+        msgBox.addButton(tr("取消"), QMessageBox::RejectRole);
+        
+        int result = msgBox.exec();
+        if (msgBox.clickedButton() == downloadButton) {
+            // 下载所有缺失的工具
+            QList<ToolDownloadWorker::ToolType> toolsToDownload;
+            foreach (const QString &binary, m_Versions.keys()) {
+                if (m_Versions[binary].isEmpty()) {
+                    if (binary == "java") {
+                        toolsToDownload.append(ToolDownloadWorker::Java);
+                    } else if (binary == "apktool") {
+                        toolsToDownload.append(ToolDownloadWorker::Apktool);
+                    } else if (binary == "jadx") {
+                        toolsToDownload.append(ToolDownloadWorker::Jadx);
+                    } else if (binary == "adb") {
+                        toolsToDownload.append(ToolDownloadWorker::Adb);
+                    } else if (binary == "uas") {
+                        toolsToDownload.append(ToolDownloadWorker::UberApkSigner);
+                    }
+                }
+            }
+            
+            if (!toolsToDownload.isEmpty()) {
+                ToolDownloadDialog downloadDialog(toolsToDownload, this);
+                if (downloadDialog.exec() == QDialog::Accepted && downloadDialog.wasSuccessful()) {
+                    // 重启应用以检测新下载的工具
+                    QApplication::exit(CODE_RESTART);
+                }
+            }
+        } else if (msgBox.clickedButton() == settingsButton) {
+            // 设置
+            (new SettingsDialog(1, this))->exec();
+        }
+    }
+}
+
 void MainWindow::openFile(const QString &path)
 {
 #ifdef QT_DEBUG
@@ -1409,19 +1730,55 @@ void MainWindow::openFile(const QString &path)
     QFileInfo info(path);
     QWidget *widget;
     const QString extension = info.suffix();
-    if (!extension.isEmpty() && QString(IMAGE_EXTENSIONS).contains(extension, Qt::CaseInsensitive)) {
-        auto viewer = new ImageViewerWidget(this);
-        viewer->open(path);
-        viewer->zoomReset();
-        widget = viewer;
-    } else if (!extension.isEmpty() && QString(TEXT_EXTENSIONS).contains(extension, Qt::CaseInsensitive)) {
-        auto editor = new SourceCodeEdit(this);
-        editor->open(path);
-        widget = editor;
-    } else {
+    const bool image = !extension.isEmpty() && QString(IMAGE_EXTENSIONS).contains(extension, Qt::CaseInsensitive);
+    const bool text = !extension.isEmpty() && QString(TEXT_EXTENSIONS).contains(extension, Qt::CaseInsensitive);
+    const bool large = text && (info.size() > LARGE_TEXT_FILE_SIZE);
+    if (!image && !text && HexEdit::isLargeFile(info.size())) {
+        // 大的二进制文件映射后直接编辑，打开时不需要在后台读取整个文件
         auto hex = new HexEdit(this);
         hex->open(path);
         widget = hex;
+    } else {
+        // 读取和解码在后台线程进行，标签页先以占位状态出现，关闭标签页时取消读取
+        auto thread = new QThread();
+        FileOpenWorker *worker;
+        if (image) {
+            auto viewer = new ImageViewerWidget(this);
+            viewer->setLoading(path);
+            worker = new FileOpenWorker(path, FileOpenWorker::Image);
+            connect(worker, &FileOpenWorker::imageOpened, viewer, QOverload<const QString &, const QImage &>::of(&ImageViewerWidget::open));
+            widget = viewer;
+        } else if (large) {
+            // 超大文本文件使用映射加片段表的编辑器，只解码可见的行；换行符索引在后台建立
+            auto edit = new LargeTextEdit(this);
+            edit->setLoading(path);
+            worker = new FileOpenWorker(path, FileOpenWorker::LargeText);
+            connect(worker, &FileOpenWorker::largeTextOpened, edit, &LargeTextEdit::open);
+            connect(edit, &LargeTextEdit::openFailed, this, &MainWindow::handleLargeTextOpenFailed);
+            connect(edit, &LargeTextEdit::fileSaved, this, [=](const QString &file, const bool success) {
+                handleFileSaved(file, QByteArray(), success);
+            });
+            widget = edit;
+        } else if (text) {
+            auto editor = new SourceCodeEdit(this);
+            editor->setLoading(path);
+            worker = new FileOpenWorker(path, FileOpenWorker::Text);
+            connect(worker, &FileOpenWorker::textOpened, editor, QOverload<const QString &, const QString &, const QByteArray &>::of(&SourceCodeEdit::open));
+            widget = editor;
+        } else {
+            auto hex = new HexEdit(this);
+            hex->setLoading(path);
+            worker = new FileOpenWorker(path, FileOpenWorker::Binary);
+            connect(worker, &FileOpenWorker::binaryOpened, hex, QOverload<const QString &, const QByteArray &, const QByteArray &>::of(&HexEdit::open));
+            widget = hex;
+        }
+        worker->moveToThread(thread);
+        connect(widget, &QObject::destroyed, thread, &QThread::requestInterruption);
+        connect(thread, &QThread::started, worker, &FileOpenWorker::open);
+        connect(worker, &FileOpenWorker::finished, thread, &QThread::quit);
+        connect(worker, &FileOpenWorker::finished, worker, &QObject::deleteLater);
+        connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+        thread->start();
     }
     const QIcon icon = m_FileIconProvider.icon(info);
     auto item = new QStandardItem(icon, info.fileName());
@@ -1445,6 +1802,25 @@ void MainWindow::openFile(const QString &path)
     m_ActionCloseAll->setEnabled(true);
 }
 
+void MainWindow::openFileAt(const QString &path, const int line)
+{
+    openFile(path);
+    // 文本在后台读取完成后才能跳转到对应行
+    auto widget = findTabWidget(path);
+    if (auto edit = dynamic_cast<SourceCodeEdit *>(widget)) {
+        if (edit->isLoading()) {
+            connect(edit, &SourceCodeEdit::loaded, edit, [edit, line] {
+                edit->gotoLine(line);
+            }, Qt::SingleShotConnection);
+        } else {
+            edit->gotoLine(line);
+        }
+        edit->setFocus();
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(widget)) {
+        large->gotoLine(line);
+    }
+}
+
 void MainWindow::openFindReplaceDialog(QPlainTextEdit *edit, const bool replace)
 {
     if (!m_FindReplaceDialog) {
@@ -1471,15 +1847,8 @@ void MainWindow::openProject(const QString &folder, const bool last)
     QSettings settings;
     settings.setValue("open_project", folder);
     settings.sync();
-    QFileInfo info(folder);
-    QTreeWidgetItem *item = new QTreeWidgetItem(m_ProjectsTree);
-    item->setData(0, Qt::UserRole + 1, Project);
-    item->setData(0, Qt::UserRole + 2, folder);
-    item->setIcon(0, m_FileIconProvider.icon(info));
-    item->setText(0, info.fileName());
-    reloadChildren(item);
-    m_ProjectsTree->addTopLevelItem(item);
-    m_ProjectsTree->expandItem(item);
+    // 只加载项目根目录，子目录在展开时由后台线程枚举
+    m_ProjectsTree->expand(m_ProjectsProxyModel->mapFromSource(m_ProjectsModel->addProject(folder)));
     m_ActionBuild1->setEnabled(true);
     m_ActionBuild2->setEnabled(true);
     QDir dir(folder);
@@ -1492,60 +1861,65 @@ void MainWindow::openProject(const QString &folder, const bool last)
     updateWindowTitle();
 }
 
-void MainWindow::reloadChildren(QTreeWidgetItem *item)
-{
-    while (item->childCount()) {
-        qDeleteAll(item->takeChildren());
-    }
-    QDir dir(item->data(0, Qt::UserRole + 2).toString());
-    if (dir.exists()) {
-        QFileInfoList files = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot, QDir::DirsFirst);
-        foreach (auto info, files) {
-            QTreeWidgetItem *child = new QTreeWidgetItem(item);
-            child->setData(0, Qt::UserRole + 1, info.isDir() ? Folder : File);
-            child->setData(0, Qt::UserRole + 2, info.absoluteFilePath());
-            child->setIcon(0, m_FileIconProvider.icon(info));
-            child->setText(0, info.fileName());
-            const QString tooltip = QString("%1 - %2")
-                    .arg(QDir::toNativeSeparators(info.filePath()))
-                    .arg(QLocale::system().formattedDataSize(info.size(), 2, QLocale::DataSizeTraditionalFormat));
-            child->setToolTip(0, tooltip);
-            item->addChild(child);
-            if (info.isDir()) {
-                reloadChildren(child);
-            }
-        }
-    }
-}
-
 bool MainWindow::saveTab(int i)
 {
     auto widget = m_TabEditors->widget(i);
-    auto edit = dynamic_cast<SourceCodeEdit *>(widget);
-    if (edit) {
-        return edit->save();
-    } else {
-        auto hex = dynamic_cast<HexEdit *>(widget);
-        if (hex) {
+    QList<QByteArray> chunks;
+    QByteArray hash;
+    QString path;
+    if (auto edit = dynamic_cast<SourceCodeEdit *>(widget)) {
+        if (!edit->snapshot(chunks, hash)) {
+            return !edit->isLoading();
+        }
+        path = edit->filePath();
+    } else if (auto large = dynamic_cast<LargeTextEdit *>(widget)) {
+        return large->save();
+    } else if (auto hex = dynamic_cast<HexEdit *>(widget)) {
+        if (hex->isStreamed()) {
             return hex->save();
         }
+        if (!hex->snapshot(chunks, hash)) {
+            return true;
+        }
+        path = hex->filePath();
+    } else {
+        return true;
     }
+    // 界面线程只负责把内容编码成分块，写入和替换文件在后台线程进行
+    m_StatusMessage->setText(tr("正在保存 %1...").arg(QFileInfo(path).fileName()));
+    emit saveRequested(path, chunks, hash);
     return true;
 }
 
+void MainWindow::updateOutline()
+{
+    m_ListOutline->clear();
+    auto edit = dynamic_cast<SourceCodeEdit *>(m_TabEditors->currentWidget());
+    if (!edit || !edit->filePath().endsWith(".smali", Qt::CaseInsensitive)) {
+        return;
+    }
+    const QList<SmaliSymbol> symbols = m_ProjectsModel->smaliIndex(edit->filePath()).outline(edit->filePath());
+    foreach (const SmaliSymbol &symbol, symbols) {
+        // 成员只显示类名之后的部分，完整签名放在提示中
+        const int arrow = symbol.name.indexOf("->");
+        const QString text = (arrow < 0) ? symbol.name : QString("    ").append(symbol.name.mid(arrow + 2));
+        auto item = new QListWidgetItem(text, m_ListOutline);
+        item->setData(Qt::UserRole, symbol.line);
+        item->setToolTip(symbol.name);
+    }
+}
+
 void MainWindow::updateWindowTitle()
 {
     QString title = tr("APK Studio by VPZ");
     
     // 从树中获取第一个（最近）项目
-    if (m_ProjectsTree->topLevelItemCount() > 0) {
-        QTreeWidgetItem *firstProject = m_ProjectsTree->topLevelItem(0);
-        if (firstProject) {
-            QString projectFolder = firstProject->data(0, Qt::UserRole + 2).toString();
-            if (!projectFolder.isEmpty()) {
-                QFileInfo info(projectFolder);
-                title += tr(" - %1").arg(info.fileName());
-            }
+    const QStringList projects = m_ProjectsModel->projects();
+    if (!projects.isEmpty()) {
+        QString projectFolder = projects.first();
+        if (!projectFolder.isEmpty()) {
+            QFileInfo info(projectFolder);
+            title += tr(" - %1").arg(info.fileName());
         }
     }
     
@@ -1711,20 +2085,22 @@ QWidget* MainWindow::findTabWidget(const QString& path)
     return nullptr;
 }
 
+QString MainWindow::findProjectRoot(const QString &path)
+{
+    foreach (auto root, getProjectRoots()) {
+        if (path.startsWith(root + '/')) {
+            return root;
+        }
+    }
+    return QString();
+}
+
 QStringList MainWindow::getProjectRoots()
 {
     QStringList roots;
-    int count = m_ProjectsTree->topLevelItemCount();
-    for (int i = 0; i < count; i++) {
-        QTreeWidgetItem *item = m_ProjectsTree->topLevelItem(i);
-        if (item) {
-            int type = item->data(0, Qt::UserRole + 1).toInt();
-            if (type == Project) {
-                QString path = item->data(0, Qt::UserRole + 2).toString();
-                if (!path.isEmpty()) {
-                    roots.append(path);
-                }
-            }
+    foreach (auto path, m_ProjectsModel->projects()) {
+        if (!path.isEmpty()) {
+            roots.append(path);
         }
     }
     return roots;
@@ -1732,4 +2108,10 @@ QStringList MainWindow::getProjectRoots()
 
 MainWindow::~MainWindow()
 {
+    // 排在退出之前的保存请求先完成
+    QMetaObject::invokeMethod(m_SaveWorker, [=] {
+        m_SaveThread->quit();
+    }, Qt::QueuedConnection);
+    m_SaveThread->wait();
+    delete m_SaveWorker;
 }
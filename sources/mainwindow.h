@@ -1,10 +1,12 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <QDateTime>
 #include <QDockWidget>
 #include <QFileIconProvider>
 #include <QLabel>
 #include <QListView>
+#include <QListWidget>
 #include <QMainWindow>
 #include <QMap>
 #include <QProgressDialog>
@@ -13,11 +15,14 @@
 #include <QSortFilterProxyModel>
 #include <QStandardItemModel>
 #include <QTextEdit>
+#include <QThread>
+#include <QTimer>
 #include <QToolBar>
-#include <QTreeWidget>
+#include <QTreeView>
 #include <QVBoxLayout>
 #include "findreplacedialog.h"
 #include "processutils.h"
+#include "projecttreemodel.h"
 
 class MainWindow : public QMainWindow
 {
@@ -28,10 +33,11 @@ public:
         Folder,
         File
     };
-    explicit MainWindow(const QMap<QString, QString> &versions, QWidget *parent = nullptr);
+    explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
     void openApkFile(const QString &apkPath);
     void openFile(const QString &file);
+    void openFileAt(const QString &file, const int line);
     QWidget* findTabWidget(const QString& path);
 protected:
     void closeEvent(QCloseEvent *event);
@@ -45,7 +51,9 @@ private:
     QAction *m_ActionCut;
     QAction *m_ActionFind;
     QAction *m_ActionFindInFiles;
+    QAction *m_ActionFindUsages;
     QAction *m_ActionGoto;
+    QAction *m_ActionGotoSymbol;
     QAction *m_ActionInstall1;
     QAction *m_ActionInstall2;
     QAction *m_ActionPaste;
@@ -58,11 +66,13 @@ private:
     QAction *m_ActionViewProject;
     QAction *m_ActionViewFiles;
     QAction *m_ActionViewConsole;
+    QAction *m_ActionViewOutline;
     QAction *m_ActionViewToolBar;
     QStackedWidget *m_CentralStack;
     QDockWidget *m_DockProject;
     QDockWidget *m_DockFiles;
     QDockWidget *m_DockConsole;
+    QDockWidget *m_DockOutline;
     QTextEdit *m_EditConsole;
     QList<QMetaObject::Connection> m_EditorConnections;
     QFileIconProvider m_FileIconProvider;
@@ -70,22 +80,36 @@ private:
     class FindInFilesDialog *m_FindInFilesDialog;
     QLineEdit *m_SearchFiles;
     QLineEdit *m_SearchProjects;
+    QTimer *m_SearchProjectsTimer;
     QListView *m_ListOpenFiles;
+    QListWidget *m_ListOutline;
     QToolBar *m_MainToolBar;
     QStandardItemModel *m_ModelOpenFiles;
     QSortFilterProxyModel *m_FilesProxyModel;
     QProgressDialog *m_ProgressDialog;
-    QTreeWidget *m_ProjectsTree;
+    QThread *m_SaveThread;
+    class FileSaveWorker *m_SaveWorker;
+    ProjectTreeModel *m_ProjectsModel;
+    ProjectTreeFilterModel *m_ProjectsProxyModel;
+    QTreeView *m_ProjectsTree;
     QLabel *m_StatusCursor;
     QLabel *m_StatusMessage;
     QTabWidget *m_TabEditors;
+    QMap<QString, QLabel *> m_VersionLabels;
+    QMap<QString, QString> m_Versions;
+    QMap<QString, QDateTime> m_XrefBuilding;
+    QMap<QString, QDateTime> m_XrefBuilt;
+    QMap<QString, QDateTime> m_XrefModified;
     QWidget *buildCentralWidget();
     QDockWidget *buildConsoleDock();
     QDockWidget *buildFilesDock();
     QToolBar *buildMainToolBar();
     QMenuBar *buildMenuBar();
+    QDockWidget *buildOutlineDock();
     QDockWidget *buildProjectsDock();
-    QStatusBar *buildStatusBar(const QMap<QString, QString> &versions);
+    void buildResourceXref(const QString &folder);
+    QStatusBar *buildStatusBar();
+    QString findProjectRoot(const QString &path);
     int findTabIndex(const QString& path);
     QStringList getProjectRoots();
 private slots:
@@ -101,8 +125,10 @@ private slots:
     void handleActionFile();
     void handleActionFind();
     void handleActionFindInFiles();
+    void handleActionFindUsages();
     void handleActionFolder();
     void handleActionGoto();
+    void handleActionGotoSymbol();
     void handleActionInstall();
     void handleActionInstallFramework();
     void handleActionPaste();
@@ -118,14 +144,20 @@ private slots:
     void handleActionUndo();
     void handleClipboardDataChanged();
     void handleCommandFinished(const ProcessResult &result);
+    void handleCommandOutput(const QStringList &lines);
     void handleCommandStarting(const QString &exe, const QStringList &args);
     void handleCursorPositionChanged();
     void handleDecompileFailed(const QString &apk);
     void handleDecompileFinished(const QString &apk, const QString &folder);
     void handleDecompileProgress(const int percent, const QString &message);
+    void handleFileSaved(const QString &path, const QByteArray &hash, const bool success);
     void handleFilesSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
+    void handleOutlineActivated(QListWidgetItem *item);
+    void handleFrameworkInstallFailed(const QString &output);
+    void handleFrameworkInstallFinished(const QString &output);
     void handleInstallFailed(const QString &apk);
     void handleInstallFinished(const QString &apk);
+    void handleLargeTextOpenFailed(const QString &path);
     void handleRecompileFailed(const QString &folder);
     void handleRecompileFinished(const QString &folder);
     void handleSignFailed(const QString &apk);
@@ -136,17 +168,22 @@ private slots:
     void handleProjectsSearchChanged(const QString &text);
     void handleTreeContextMenu(const QPoint &point);
     void handleTreeDoubleClicked(const QModelIndex &index);
+    void handleTreePathRevealed(const QModelIndex &source);
     void handleTreeSelectionChanged(const QItemSelection &selected, const QItemSelection &deselected);
+    void handleVersionResolved(const QString &binary, const QString &version);
+    void handleVersionResolveFinished();
     void openFindReplaceDialog(QPlainTextEdit *edit, const bool replace);
     void openProject(const QString &folder, const bool last = false);
-    void reloadChildren(QTreeWidgetItem *item);
-    void filterProjectTreeItems(QTreeWidgetItem *item, const QString &filter);
+    void filterProjectTreeItems(const QString &filter);
+    void updateOutline();
     void updateWindowTitle();
 #ifdef Q_OS_LINUX
     void checkAndInstallDesktopFile();
 #endif
 private:
     bool saveTab(int index);
+signals:
+    void saveRequested(const QString &path, const QList<QByteArray> &chunks, const QByteArray &hash);
 };
 
 Q_DECLARE_METATYPE(MainWindow::TreeItemType);
@@ -1,21 +1,62 @@
+#include <QCoreApplication>
 #include <QDebug>
 #include <QDir>
+#include <QEventLoop>
 #include <QFile>
+#include <QMetaMethod>
 #include <QProcess>
 #include <QProcessEnvironment>
 #include <QRegularExpression>
 #include <QSettings>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
 #include "processutils.h"
+#include "toolhost.h"
+#include "versionresolveworker.h"
 
 #define REGEXP_CRLF "[\\r\\n]"
+#define TOOL_HOST_MAX_JAVA 17
 
 ProcessOutput* ProcessOutput::m_Self = nullptr;
 
+QHash<QString, ToolCacheEntry> ProcessUtils::m_ToolCache;
+QMutex ProcessUtils::m_ToolCacheMutex;
+QHash<QString, ToolHost *> ProcessUtils::m_ToolHosts;
+QMutex ProcessUtils::m_ToolHostsMutex;
+bool ProcessUtils::m_ToolHostsQuitConnected = false;
+
+ProcessOutput::ProcessOutput(QObject *parent)
+    : QObject(parent), m_DroppedLines(0), m_OutputSlots(PROCESS_OUTPUT_MAX_PENDING)
+{
+}
+
 void ProcessOutput::emitCommandFinished(const ProcessResult &result)
 {
     emit commandFinished(result);
 }
 
+void ProcessOutput::emitCommandOutput(const QStringList &lines)
+{
+    if (!isSignalConnected(QMetaMethod::fromSignal(&ProcessOutput::commandOutput))) {
+        return;
+    }
+    // 控制台来不及处理时阻塞发送线程，直到控制台处理完一批释放名额，子进程会因管道写满而暂停输出，从而避免无限堆积；
+    // 界面线程不能等待自己处理
+    const bool blocking = QThread::currentThread() != thread();
+    if (!(blocking ? m_OutputSlots.tryAcquire(1, PROCESS_OUTPUT_WAIT_MSECS) : m_OutputSlots.tryAcquire(1))) {
+        // 最后的手段：等待超时后仍然积压，丢弃这一批只记录行数，积压的队列不再增长
+        m_DroppedLines.fetchAndAddRelaxed(lines.size());
+        return;
+    }
+    QStringList batch(lines);
+    const int dropped = m_DroppedLines.fetchAndStoreRelaxed(0);
+    if (dropped > 0) {
+        batch.prepend(tr("（控制台来不及显示，省略了 %1 行输出）").arg(dropped));
+    }
+    emit commandOutput(batch);
+}
+
 void ProcessOutput::emitCommandStarting(const QString &exe, const QStringList &args)
 {
     emit commandStarting(exe, args);
@@ -30,86 +71,120 @@ ProcessOutput *ProcessOutput::instance()
 #endif
     if (!m_Self) {
         m_Self = new ProcessOutput();
+        // 可能首先在工作线程中创建，统一归属到主线程
+        m_Self->moveToThread(QCoreApplication::instance()->thread());
     }
     return m_Self;
 }
 
-QString ProcessUtils::adbExe()
+void ProcessOutput::releaseCommandOutput()
 {
-    QSettings settings;
-    QString exe = settings.value("adb_exe").toString();
-    if (!exe.isEmpty() && QFile::exists(exe)) {
-        return exe;
+    m_OutputSlots.release();
+}
+
+ProcessRunner::ProcessRunner(QObject *parent)
+    : QObject(parent), m_Finished(false), m_Process(new QProcess(this))
+{
+    m_Result.code = -1;
+    connect(m_Process, &QProcess::errorOccurred, this, &ProcessRunner::handleErrorOccurred);
+    connect(m_Process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &ProcessRunner::handleFinished);
+    connect(m_Process, &QProcess::readyReadStandardOutput, this, &ProcessRunner::handleReadyRead);
+}
+
+void ProcessRunner::finish(const int code)
+{
+    if (m_Finished) {
+        return;
     }
-    QString name("adb");
-#ifdef Q_OS_WIN
-    name.append(".exe");
-#endif
-    return findInPath(name);
+    m_Finished = true;
+    flushLines(true);
+    m_Result.code = code;
+    ProcessOutput::instance()->emitCommandFinished(m_Result);
+    emit finished(m_Result);
 }
 
-QString ProcessUtils::apktoolJar()
+void ProcessRunner::flushLines(const bool all)
 {
-    QSettings settings;
-    const QString jar = settings.value("apktool_jar").toString();
-    return (!jar.isEmpty() && QFile::exists(jar)) ? jar : QString();
+    // 仅处理到最后一个换行符为止，不完整的行留待下次读取；超长的行强制截断输出
+    int end = qMax(m_Buffer.lastIndexOf('\n'), m_Buffer.lastIndexOf('\r'));
+    if (all || ((end < 0) && (m_Buffer.size() >= PROCESS_OUTPUT_MAX_LINE_LENGTH))) {
+        end = m_Buffer.size() - 1;
+    }
+    if (end < 0) {
+        return;
+    }
+    static const QRegularExpression crlf(REGEXP_CRLF);
+    const QString text = QString::fromUtf8(m_Buffer.constData(), end + 1);
+    m_Buffer.remove(0, end + 1);
+    const QStringList lines = text.split(crlf, Qt::SkipEmptyParts);
+    if (lines.isEmpty()) {
+        return;
+    }
+    // 只保留最近的若干行作为结果，完整输出通过信号流式传递
+    m_Result.output.append(lines);
+    const int overflow = m_Result.output.size() - PROCESS_OUTPUT_MAX_LINES;
+    if (overflow > 0) {
+        m_Result.output.remove(0, overflow);
+    }
+    emit outputReceived(lines);
+    ProcessOutput::instance()->emitCommandOutput(lines);
 }
 
-QString ProcessUtils::findInPath(const QString &exe)
+void ProcessRunner::handleErrorOccurred(QProcess::ProcessError error)
 {
-    auto result = runCommand(
-#ifdef Q_OS_WIN
-                "where",
-#else
-                "which",
-#endif
-                QStringList(exe));
-    if ((result.code == 0) && (result.output.count() >= 1)) {
-        auto location = result.output.first();
+    // 启动失败时 QProcess 不会发出 finished 信号
+    if (error == QProcess::FailedToStart) {
+        finish(-1);
+    }
+}
+
+void ProcessRunner::handleFinished(int code, QProcess::ExitStatus status)
+{
+    Q_UNUSED(status)
+    m_Buffer.append(m_Process->readAllStandardOutput());
+    finish(code);
+}
+
+void ProcessRunner::handleReadyRead()
+{
+    m_Buffer.append(m_Process->readAllStandardOutput());
+    flushLines(false);
+}
+
+void ProcessRunner::handleTimeout()
+{
+    if (!m_Finished) {
 #ifdef QT_DEBUG
-        qDebug() << exe << "找到于" << location;
+        qDebug() << "进程超时，正在终止" << m_Process->program();
 #endif
-        return location;
+        kill();
     }
-    return QString();
 }
 
-QString ProcessUtils::jadxExe()
+bool ProcessRunner::isFinished() const
 {
-    QSettings settings;
-    QString exe = settings.value("jadx_exe").toString();
-    return (!exe.isEmpty() && QFile::exists(exe)) ? exe : QString();
+    return m_Finished;
 }
 
-QString ProcessUtils::javaExe()
+void ProcessRunner::kill()
 {
-    QSettings settings;
-    QString exe;
-    exe = settings.value("java_exe").toString();
-    if (!exe.isEmpty() && QFile::exists(exe)) {
-        return exe;
+    if (m_Process->state() != QProcess::NotRunning) {
+        m_Process->kill();
     }
-    QString name("java");
-#ifdef Q_OS_WIN
-    name.append(".exe");
-#endif
-    return findInPath(name);
 }
 
-int ProcessUtils::javaHeapSize()
+ProcessResult ProcessRunner::result() const
 {
-    QSettings settings;
-    return settings.value("java_heap", 256).toInt();
+    return m_Result;
 }
 
-ProcessResult ProcessUtils::runCommand(const QString &exe, const QStringList &args, const int timeout)
+void ProcessRunner::start(const QString &exe, const QStringList &args, const int timeout)
 {
 #ifdef QT_DEBUG
     qDebug() << "正在运行" << exe << args;
 #endif
     ProcessOutput::instance()->emitCommandStarting(exe, args);
-    QProcess process;
-    process.setProcessChannelMode(QProcess::MergedChannels);
+    m_Process->setProcessChannelMode(QProcess::MergedChannels);
     
 #ifdef Q_OS_WIN
     // 在 Windows 上，.bat 和 .cmd 文件需要通过 cmd.exe 执行
@@ -135,16 +210,12 @@ ProcessResult ProcessUtils::runCommand(const QString &exe, const QStringList &ar
     }
     
     if (!workingDir.isEmpty()) {
-        process.setWorkingDirectory(workingDir);
+        m_Process->setWorkingDirectory(workingDir);
     }
     
     // 当 Java 位置已知时为所有命令设置 JAVA_HOME
-    // 但跳过搜索 java 本身的情况（which/where 命令）
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    QString javaPath;
-    if (actualExe != "which" && actualExe != "where") {
-        javaPath = ProcessUtils::javaExe(); // 从设置获取 Java 路径
-    }
+    const QString javaPath = ProcessUtils::javaExe(); // 从设置获取 Java 路径
     if (!javaPath.isEmpty()) {
         QFileInfo javaInfo(javaPath);
         QString javaHome = javaInfo.absolutePath();
@@ -166,17 +237,13 @@ ProcessResult ProcessUtils::runCommand(const QString &exe, const QStringList &ar
         qDebug() << "添加到 PATH：" << javaBinPath;
 #endif
     }
-    process.setProcessEnvironment(env);
+    m_Process->setProcessEnvironment(env);
     
-    process.start(actualExe, actualArgs, QIODevice::ReadOnly);
+    m_Process->start(actualExe, actualArgs, QIODevice::ReadOnly);
 #else
     // 当 Java 位置已知时为所有命令设置 JAVA_HOME
-    // 但跳过搜索 java 本身的情况（which/where 命令）
     QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
-    QString javaPath;
-    if (exe != "which" && exe != "where") {
-        javaPath = ProcessUtils::javaExe(); // 从设置获取 Java 路径
-    }
+    const QString javaPath = ProcessUtils::javaExe(); // 从设置获取 Java 路径
     if (!javaPath.isEmpty()) {
         QFileInfo javaInfo(javaPath);
         QString javaHome = javaInfo.absolutePath();
@@ -198,32 +265,194 @@ ProcessResult ProcessUtils::runCommand(const QString &exe, const QStringList &ar
         qDebug() << "添加到 PATH：" << javaBinPath;
 #endif
     }
-    process.setProcessEnvironment(env);
+    m_Process->setProcessEnvironment(env);
     
-    process.start(exe, args, QIODevice::ReadOnly);
+    m_Process->start(exe, args, QIODevice::ReadOnly);
 #endif
     
-    ProcessResult result;
-    if (process.waitForStarted(timeout * 1000)) {
-        if (!process.waitForFinished(timeout * 1000)) {
-            process.kill();
+    QTimer::singleShot(timeout * 1000, this, &ProcessRunner::handleTimeout);
+}
+
+QString ProcessUtils::adbExe()
+{
+    QString name("adb");
+#ifdef Q_OS_WIN
+    name.append(".exe");
+#endif
+    return resolveTool("adb_exe", name);
+}
+
+QString ProcessUtils::apktoolJar()
+{
+    return resolveTool("apktool_jar");
+}
+
+void ProcessUtils::clearToolCache()
+{
+    QMutexLocker locker(&m_ToolCacheMutex);
+    m_ToolCache.clear();
+}
+
+QString ProcessUtils::findInPath(const QString &exe)
+{
+    // 直接在进程内搜索 PATH，不再为此启动 which/where 子进程
+    const QString location = QStandardPaths::findExecutable(exe);
+#ifdef QT_DEBUG
+    if (!location.isEmpty()) {
+        qDebug() << exe << "找到于" << location;
+    }
+#endif
+    return location;
+}
+
+QString ProcessUtils::jadxExe()
+{
+    return resolveTool("jadx_exe");
+}
+
+QString ProcessUtils::javaExe()
+{
+    QString name("java");
+#ifdef Q_OS_WIN
+    name.append(".exe");
+#endif
+    return resolveTool("java_exe", name);
+}
+
+int ProcessUtils::javaHeapSize()
+{
+    QSettings settings;
+    return settings.value("java_heap", 256).toInt();
+}
+
+int ProcessUtils::javaVersion()
+{
+    // 使用启动时解析并缓存的版本，1.8 及以前的版本号以 1. 开头；版本未知时返回 0
+    const QStringList parts = VersionResolveWorker::cachedVersion("java", javaExe()).split('.');
+    const int major = parts.first().toInt();
+    return ((major == 1) && (parts.size() > 1)) ? parts.at(1).toInt() : major;
+}
+
+QString ProcessUtils::resolveTool(const QString &setting, const QString &exe)
+{
+    QMutexLocker locker(&m_ToolCacheMutex);
+    auto it = m_ToolCache.constFind(setting);
+    if (it != m_ToolCache.constEnd()) {
+        // 二进制文件被替换或删除后重新解析
+        const QFileInfo info(it->path);
+        if (info.exists() && (info.lastModified() == it->modified)) {
+            return it->path;
         }
-        result.code = process.exitCode();
-        QString error(process.readAllStandardError());
-        QString output(process.readAllStandardOutput());
-        QRegularExpression crlf(REGEXP_CRLF);
-        result.error = error.split(crlf, Qt::SkipEmptyParts);
-        result.output = output.split(crlf, Qt::SkipEmptyParts);
-    } else {
-        result.code = -1;
+        m_ToolCache.remove(setting);
+    }
+    QSettings settings;
+    QString path = settings.value(setting).toString();
+    if (path.isEmpty() || !QFile::exists(path)) {
+        path = exe.isEmpty() ? QString() : findInPath(exe);
     }
-    ProcessOutput::instance()->emitCommandFinished(result);
-    return result;
+    // 未找到的结果不缓存，之后安装的工具可以立即被发现
+    if (!path.isEmpty()) {
+        ToolCacheEntry entry;
+        entry.path = path;
+        entry.modified = QFileInfo(path).lastModified();
+        m_ToolCache.insert(setting, entry);
+    }
+    return path;
 }
 
-QString ProcessUtils::uberApkSignerJar()
+ProcessResult ProcessUtils::runCommand(const QString &exe, const QStringList &args, const int timeout)
+{
+    // 局部事件循环只能在工作线程中运行，在界面线程中运行会导致界面操作重入
+    Q_ASSERT(QThread::currentThread() != QCoreApplication::instance()->thread());
+    ProcessRunner runner;
+    QEventLoop loop;
+    QObject::connect(&runner, &ProcessRunner::finished, &loop, &QEventLoop::quit);
+    runner.start(exe, args, timeout);
+    if (!runner.isFinished()) {
+        loop.exec();
+    }
+    return runner.result();
+}
+
+ProcessResult ProcessUtils::runJar(const QString &jar, const QStringList &args, const int timeout)
+{
+    const QString java = javaExe();
+    const int heap = javaHeapSize();
+    Q_ASSERT(QThread::currentThread() != QCoreApplication::instance()->thread());
+    if (toolHostEnabled()) {
+        // 在常驻 JVM 中执行，省去每次启动 JVM 和 JIT 预热的开销
+        ToolHost *host = toolHost(java, jar, heap);
+        ToolHostRequest request(args, timeout);
+        QEventLoop loop;
+        QObject::connect(&request, &ToolHostRequest::finished, &loop, &QEventLoop::quit, Qt::QueuedConnection);
+        QMetaObject::invokeMethod(host, [host, &request] {
+            host->execute(&request);
+        }, Qt::QueuedConnection);
+        loop.exec();
+        if (!request.fallback()) {
+            return request.result();
+        }
+#ifdef QT_DEBUG
+        qDebug() << "工具宿主不可用，改用一次性进程运行" << jar;
+#endif
+    }
+    QStringList oneshot;
+    oneshot << QString("-Xmx%1m").arg(heap) << "-jar" << jar;
+    oneshot << args;
+    return runCommand(java, oneshot, timeout);
+}
+
+void ProcessUtils::stopToolHosts()
+{
+    QMutexLocker locker(&m_ToolHostsMutex);
+    foreach (auto host, m_ToolHosts) {
+        QMetaObject::invokeMethod(host, [host] {
+            host->shutdown();
+            host->deleteLater();
+        });
+    }
+    m_ToolHosts.clear();
+}
+
+ToolHost *ProcessUtils::toolHost(const QString &java, const QString &jar, const int heap)
+{
+    QMutexLocker locker(&m_ToolHostsMutex);
+    ToolHost *host = m_ToolHosts.value(jar);
+    if (host && !host->matches(java, jar, heap)) {
+        // Java 路径或堆大小已更改，旧宿主处理完手头的命令后退出
+        QMetaObject::invokeMethod(host, [host] {
+            host->retire();
+        }, Qt::QueuedConnection);
+        host = nullptr;
+    }
+    if (!host) {
+        host = new ToolHost(java, jar, heap);
+        // 宿主进程需要一个始终存在的线程，工作线程可能随时结束
+        host->moveToThread(QCoreApplication::instance()->thread());
+        if (!m_ToolHostsQuitConnected) {
+            // 退出时统一停止所有宿主，只需要连接一次
+            QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, QCoreApplication::instance(), &ProcessUtils::stopToolHosts);
+            m_ToolHostsQuitConnected = true;
+        }
+        m_ToolHosts.insert(jar, host);
+    }
+    return host;
+}
+
+bool ProcessUtils::toolHostEnabled()
 {
     QSettings settings;
-    const QString jar = settings.value("uas_jar").toString();
-    return (!jar.isEmpty() && QFile::exists(jar)) ? jar : QString();
+    return settings.value("java_tool_host", false).toBool() && toolHostSupported();
+}
+
+bool ProcessUtils::toolHostSupported()
+{
+    // Java 18 及以上版本无法拦截工具调用的 System.exit，版本未知时也使用一次性进程
+    const int version = javaVersion();
+    return (version > 0) && (version <= TOOL_HOST_MAX_JAVA);
+}
+
+QString ProcessUtils::uberApkSignerJar()
+{
+    return resolveTool("uas_jar");
 }
@@ -1,10 +1,20 @@
 #ifndef PROCESSUTILS_H
 #define PROCESSUTILS_H
 
+#include <QAtomicInteger>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
 #include <QObject>
+#include <QProcess>
+#include <QSemaphore>
 #include <QStringList>
 
 #define PROCESS_TIMEOUT_SECS 5 * 60
+#define PROCESS_OUTPUT_MAX_LINES 2000
+#define PROCESS_OUTPUT_MAX_LINE_LENGTH 64 * 1024
+#define PROCESS_OUTPUT_MAX_PENDING 32
+#define PROCESS_OUTPUT_WAIT_MSECS 5000
 
 struct ProcessResult {
     int code;
@@ -17,26 +27,79 @@ class ProcessOutput : public QObject
     Q_OBJECT
 public:
     void emitCommandFinished(const ProcessResult &result);
+    void emitCommandOutput(const QStringList &lines);
     void emitCommandStarting(const QString &exe, const QStringList &args);
+    void releaseCommandOutput();
     static ProcessOutput *instance();
 private:
+    explicit ProcessOutput(QObject *parent = nullptr);
+    QAtomicInteger<int> m_DroppedLines;
+    QSemaphore m_OutputSlots;
     static ProcessOutput *m_Self;
 signals:
     void commandFinished(const ProcessResult &result);
+    void commandOutput(const QStringList &lines);
     void commandStarting(const QString &exe, const QStringList &args);
 };
 
+class ProcessRunner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProcessRunner(QObject *parent = nullptr);
+    bool isFinished() const;
+    void kill();
+    ProcessResult result() const;
+    void start(const QString &exe, const QStringList &args = QStringList(), const int timeout = PROCESS_TIMEOUT_SECS);
+private:
+    QByteArray m_Buffer;
+    bool m_Finished;
+    QProcess *m_Process;
+    ProcessResult m_Result;
+    void finish(const int code);
+    void flushLines(const bool all);
+private slots:
+    void handleErrorOccurred(QProcess::ProcessError error);
+    void handleFinished(int code, QProcess::ExitStatus status);
+    void handleReadyRead();
+    void handleTimeout();
+signals:
+    void finished(const ProcessResult &result);
+    void outputReceived(const QStringList &lines);
+};
+
+class ToolHost;
+
+struct ToolCacheEntry {
+    QString path;
+    QDateTime modified;
+};
+
 class ProcessUtils
 {
 public:
     static QString adbExe();
     static QString apktoolJar();
+    static void clearToolCache();
     static QString findInPath(const QString &exe);
     static QString jadxExe();
     static QString javaExe();
     static int javaHeapSize();
+    static int javaVersion();
     static QString uberApkSignerJar();
     static ProcessResult runCommand(const QString &exe, const QStringList &args = QStringList(), const int timeout = PROCESS_TIMEOUT_SECS);
+    static ProcessResult runJar(const QString &jar, const QStringList &args = QStringList(), const int timeout = PROCESS_TIMEOUT_SECS);
+    static void stopToolHosts();
+    static bool toolHostEnabled();
+    static bool toolHostSupported();
+private:
+    static QHash<QString, ToolCacheEntry> m_ToolCache;
+    static QMutex m_ToolCacheMutex;
+    static QHash<QString, ToolHost *> m_ToolHosts;
+    static QMutex m_ToolHostsMutex;
+    static bool m_ToolHostsQuitConnected;
+    static QString resolveTool(const QString &setting, const QString &exe = QString());
+    static ToolHost *toolHost(const QString &java, const QString &jar, const int heap);
 };
 
 Q_DECLARE_METATYPE(ProcessResult);
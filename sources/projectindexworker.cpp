@@ -0,0 +1,81 @@
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThread>
+#include "findinfilesworker.h"
+#include "projectindexworker.h"
+
+#define PROJECT_CACHE_DIR ".apkstudio"
+
+ProjectIndexWorker::ProjectIndexWorker(const QString &folder, const quint64 request, QObject *parent)
+    : QObject(parent), m_Folder(folder), m_Request(request)
+{
+}
+
+void ProjectIndexWorker::index()
+{
+    emit started();
+#ifdef QT_DEBUG
+    QElapsedTimer timer;
+    timer.start();
+#endif
+    ProjectNameIndex index;
+    index.add(QFileInfo(m_Folder).fileName(), m_Folder);
+    walk(m_Folder, index);
+    if (QThread::currentThread()->isInterruptionRequested()) {
+        // 项目已关闭或程序正在退出，不完整的索引不再交给界面
+        emit finished();
+        return;
+    }
+#ifdef QT_DEBUG
+    qDebug() << "项目索引完成" << m_Folder << timer.elapsed() << "毫秒";
+#endif
+    emit indexFinished(m_Request, m_Folder, index);
+    updateTrigrams();
+    emit finished();
+}
+
+void ProjectIndexWorker::updateTrigrams()
+{
+    // 名称索引交给界面后，借用同一次遍历得到的修改时间和大小增量更新全文搜索的三元组索引
+    const QStringList dirty = TrigramIndex::takeDirtyFiles(m_Folder);
+    TrigramIndex trigrams(m_Folder);
+    trigrams.load();
+    const bool updated = trigrams.update(m_TextFiles, dirty, [] {
+        return QThread::currentThread()->isInterruptionRequested();
+    });
+    if (updated && trigrams.save()) {
+        return;
+    }
+    if (updated || QThread::currentThread()->isInterruptionRequested()) {
+#ifdef QT_DEBUG
+        qDebug() << "未能更新三元组索引" << m_Folder;
+#endif
+        // 索引没有更新，保存过的文件留给下次搜索直接扫描
+        TrigramIndex::markDirty(m_Folder, dirty);
+    }
+}
+
+void ProjectIndexWorker::walk(const QString &path, ProjectNameIndex &index)
+{
+    // 路径的拼接方式与项目树模型一致，搜索结果可以直接与树节点对应
+    QDir dir(path);
+    const QFileInfoList files = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot);
+    foreach (auto info, files) {
+        if (QThread::currentThread()->isInterruptionRequested()) {
+            return;
+        }
+        if (info.isDir() && (info.fileName() == PROJECT_CACHE_DIR)) {
+            // 跳过索引缓存目录，与项目树一致
+            continue;
+        }
+        const QString child = path + '/' + info.fileName();
+        index.add(info.fileName(), child);
+        if (info.isDir() && !info.isSymLink()) {
+            walk(child, index);
+        } else if (info.isFile() && FindInFilesWorker::isTextFile(info.fileName())) {
+            m_TextFiles.append(TrigramIndexEntry{info.lastModified().toMSecsSinceEpoch(), child.mid(m_Folder.size() + 1), info.size()});
+        }
+    }
+}
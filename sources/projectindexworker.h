@@ -0,0 +1,26 @@
+#ifndef PROJECTINDEXWORKER_H
+#define PROJECTINDEXWORKER_H
+
+#include <QObject>
+#include "projectnameindex.h"
+#include "trigramindex.h"
+
+class ProjectIndexWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ProjectIndexWorker(const QString &folder, const quint64 request, QObject *parent = nullptr);
+    void index();
+private:
+    QString m_Folder;
+    quint64 m_Request;
+    QList<TrigramIndexEntry> m_TextFiles;
+    void updateTrigrams();
+    void walk(const QString &path, ProjectNameIndex &index);
+signals:
+    void finished();
+    void indexFinished(const quint64 request, const QString &folder, const ProjectNameIndex &index);
+    void started();
+};
+
+#endif // PROJECTINDEXWORKER_H
@@ -0,0 +1,60 @@
+#include "projectnameindex.h"
+
+void ProjectNameIndex::add(const QString &name, const QString &path)
+{
+    const QString lower = name.toLower();
+    const int id = m_Names.size();
+    m_Names.append(lower);
+    m_Paths.append(path);
+    for (int i = 0; i + 3 <= lower.length(); ++i) {
+        QList<int> &ids = m_Trigrams[trigram(lower.constData() + i)];
+        if (ids.isEmpty() || (ids.last() != id)) {
+            ids.append(id);
+        }
+    }
+}
+
+bool ProjectNameIndex::isEmpty() const
+{
+    return m_Names.isEmpty();
+}
+
+QStringList ProjectNameIndex::match(const QString &filter, const int limit) const
+{
+    const QString needle = filter.toLower();
+    QStringList paths;
+    if (needle.length() < 3) {
+        // 过短的关键字没有三元组可用，直接扫描名称
+        for (int i = 0; (i < m_Names.size()) && (paths.size() < limit); ++i) {
+            if (m_Names.at(i).contains(needle)) {
+                paths.append(m_Paths.at(i));
+            }
+        }
+        return paths;
+    }
+    // 以最稀有的三元组对应的名称作为候选，再逐个确认
+    const QList<int> *candidates = nullptr;
+    for (int i = 0; i + 3 <= needle.length(); ++i) {
+        auto it = m_Trigrams.constFind(trigram(needle.constData() + i));
+        if (it == m_Trigrams.constEnd()) {
+            return paths;
+        }
+        if (!candidates || (it.value().size() < candidates->size())) {
+            candidates = &it.value();
+        }
+    }
+    foreach (auto id, *candidates) {
+        if (paths.size() >= limit) {
+            break;
+        }
+        if (m_Names.at(id).contains(needle)) {
+            paths.append(m_Paths.at(id));
+        }
+    }
+    return paths;
+}
+
+quint64 ProjectNameIndex::trigram(const QChar *chars)
+{
+    return (quint64(chars[0].unicode()) << 32) | (quint64(chars[1].unicode()) << 16) | quint64(chars[2].unicode());
+}
@@ -0,0 +1,24 @@
+#ifndef PROJECTNAMEINDEX_H
+#define PROJECTNAMEINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QStringList>
+
+class ProjectNameIndex
+{
+public:
+    void add(const QString &name, const QString &path);
+    bool isEmpty() const;
+    QStringList match(const QString &filter, const int limit) const;
+private:
+    QStringList m_Names;
+    QStringList m_Paths;
+    QHash<quint64, QList<int>> m_Trigrams;
+    static quint64 trigram(const QChar *chars);
+};
+
+Q_DECLARE_METATYPE(ProjectNameIndex);
+
+#endif // PROJECTNAMEINDEX_H
@@ -0,0 +1,600 @@
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLocale>
+#include "projectindexworker.h"
+#include "projecttreemodel.h"
+#include "smaliindexworker.h"
+
+ProjectTreeModel::ProjectTreeModel(QObject *parent)
+    : QAbstractItemModel(parent),
+      m_Request(0),
+      m_Root(new Node{QList<Node *>(), QString(), nullptr, 0, true, false, Project}),
+      m_Thread(new QThread(this)),
+      m_Worker(new DirectoryEnumerateWorker)
+{
+    qRegisterMetaType<QList<DirectoryEntry>>("QList<DirectoryEntry>");
+    qRegisterMetaType<ProjectNameIndex>("ProjectNameIndex");
+    qRegisterMetaType<SmaliIndex>("SmaliIndex");
+    m_FolderIcon = m_IconProvider.icon(QFileIconProvider::Folder);
+    m_Worker->moveToThread(m_Thread);
+    connect(this, &ProjectTreeModel::enumerateRequested, m_Worker, &DirectoryEnumerateWorker::enumerate);
+    connect(m_Worker, &DirectoryEnumerateWorker::entriesEnumerated, this, &ProjectTreeModel::handleEntriesEnumerated);
+    m_Thread->start();
+}
+
+QModelIndex ProjectTreeModel::addProject(const QString &folder)
+{
+    const int row = m_Root->children.size();
+    beginInsertRows(QModelIndex(), row, row);
+    m_Root->children.append(new Node{QList<Node *>(), folder, m_Root, row, false, false, Project});
+    endInsertRows();
+    indexProject(m_Root->children.last());
+    return index(row, 0);
+}
+
+bool ProjectTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (!parent.isValid()) {
+        return false;
+    }
+    const Node *node = nodeOf(parent);
+    return (node->type != File) && !node->fetched && !node->fetching;
+}
+
+void ProjectTreeModel::cancelMatch()
+{
+    m_Wanted.clear();
+}
+
+void ProjectTreeModel::clearChildren(Node *node)
+{
+    if (node->fetching) {
+        m_Pending.remove(m_Pending.key(node));
+        node->fetching = false;
+    }
+    node->fetched = false;
+    if (node->children.isEmpty()) {
+        return;
+    }
+    beginRemoveRows(indexOf(node), 0, node->children.size() - 1);
+    foreach (auto child, node->children) {
+        forget(child);
+    }
+    node->children.clear();
+    endRemoveRows();
+}
+
+int ProjectTreeModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent)
+    return 1;
+}
+
+void ProjectTreeModel::continueReveal()
+{
+    if (m_Reveal.isEmpty()) {
+        return;
+    }
+    Node *node = nullptr;
+    QString relative;
+    foreach (auto project, m_Root->children) {
+        const QString folder = QDir::cleanPath(QDir::fromNativeSeparators(project->name));
+        if (m_Reveal == folder) {
+            node = project;
+            break;
+        }
+        if (m_Reveal.startsWith(folder + '/')) {
+            node = project;
+            relative = m_Reveal.mid(folder.length() + 1);
+            break;
+        }
+    }
+    if (!node) {
+        m_Reveal.clear();
+        return;
+    }
+    const QStringList segments = relative.split('/', Qt::SkipEmptyParts);
+    foreach (auto segment, segments) {
+        Node *next = nullptr;
+        foreach (auto child, node->children) {
+            if (child->name == segment) {
+                next = child;
+                break;
+            }
+        }
+        if (!next) {
+            if (node->fetched || (node->type == File)) {
+                m_Reveal.clear();
+                return;
+            }
+            // 所在目录尚未加载完，等枚举结果到达后继续
+            fetchMore(indexOf(node));
+            return;
+        }
+        node = next;
+    }
+    m_Reveal.clear();
+    emit pathRevealed(indexOf(node));
+}
+
+QVariant ProjectTreeModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+    const Node *node = nodeOf(index);
+    switch (role) {
+    case Qt::DisplayRole:
+        return (node->type == Project) ? QFileInfo(node->name).fileName() : node->name;
+    case Qt::DecorationRole:
+        return iconOf(node);
+    case Qt::ToolTipRole: {
+        // 大小只在显示提示时才读取
+        if (node->type == Project) {
+            break;
+        }
+        const QFileInfo info(pathOf(node));
+        return QString("%1 - %2")
+                .arg(QDir::toNativeSeparators(info.filePath()))
+                .arg(QLocale::system().formattedDataSize(info.size(), 2, QLocale::DataSizeTraditionalFormat));
+    }
+    case TypeRole:
+        return static_cast<int>(node->type);
+    case PathRole:
+        return pathOf(node);
+    }
+    return QVariant();
+}
+
+void ProjectTreeModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) {
+        return;
+    }
+    Node *node = nodeOf(parent);
+    node->fetching = true;
+    m_Pending.insert(++m_Request, node);
+    emit enumerateRequested(m_Request, pathOf(node));
+}
+
+void ProjectTreeModel::fetchWanted(Node *node)
+{
+    if ((node->type == File) || !m_Wanted.contains(pathOf(node))) {
+        return;
+    }
+    if (!node->fetched && !node->fetching) {
+        fetchMore(indexOf(node));
+    }
+    foreach (auto child, node->children) {
+        fetchWanted(child);
+    }
+}
+
+Qt::ItemFlags ProjectTreeModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    Qt::ItemFlags flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+    if (nodeOf(index)->type == File) {
+        flags |= Qt::ItemNeverHasChildren;
+    }
+    return flags;
+}
+
+void ProjectTreeModel::forget(Node *node)
+{
+    if (node->fetching) {
+        m_Pending.remove(m_Pending.key(node));
+    }
+    foreach (auto child, node->children) {
+        forget(child);
+    }
+    delete node;
+}
+
+void ProjectTreeModel::handleEntriesEnumerated(const quint64 request, const QList<DirectoryEntry> &entries, const bool last)
+{
+    Node *node = m_Pending.value(request);
+    if (!node) {
+        // 目录在枚举期间已被刷新或移除
+        return;
+    }
+    if (!entries.isEmpty()) {
+        const int first = node->children.size();
+        beginInsertRows(indexOf(node), first, first + entries.size() - 1);
+        node->children.reserve(first + entries.size());
+        foreach (const auto &entry, entries) {
+            const int row = node->children.size();
+            node->children.append(new Node{QList<Node *>(), intern(entry.name), node, row, false, false, static_cast<quint8>(entry.dir ? Folder : File)});
+        }
+        endInsertRows();
+        if (!m_Wanted.isEmpty()) {
+            // 继续加载搜索命中项所在的目录
+            for (int i = first; i < node->children.size(); ++i) {
+                fetchWanted(node->children.at(i));
+            }
+        }
+    }
+    if (last) {
+        m_Pending.remove(request);
+        node->fetching = false;
+        node->fetched = true;
+        if (node->children.isEmpty()) {
+            // 空目录不再显示展开箭头
+            const QModelIndex index = indexOf(node);
+            emit dataChanged(index, index);
+        }
+    }
+    continueReveal();
+}
+
+void ProjectTreeModel::handleIndexFinished(const quint64 request, const QString &folder, const ProjectNameIndex &index)
+{
+    if (m_IndexRequests.value(folder) != request) {
+        // 项目在索引期间又被刷新，等待更新的结果
+        return;
+    }
+    m_IndexRequests.remove(folder);
+    m_Indexes.insert(folder, index);
+    emit projectIndexed(folder);
+}
+
+void ProjectTreeModel::handleSmaliIndexFinished(const quint64 request, const QString &folder, const SmaliIndex &index)
+{
+    auto it = m_SmaliJobs.find(folder);
+    if ((it == m_SmaliJobs.end()) || (it->request != request)) {
+        return;
+    }
+    // 结果已经送达，任务结束时不需要重新排队
+    it->request = 0;
+    m_SmaliIndexes.insert(folder, index);
+    emit smaliIndexed(folder);
+}
+
+void ProjectTreeModel::handleSmaliJobFinished(const QString &folder)
+{
+    const SmaliJob job = m_SmaliJobs.take(folder);
+    if (job.request) {
+        // 任务被中断，它的文件并入下一个任务
+        queueSmaliJob(folder, job.files);
+    }
+    startSmaliJob(folder);
+}
+
+bool ProjectTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    const Node *node = nodeOf(parent);
+    if (node->type == File) {
+        return false;
+    }
+    // 未加载的目录先假定有子项，展开时再枚举
+    return !node->fetched || !node->children.isEmpty();
+}
+
+QModelIndex ProjectTreeModel::index(int row, int column, const QModelIndex &parent) const
+{
+    const Node *node = nodeOf(parent);
+    if ((column != 0) || (row < 0) || (row >= node->children.size())) {
+        return QModelIndex();
+    }
+    return createIndex(row, column, node->children.at(row));
+}
+
+QIcon ProjectTreeModel::iconOf(const Node *node) const
+{
+    if (node->type != File) {
+        return m_FolderIcon;
+    }
+    // 按扩展名缓存图标，图标提供器在多数平台上需要访问文件系统或 MIME 数据库
+    const int dot = node->name.lastIndexOf('.');
+    const QString suffix = (dot > 0) ? node->name.mid(dot + 1).toLower() : QString();
+    auto it = m_IconCache.constFind(suffix);
+    if (it == m_IconCache.constEnd()) {
+        const QIcon icon = suffix.isEmpty()
+                ? m_IconProvider.icon(QFileIconProvider::File)
+                : m_IconProvider.icon(QFileInfo(pathOf(node)));
+        it = m_IconCache.insert(suffix, icon);
+    }
+    return it.value();
+}
+
+QModelIndex ProjectTreeModel::indexOf(Node *node) const
+{
+    if (!node || (node == m_Root)) {
+        return QModelIndex();
+    }
+    return createIndex(node->row, 0, node);
+}
+
+void ProjectTreeModel::indexProject(Node *project)
+{
+    // 在后台为整个项目建立文件名索引，供搜索框使用
+    const QString folder = project->name;
+    const quint64 request = ++m_Request;
+    m_IndexRequests.insert(folder, request);
+    auto thread = new QThread();
+    auto worker = new ProjectIndexWorker(folder, request);
+    worker->moveToThread(thread);
+    connect(thread, &QThread::started, worker, &ProjectIndexWorker::index);
+    connect(worker, &ProjectIndexWorker::finished, thread, &QThread::quit);
+    connect(worker, &ProjectIndexWorker::indexFinished, this, &ProjectTreeModel::handleIndexFinished);
+    connect(worker, &ProjectIndexWorker::finished, worker, &QObject::deleteLater);
+    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+    // 线程结束后自行释放，这里只保留弱引用供析构时等待
+    m_IndexThreads.removeAll(nullptr);
+    m_IndexThreads.append(thread);
+    thread->start();
+    indexSmali(folder);
+}
+
+void ProjectTreeModel::indexSmali(const QString &folder, const QString &path)
+{
+    // smali 符号索引保存在项目目录中，保存文件后只重新解析这个文件
+    const QString file = path.startsWith(folder + '/') ? path.mid(folder.size() + 1) : QString();
+    queueSmaliJob(folder, file.isEmpty() ? QStringList() : QStringList(file));
+    auto running = m_SmaliJobs.constFind(folder);
+    if (running == m_SmaliJobs.constEnd()) {
+        startSmaliJob(folder);
+        return;
+    }
+    // 每个项目同时只运行一个任务，正在运行的任务会被下一个任务完整重做时提前结束它
+    const QStringList pending = m_SmaliPending.value(folder).files;
+    bool stale = pending.isEmpty() || !running->files.isEmpty();
+    foreach (const QString &name, running->files) {
+        stale = stale && pending.contains(name);
+    }
+    if (stale) {
+        running->thread->requestInterruption();
+    }
+}
+
+QString ProjectTreeModel::intern(const QString &name)
+{
+    // 反编译结果中大量重复的文件名共享同一份字符串数据
+    auto it = m_Names.constFind(name);
+    if (it == m_Names.constEnd()) {
+        it = m_Names.insert(name);
+    }
+    return *it;
+}
+
+QSet<QString> ProjectTreeModel::match(const QString &filter, const int limit)
+{
+    QSet<QString> visible;
+    m_Wanted.clear();
+    int count = 0;
+    foreach (auto project, m_Root->children) {
+        if (count >= limit) {
+            break;
+        }
+        QStringList matches;
+        auto it = m_Indexes.constFind(project->name);
+        if (it != m_Indexes.constEnd()) {
+            matches = it.value().match(filter, limit - count);
+        } else {
+            // 索引尚未建立完成时只在已加载的节点中查找
+            matchLoaded(project, filter, matches, limit - count);
+        }
+        count += matches.size();
+        foreach (auto path, matches) {
+            visible.insert(path);
+            // 加入各级上级目录直到项目根目录，这些目录需要加载并展开
+            QString folder = path;
+            while (folder.length() > project->name.length()) {
+                folder.truncate(folder.lastIndexOf('/'));
+                if (m_Wanted.contains(folder)) {
+                    break;
+                }
+                m_Wanted.insert(folder);
+                visible.insert(folder);
+            }
+        }
+    }
+    foreach (auto project, m_Root->children) {
+        fetchWanted(project);
+    }
+    return visible;
+}
+
+void ProjectTreeModel::matchLoaded(const Node *node, const QString &filter, QStringList &matches, const int limit) const
+{
+    if (matches.size() >= limit) {
+        return;
+    }
+    const QString name = (node->type == Project) ? QFileInfo(node->name).fileName() : node->name;
+    if (name.contains(filter, Qt::CaseInsensitive)) {
+        matches.append(pathOf(node));
+    }
+    foreach (auto child, node->children) {
+        matchLoaded(child, filter, matches, limit);
+    }
+}
+
+ProjectTreeModel::Node *ProjectTreeModel::nodeOf(const QModelIndex &index) const
+{
+    return index.isValid() ? static_cast<Node *>(index.internalPointer()) : m_Root;
+}
+
+QModelIndex ProjectTreeModel::parent(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return QModelIndex();
+    }
+    return indexOf(nodeOf(index)->parent);
+}
+
+QString ProjectTreeModel::pathOf(const Node *node) const
+{
+    if (!node || (node == m_Root)) {
+        return QString();
+    }
+    if (node->type == Project) {
+        return node->name;
+    }
+    return pathOf(node->parent) + '/' + node->name;
+}
+
+QModelIndex ProjectTreeModel::project(const QString &folder) const
+{
+    foreach (auto node, m_Root->children) {
+        if (node->name == folder) {
+            return indexOf(node);
+        }
+    }
+    return QModelIndex();
+}
+
+QStringList ProjectTreeModel::projects() const
+{
+    QStringList folders;
+    foreach (auto node, m_Root->children) {
+        folders.append(node->name);
+    }
+    return folders;
+}
+
+void ProjectTreeModel::queueSmaliJob(const QString &folder, const QStringList &files)
+{
+    // 同一项目的请求合并为一个任务，空的文件列表表示扫描整个项目
+    auto it = m_SmaliPending.find(folder);
+    if (it == m_SmaliPending.end()) {
+        m_SmaliPending.insert(folder, SmaliJob{files, 0, nullptr});
+    } else if (files.isEmpty()) {
+        it->files.clear();
+    } else if (!it->files.isEmpty()) {
+        foreach (const QString &file, files) {
+            if (!it->files.contains(file)) {
+                it->files.append(file);
+            }
+        }
+    }
+}
+
+void ProjectTreeModel::reload(const QModelIndex &index)
+{
+    if (!index.isValid() || (nodeOf(index)->type == File)) {
+        return;
+    }
+    Node *node = nodeOf(index);
+    clearChildren(node);
+    fetchMore(index);
+    while (node->type != Project) {
+        node = node->parent;
+    }
+    indexProject(node);
+}
+
+void ProjectTreeModel::reveal(const QString &path)
+{
+    // 逐级加载目标所在的目录，找到后发出 pathRevealed
+    m_Reveal = QDir::cleanPath(QDir::fromNativeSeparators(path));
+    continueReveal();
+}
+
+int ProjectTreeModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.column() > 0) {
+        return 0;
+    }
+    return nodeOf(parent)->children.size();
+}
+
+SmaliIndex ProjectTreeModel::smaliIndex(const QString &path) const
+{
+    // 返回包含该文件或目录的项目的符号索引，索引尚未建立时为空
+    for (auto it = m_SmaliIndexes.constBegin(); it != m_SmaliIndexes.constEnd(); ++it) {
+        if ((path == it.key()) || path.startsWith(it.key() + '/')) {
+            return it.value();
+        }
+    }
+    return SmaliIndex();
+}
+
+void ProjectTreeModel::startSmaliJob(const QString &folder)
+{
+    auto pending = m_SmaliPending.find(folder);
+    if (pending == m_SmaliPending.end()) {
+        return;
+    }
+    SmaliJob job = pending.value();
+    m_SmaliPending.erase(pending);
+    // 项目的索引还没有建立时只能扫描整个项目
+    auto it = m_SmaliIndexes.constFind(folder);
+    if (it == m_SmaliIndexes.constEnd()) {
+        job.files.clear();
+    }
+    job.request = ++m_Request;
+    job.thread = new QThread();
+    auto worker = new SmaliIndexWorker((it != m_SmaliIndexes.constEnd()) ? it.value() : SmaliIndex(folder), job.files, job.request);
+    worker->moveToThread(job.thread);
+    connect(job.thread, &QThread::started, worker, &SmaliIndexWorker::index);
+    connect(worker, &SmaliIndexWorker::finished, job.thread, &QThread::quit);
+    connect(worker, &SmaliIndexWorker::indexFinished, this, &ProjectTreeModel::handleSmaliIndexFinished);
+    connect(worker, &SmaliIndexWorker::finished, this, [this, folder] {
+        handleSmaliJobFinished(folder);
+    });
+    connect(worker, &SmaliIndexWorker::finished, worker, &QObject::deleteLater);
+    connect(job.thread, &QThread::finished, job.thread, &QObject::deleteLater);
+    m_SmaliJobs.insert(folder, job);
+    job.thread->start();
+}
+
+ProjectTreeModel::~ProjectTreeModel()
+{
+    // 后台任务仍在读写项目中的索引文件，全部取消并等待结束；线程的 quit 信号要经过界面线程，这里直接调用
+    QList<QPointer<QThread>> threads = m_IndexThreads;
+    foreach (const SmaliJob &job, m_SmaliJobs) {
+        threads.append(job.thread);
+    }
+    foreach (const QPointer<QThread> &thread, threads) {
+        if (thread) {
+            thread->requestInterruption();
+            thread->quit();
+        }
+    }
+    foreach (const QPointer<QThread> &thread, threads) {
+        if (thread) {
+            thread->wait();
+        }
+    }
+    m_Thread->quit();
+    m_Thread->wait();
+    delete m_Worker;
+    forget(m_Root);
+}
+
+ProjectTreeFilterModel::ProjectTreeFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent), m_Filtering(false)
+{
+}
+
+void ProjectTreeFilterModel::clearFilterPaths()
+{
+    m_Filtering = false;
+    m_Paths.clear();
+    invalidateFilter();
+}
+
+bool ProjectTreeFilterModel::filterAcceptsRow(int row, const QModelIndex &parent) const
+{
+    if (!m_Filtering) {
+        return true;
+    }
+    const QModelIndex index = sourceModel()->index(row, 0, parent);
+    return m_Paths.contains(index.data(ProjectTreeModel::PathRole).toString());
+}
+
+bool ProjectTreeFilterModel::isFiltering() const
+{
+    return m_Filtering;
+}
+
+void ProjectTreeFilterModel::setFilterPaths(const QSet<QString> &paths)
+{
+    // 只保留搜索命中项及其上级目录
+    m_Filtering = true;
+    m_Paths = paths;
+    invalidateFilter();
+}
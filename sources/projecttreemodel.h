@@ -0,0 +1,127 @@
+#ifndef PROJECTTREEMODEL_H
+#define PROJECTTREEMODEL_H
+
+#include <QAbstractItemModel>
+#include <QFileIconProvider>
+#include <QHash>
+#include <QIcon>
+#include <QMap>
+#include <QPointer>
+#include <QSet>
+#include <QSortFilterProxyModel>
+#include <QThread>
+#include "directoryenumerateworker.h"
+#include "projectnameindex.h"
+#include "smaliindex.h"
+
+class ProjectTreeModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    // 取值与 MainWindow::TreeItemType 保持一致
+    enum NodeType {
+        Project = 0,
+        Folder,
+        File
+    };
+    enum Roles {
+        TypeRole = Qt::UserRole + 1,
+        PathRole = Qt::UserRole + 2
+    };
+    explicit ProjectTreeModel(QObject *parent = nullptr);
+    ~ProjectTreeModel();
+    QModelIndex addProject(const QString &folder);
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void cancelMatch();
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    void indexSmali(const QString &folder, const QString &path = QString());
+    QSet<QString> match(const QString &filter, const int limit);
+    QModelIndex parent(const QModelIndex &index) const override;
+    QModelIndex project(const QString &folder) const;
+    QStringList projects() const;
+    void reload(const QModelIndex &index);
+    void reveal(const QString &path);
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    SmaliIndex smaliIndex(const QString &path) const;
+private:
+    // 节点只保存共享的名称片段，完整路径、图标和大小都在需要时再计算
+    struct Node
+    {
+        QList<Node *> children;
+        QString name;
+        Node *parent;
+        int row;
+        quint8 fetched : 1;
+        quint8 fetching : 1;
+        quint8 type : 2;
+    };
+    // 文件列表为空时扫描整个项目
+    struct SmaliJob
+    {
+        QStringList files;
+        quint64 request;
+        QPointer<QThread> thread;
+    };
+    QIcon m_FolderIcon;
+    mutable QHash<QString, QIcon> m_IconCache;
+    QFileIconProvider m_IconProvider;
+    QHash<QString, quint64> m_IndexRequests;
+    QList<QPointer<QThread>> m_IndexThreads;
+    QMap<QString, ProjectNameIndex> m_Indexes;
+    QSet<QString> m_Names;
+    QHash<quint64, Node *> m_Pending;
+    quint64 m_Request;
+    QString m_Reveal;
+    Node *m_Root;
+    QMap<QString, SmaliIndex> m_SmaliIndexes;
+    QHash<QString, SmaliJob> m_SmaliJobs;
+    QHash<QString, SmaliJob> m_SmaliPending;
+    QThread *m_Thread;
+    QSet<QString> m_Wanted;
+    DirectoryEnumerateWorker *m_Worker;
+    void clearChildren(Node *node);
+    void continueReveal();
+    void fetchWanted(Node *node);
+    void forget(Node *node);
+    QIcon iconOf(const Node *node) const;
+    QModelIndex indexOf(Node *node) const;
+    void indexProject(Node *project);
+    QString intern(const QString &name);
+    void matchLoaded(const Node *node, const QString &filter, QStringList &matches, const int limit) const;
+    Node *nodeOf(const QModelIndex &index) const;
+    QString pathOf(const Node *node) const;
+    void queueSmaliJob(const QString &folder, const QStringList &files);
+    void startSmaliJob(const QString &folder);
+private slots:
+    void handleEntriesEnumerated(const quint64 request, const QList<DirectoryEntry> &entries, const bool last);
+    void handleIndexFinished(const quint64 request, const QString &folder, const ProjectNameIndex &index);
+    void handleSmaliIndexFinished(const quint64 request, const QString &folder, const SmaliIndex &index);
+    void handleSmaliJobFinished(const QString &folder);
+signals:
+    void enumerateRequested(const quint64 request, const QString &folder);
+    void pathRevealed(const QModelIndex &index);
+    void projectIndexed(const QString &folder);
+    void smaliIndexed(const QString &folder);
+};
+
+class ProjectTreeFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+public:
+    explicit ProjectTreeFilterModel(QObject *parent = nullptr);
+    void clearFilterPaths();
+    bool isFiltering() const;
+    void setFilterPaths(const QSet<QString> &paths);
+protected:
+    bool filterAcceptsRow(int row, const QModelIndex &parent) const override;
+private:
+    bool m_Filtering;
+    QSet<QString> m_Paths;
+};
+
+#endif // PROJECTTREEMODEL_H
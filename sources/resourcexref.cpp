@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+#include <QXmlStreamReader>
+#include <QtEndian>
+#include "resourcexref.h"
+
+#define RESOURCE_XREF_CHUNK 256
+#define RESOURCE_XREF_DIR ".apkstudio"
+#define RESOURCE_XREF_FILE "resources.idx"
+#define RESOURCE_XREF_MAGIC "ASRX"
+#define RESOURCE_XREF_VERSION 2
+
+// 文件格式（小端序）：
+//   文件头   magic[4] version resourceCount referenceCount stringsSize（各 4 字节）
+//   资源表   resourceCount × { id(4) nameOffset(4) nameLength(4) }，按编号排序
+//   名称表   resourceCount × { resource(4) }，按名称（type/name）排序
+//   引用表   referenceCount × { id(4) pathOffset(4) pathLength(4) line(4) }，按编号排序
+//   字符串   资源名称和相对于项目根目录的 smali 路径，UTF-8
+#define HEADER_SIZE 20
+#define NAME_RECORD_SIZE 4
+#define REFERENCE_RECORD_SIZE 16
+#define RESOURCE_RECORD_SIZE 12
+
+struct ResourceHit
+{
+    quint32 id;
+    quint32 line;
+};
+
+template <typename T>
+static void appendValue(QByteArray &out, const T value)
+{
+    const T le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(T));
+}
+
+static QByteArray normalize(QByteArray name)
+{
+    // R 类中字段名的点被替换为下划线，例如 Theme.AppCompat 对应 R$style;->Theme_AppCompat
+    return name.replace('.', '_');
+}
+
+static QVector<ResourceHit> scan(const QString &path, const QSet<quint32> &ids, const QHash<QByteArray, quint32> &names)
+{
+    // 只查找 const 指令中的资源编号和对 R$type;->name 字段的访问
+    QVector<ResourceHit> hits;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || (file.size() == 0)) {
+        return hits;
+    }
+    QByteArray content;
+    const char *data = reinterpret_cast<const char *>(file.map(0, file.size()));
+    if (!data) {
+        content = file.readAll();
+        data = content.constData();
+    }
+    const char *p = data;
+    const char *end = data + file.size();
+    quint32 line = 0;
+    while (p < end) {
+        const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!eol) {
+            eol = end;
+        }
+        line++;
+        const QByteArray text = QByteArray::fromRawData(p, int(eol - p));
+        const int hex = text.indexOf(", 0x");
+        if ((hex >= 0) && text.trimmed().startsWith("const")) {
+            bool ok;
+            const quint32 id = text.mid(hex + 2, 10).trimmed().toUInt(&ok, 0);
+            if (ok && ids.contains(id)) {
+                hits.append(ResourceHit{id, line});
+            }
+        }
+        const int field = text.indexOf("/R$");
+        if (field >= 0) {
+            const int semicolon = text.indexOf(";->", field);
+            const int colon = text.indexOf(':', semicolon);
+            if ((semicolon > field) && (colon > semicolon)) {
+                const QByteArray key = text.mid(field + 3, semicolon - field - 3) + '/' + text.mid(semicolon + 3, colon - semicolon - 3);
+                auto it = names.constFind(key);
+                if (it != names.constEnd()) {
+                    hits.append(ResourceHit{it.value(), line});
+                }
+            }
+        }
+        p = eol + 1;
+    }
+    return hits;
+}
+
+ResourceXref::ResourceXref(const QString &folder)
+    : m_Data(nullptr), m_Folder(folder), m_ReferenceCount(0), m_ResourceCount(0), m_StringsSize(0)
+{
+}
+
+bool ResourceXref::build(const std::function<bool()> &cancelled)
+{
+    // public.xml 给出资源名称与编号的对应关系，反编译结果中没有它时无法建立索引
+    QFile xml(QDir(m_Folder).filePath("res/values/public.xml"));
+    if (!xml.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QHash<QByteArray, quint32> names;
+    QSet<quint32> ids;
+    QXmlStreamReader reader(&xml);
+    while (!reader.atEnd()) {
+        if ((reader.readNext() == QXmlStreamReader::StartElement) && (reader.name() == QLatin1String("public"))) {
+            const QXmlStreamAttributes attributes = reader.attributes();
+            bool ok;
+            const quint32 id = attributes.value("id").toUInt(&ok, 0);
+            if (ok) {
+                names.insert(attributes.value("type").toUtf8() + '/' + normalize(attributes.value("name").toUtf8()), id);
+                ids.insert(id);
+            }
+        }
+    }
+    QStringList files;
+    const QString prefix = m_Folder + '/';
+    QDirIterator it(m_Folder, {"*.smali"}, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (path.startsWith(prefix)) {
+            files.append(path.mid(prefix.size()));
+        }
+    }
+    // smali 文件分批并行扫描
+    QVector<QVector<ResourceHit>> hits(files.size());
+    QThreadPool pool;
+    for (int base = 0; base < files.size(); base += RESOURCE_XREF_CHUNK) {
+        if (cancelled()) {
+            return false;
+        }
+        const int count = qMin(RESOURCE_XREF_CHUNK, int(files.size()) - base);
+        for (int j = base; j < base + count; ++j) {
+            const QString path = prefix + files.at(j);
+            QVector<ResourceHit> *result = &hits[j];
+            pool.start([result, path, &ids, &names] {
+                *result = scan(path, ids, names);
+            });
+        }
+        pool.waitForDone();
+    }
+    // 生成索引映像
+    QByteArray strings;
+    QVector<QPair<quint32, QByteArray>> resources;
+    resources.reserve(names.size());
+    for (auto entry = names.constBegin(); entry != names.constEnd(); ++entry) {
+        resources.append(qMakePair(entry.value(), entry.key()));
+    }
+    std::sort(resources.begin(), resources.end());
+    QByteArray resourceTable;
+    QVector<quint32> order(resources.size());
+    for (int i = 0; i < resources.size(); ++i) {
+        appendValue<quint32>(resourceTable, resources.at(i).first);
+        appendValue<quint32>(resourceTable, strings.size());
+        appendValue<quint32>(resourceTable, resources.at(i).second.size());
+        strings.append(resources.at(i).second);
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&resources](const quint32 a, const quint32 b) {
+        return resources.at(a).second < resources.at(b).second;
+    });
+    QByteArray nameTable;
+    foreach (auto index, order) {
+        appendValue<quint32>(nameTable, index);
+    }
+    struct Reference
+    {
+        quint32 id;
+        quint32 file;
+        quint32 line;
+        bool operator<(const Reference &other) const
+        {
+            return std::tie(id, file, line) < std::tie(other.id, other.file, other.line);
+        }
+    };
+    QVector<Reference> references;
+    for (int i = 0; i < hits.size(); ++i) {
+        foreach (const ResourceHit &hit, hits.at(i)) {
+            references.append(Reference{hit.id, quint32(i), hit.line});
+        }
+    }
+    std::sort(references.begin(), references.end());
+    QByteArray referenceTable;
+    QHash<quint32, QPair<quint32, quint32>> paths;
+    foreach (const Reference &reference, references) {
+        auto path = paths.find(reference.file);
+        if (path == paths.end()) {
+            // 同一文件的路径只保存一次
+            const QByteArray bytes = files.at(reference.file).toUtf8();
+            path = paths.insert(reference.file, qMakePair(quint32(strings.size()), quint32(bytes.size())));
+            strings.append(bytes);
+        }
+        appendValue<quint32>(referenceTable, reference.id);
+        appendValue<quint32>(referenceTable, path.value().first);
+        appendValue<quint32>(referenceTable, path.value().second);
+        appendValue<quint32>(referenceTable, reference.line);
+    }
+#ifdef QT_DEBUG
+    qDebug() << "资源交叉索引" << m_Folder << resources.size() << "个资源" << references.size() << "处引用";
+#endif
+    QByteArray image(RESOURCE_XREF_MAGIC, 4);
+    appendValue<quint32>(image, RESOURCE_XREF_VERSION);
+    appendValue<quint32>(image, resources.size());
+    appendValue<quint32>(image, references.size());
+    appendValue<quint32>(image, strings.size());
+    image.append(resourceTable).append(nameTable).append(referenceTable).append(strings);
+    m_File.close();
+    m_Buffer = image;
+    return parse(reinterpret_cast<const uchar *>(m_Buffer.constData()), m_Buffer.size());
+}
+
+QByteArray ResourceXref::bytes(const uchar *record) const
+{
+    // 返回映射中的原始字节，不复制数据
+    const uchar *strings = m_Data + HEADER_SIZE + (m_ResourceCount * (RESOURCE_RECORD_SIZE + NAME_RECORD_SIZE)) + (m_ReferenceCount * REFERENCE_RECORD_SIZE);
+    const quint32 offset = qFromLittleEndian<quint32>(record);
+    const quint32 length = qFromLittleEndian<quint32>(record + 4);
+    if ((offset > m_StringsSize) || (length > (m_StringsSize - offset))) {
+        return QByteArray();
+    }
+    return QByteArray::fromRawData(reinterpret_cast<const char *>(strings + offset), int(length));
+}
+
+bool ResourceXref::exists() const
+{
+    return QFile::exists(indexFile());
+}
+
+quint32 ResourceXref::find(const QString &text) const
+{
+    // 从一行 smali 或 public.xml 中识别所引用的资源，依次尝试编号、R 类字段和 public 元素
+    static const QRegularExpression hex("0x[0-9a-fA-F]{8}\\b");
+    static const QRegularExpression field("/R\\$(\\w+);->([\\w$]+):");
+    static const QRegularExpression element("type=\"(\\w+)\"\\s+name=\"([^\"]+)\"");
+    QRegularExpressionMatchIterator matches = hex.globalMatch(text);
+    while (matches.hasNext()) {
+        quint32 index;
+        const quint32 id = matches.next().captured().toUInt(nullptr, 0);
+        if (findResource(id, index)) {
+            return id;
+        }
+    }
+    QRegularExpressionMatch match = field.match(text);
+    if (!match.hasMatch()) {
+        match = element.match(text);
+    }
+    return match.hasMatch() ? id(match.captured(1) + '/' + match.captured(2)) : 0;
+}
+
+bool ResourceXref::findResource(const quint32 id, quint32 &index) const
+{
+    const uchar *table = m_Data + HEADER_SIZE;
+    quint32 low = 0;
+    quint32 high = m_ResourceCount;
+    while (low < high) {
+        const quint32 middle = low + ((high - low) / 2);
+        const quint32 current = qFromLittleEndian<quint32>(table + (middle * RESOURCE_RECORD_SIZE));
+        if (current == id) {
+            index = middle;
+            return true;
+        }
+        if (current < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+quint32 ResourceXref::id(const QString &name) const
+{
+    const QByteArray key = normalize(name.toUtf8());
+    const uchar *resources = m_Data + HEADER_SIZE;
+    const uchar *table = resources + (m_ResourceCount * RESOURCE_RECORD_SIZE);
+    quint32 low = 0;
+    quint32 high = m_ResourceCount;
+    while (low < high) {
+        const quint32 middle = low + ((high - low) / 2);
+        const quint32 index = qFromLittleEndian<quint32>(table + (middle * NAME_RECORD_SIZE));
+        if (index >= m_ResourceCount) {
+            return 0;
+        }
+        const uchar *record = resources + (index * RESOURCE_RECORD_SIZE);
+        const int order = bytes(record + 4).compare(key);
+        if (order == 0) {
+            return qFromLittleEndian<quint32>(record);
+        }
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return 0;
+}
+
+QString ResourceXref::indexFile() const
+{
+    return QDir(m_Folder).filePath(QString(RESOURCE_XREF_DIR) + '/' + RESOURCE_XREF_FILE);
+}
+
+bool ResourceXref::load()
+{
+    m_File.setFileName(indexFile());
+    if (!m_File.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const uchar *data = m_File.map(0, m_File.size());
+    if (data && parse(data, m_File.size())) {
+        return true;
+    }
+#ifdef QT_DEBUG
+    qDebug() << "忽略无效的资源索引" << m_File.fileName();
+#endif
+    m_File.close();
+    parse(nullptr, 0);
+    return false;
+}
+
+QDateTime ResourceXref::modified() const
+{
+    return QFileInfo(indexFile()).lastModified();
+}
+
+QString ResourceXref::name(const quint32 id) const
+{
+    quint32 index;
+    if (!findResource(id, index)) {
+        return QString();
+    }
+    return string(m_Data + HEADER_SIZE + (index * RESOURCE_RECORD_SIZE) + 4);
+}
+
+bool ResourceXref::parse(const uchar *data, const qint64 size)
+{
+    m_Data = nullptr;
+    m_ResourceCount = m_ReferenceCount = m_StringsSize = 0;
+    if (!data || (size < HEADER_SIZE) || (memcmp(data, RESOURCE_XREF_MAGIC, 4) != 0)
+            || (qFromLittleEndian<quint32>(data + 4) != RESOURCE_XREF_VERSION)) {
+        return false;
+    }
+    const quint32 resourceCount = qFromLittleEndian<quint32>(data + 8);
+    const quint32 referenceCount = qFromLittleEndian<quint32>(data + 12);
+    const quint32 stringsSize = qFromLittleEndian<quint32>(data + 16);
+    const qint64 expected = HEADER_SIZE + (qint64(resourceCount) * (RESOURCE_RECORD_SIZE + NAME_RECORD_SIZE))
+            + (qint64(referenceCount) * REFERENCE_RECORD_SIZE) + stringsSize;
+    if (expected != size) {
+        return false;
+    }
+    m_Data = data;
+    m_ResourceCount = resourceCount;
+    m_ReferenceCount = referenceCount;
+    m_StringsSize = stringsSize;
+    return true;
+}
+
+QList<ResourceReference> ResourceXref::references(const quint32 id) const
+{
+    // 引用表按编号排序，二分查找第一条后顺序读取
+    QList<ResourceReference> results;
+    const uchar *table = m_Data + HEADER_SIZE + (m_ResourceCount * (RESOURCE_RECORD_SIZE + NAME_RECORD_SIZE));
+    quint32 low = 0;
+    quint32 high = m_ReferenceCount;
+    while (low < high) {
+        const quint32 middle = low + ((high - low) / 2);
+        if (qFromLittleEndian<quint32>(table + (middle * REFERENCE_RECORD_SIZE)) < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    for (quint32 i = low; i < m_ReferenceCount; ++i) {
+        const uchar *record = table + (i * REFERENCE_RECORD_SIZE);
+        if (qFromLittleEndian<quint32>(record) != id) {
+            break;
+        }
+        results.append(ResourceReference{int(qFromLittleEndian<quint32>(record + 12)), m_Folder + '/' + string(record + 4)});
+    }
+    return results;
+}
+
+bool ResourceXref::save()
+{
+    if (m_Buffer.isEmpty()) {
+        return false;
+    }
+    QDir(m_Folder).mkpath(RESOURCE_XREF_DIR);
+    QSaveFile file(indexFile());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(m_Buffer);
+    return file.commit();
+}
+
+QString ResourceXref::string(const uchar *record) const
+{
+    return QString::fromUtf8(bytes(record));
+}
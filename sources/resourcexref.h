@@ -0,0 +1,46 @@
+#ifndef RESOURCEXREF_H
+#define RESOURCEXREF_H
+
+#include <functional>
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+struct ResourceReference
+{
+    int line;
+    QString path;
+};
+
+// 资源编号、public.xml 中的名称与 smali 中引用位置之间的交叉索引，保存后以映射方式读取
+class ResourceXref
+{
+public:
+    explicit ResourceXref(const QString &folder);
+    bool build(const std::function<bool()> &cancelled);
+    bool exists() const;
+    quint32 find(const QString &text) const;
+    quint32 id(const QString &name) const;
+    bool load();
+    QDateTime modified() const;
+    QString name(const quint32 id) const;
+    QList<ResourceReference> references(const quint32 id) const;
+    bool save();
+private:
+    QByteArray m_Buffer;
+    const uchar *m_Data;
+    QFile m_File;
+    QString m_Folder;
+    quint32 m_ReferenceCount;
+    quint32 m_ResourceCount;
+    quint32 m_StringsSize;
+    QByteArray bytes(const uchar *record) const;
+    bool findResource(const quint32 id, quint32 &index) const;
+    QString indexFile() const;
+    bool parse(const uchar *data, const qint64 size);
+    QString string(const uchar *record) const;
+};
+
+#endif // RESOURCEXREF_H
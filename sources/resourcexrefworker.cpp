@@ -0,0 +1,27 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include "resourcexref.h"
+#include "resourcexrefworker.h"
+
+ResourceXrefWorker::ResourceXrefWorker(const QString &folder, QObject *parent)
+    : QObject(parent), m_Folder(folder)
+{
+}
+
+void ResourceXrefWorker::build()
+{
+#ifdef QT_DEBUG
+    QElapsedTimer timer;
+    timer.start();
+#endif
+    ResourceXref xref(m_Folder);
+    const bool success = xref.build([this] {
+        return thread()->isInterruptionRequested();
+    }) && xref.save();
+#ifdef QT_DEBUG
+    qDebug() << "资源交叉索引完成" << m_Folder << success << timer.elapsed() << "毫秒";
+#endif
+    emit xrefBuilt(m_Folder, success);
+    emit finished();
+}
@@ -0,0 +1,19 @@
+#ifndef RESOURCEXREFWORKER_H
+#define RESOURCEXREFWORKER_H
+
+#include <QObject>
+
+class ResourceXrefWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ResourceXrefWorker(const QString &folder, QObject *parent = nullptr);
+    void build();
+private:
+    QString m_Folder;
+signals:
+    void finished();
+    void xrefBuilt(const QString &folder, const bool success);
+};
+
+#endif // RESOURCEXREFWORKER_H
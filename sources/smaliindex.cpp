@@ -0,0 +1,573 @@
+#include <cstring>
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QThreadPool>
+#include "smaliindex.h"
+
+#define SMALI_INDEX_CHUNK 256
+#define SMALI_INDEX_DIR ".apkstudio"
+#define SMALI_INDEX_FILE "smali.idx"
+#define SMALI_INDEX_JOURNAL "smali.log"
+#define SMALI_INDEX_JOURNAL_LIMIT (4 * 1024 * 1024)
+#define SMALI_INDEX_JOURNAL_MAGIC 0x41534D4A
+#define SMALI_INDEX_MAGIC 0x41534D49
+#define SMALI_INDEX_VERSION 2
+
+static bool startsWith(const char *begin, const char *end, const char *prefix)
+{
+    const size_t length = strlen(prefix);
+    return (size_t(end - begin) >= length) && (memcmp(begin, prefix, length) == 0);
+}
+
+static void parseTypes(const char *begin, const char *end, QList<QByteArray> &types)
+{
+    // 描述符中除类名外都是单个字符，遇到 L 就读到分号为止
+    while (begin < end) {
+        if (*begin != 'L') {
+            begin++;
+            continue;
+        }
+        const char *stop = static_cast<const char *>(memchr(begin, ';', end - begin));
+        if (!stop) {
+            return;
+        }
+        const QByteArray type(begin, int(stop + 1 - begin));
+        if (!types.contains(type)) {
+            types.append(type);
+        }
+        begin = stop + 1;
+    }
+}
+
+static bool parseLine(const char *begin, const char *end, char &kind, QByteArray &token, QList<QByteArray> &types)
+{
+    // 去掉缩进和行尾空白后按指令前缀判断，类、方法和引用目标都是一行的最后一个词
+    while ((begin < end) && ((*begin == ' ') || (*begin == '\t'))) {
+        begin++;
+    }
+    while ((end > begin) && ((end[-1] == ' ') || (end[-1] == '\t') || (end[-1] == '\r'))) {
+        end--;
+    }
+    if (startsWith(begin, end, ".class ")) {
+        kind = 'c';
+    } else if (startsWith(begin, end, ".method ")) {
+        kind = 'm';
+    } else if (startsWith(begin, end, ".field ")) {
+        kind = 'f';
+    } else if (startsWith(begin, end, "invoke-") || startsWith(begin, end, "iget") || startsWith(begin, end, "iput")
+               || startsWith(begin, end, "sget") || startsWith(begin, end, "sput")) {
+        kind = 'r';
+    } else if (startsWith(begin, end, ".super ") || startsWith(begin, end, ".implements ") || startsWith(begin, end, ".catch ")
+               || startsWith(begin, end, ".annotation ") || startsWith(begin, end, "new-instance ") || startsWith(begin, end, "new-array ")
+               || startsWith(begin, end, "check-cast ") || startsWith(begin, end, "const-class ") || startsWith(begin, end, "instance-of ")
+               || startsWith(begin, end, "filled-new-array")) {
+        // 这些行只引用类型，寄存器、标签和注解的可见性都不含大写的 L
+        kind = 't';
+        const char *operands = static_cast<const char *>(memchr(begin, ' ', end - begin));
+        if (operands) {
+            parseTypes(operands, end, types);
+        }
+        if (!types.isEmpty()) {
+            token = types.first();
+        }
+        return !types.isEmpty();
+    } else {
+        return false;
+    }
+    const char *first = end;
+    while ((first > begin) && (first[-1] != ' ') && (first[-1] != '\t')) {
+        first--;
+    }
+    if (kind == 'f') {
+        // 字段可能带有初始值，取第一个包含冒号的词
+        const char *word = begin;
+        while (word < end) {
+            const char *stop = word;
+            while ((stop < end) && (*stop != ' ') && (*stop != '\t')) {
+                stop++;
+            }
+            if (memchr(word, ':', stop - word)) {
+                first = word;
+                end = stop;
+                break;
+            }
+            word = stop + 1;
+        }
+    }
+    token = QByteArray(first, int(end - first));
+    int signature = 0;
+    if (kind == 'r') {
+        signature = token.indexOf("->");
+        if (signature < 0) {
+            // invoke-custom 等指令的目标不是方法引用
+            return false;
+        }
+        // 所属类由成员引用本身表示，只收集参数、返回值和字段的类型
+        signature += 2;
+    }
+    if (kind != 'c') {
+        // 方法签名从括号开始，字段类型在冒号之后
+        while ((signature < token.size()) && (token.at(signature) != '(') && (token.at(signature) != ':')) {
+            signature++;
+        }
+        parseTypes(token.constData() + signature, token.constData() + token.size(), types);
+    }
+    return !token.isEmpty();
+}
+
+SmaliIndex::SmaliIndex()
+{
+}
+
+SmaliIndex::SmaliIndex(const QString &folder)
+    : m_Folder(folder)
+{
+}
+
+bool SmaliIndex::append(const QStringList &paths) const
+{
+    // 保存单个文件后只把它的符号追加到日志中，日志过大时再重写整个索引文件
+    QFile file(journalFile());
+    if (!QFileInfo::exists(indexFile()) || (file.size() > SMALI_INDEX_JOURNAL_LIMIT)) {
+        return save();
+    }
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    if (file.size() == 0) {
+        out << quint32(SMALI_INDEX_JOURNAL_MAGIC) << quint32(SMALI_INDEX_VERSION);
+    }
+    foreach (const QString &path, paths) {
+        auto it = m_FileIds.constFind(path);
+        if (it == m_FileIds.constEnd()) {
+            // 修改时间为 -1 表示文件已被删除
+            out << qint64(-1) << qint64(0) << path << quint32(0);
+            continue;
+        }
+        const File &entry = m_Files.at(it.value());
+        out << entry.modified << entry.size << entry.path << quint32(entry.symbols.size());
+        foreach (const Symbol &symbol, entry.symbols) {
+            out << symbol.kind << symbol.line << m_Names.at(symbol.name);
+        }
+    }
+    return (out.status() == QDataStream::Ok) && file.flush();
+}
+
+void SmaliIndex::buildLookups()
+{
+    m_FileIds.clear();
+    m_FileIds.reserve(m_Files.size());
+    for (int i = 0; i < m_Files.size(); ++i) {
+        m_FileIds.insert(m_Files.at(i).path, i);
+    }
+    m_NameIds.clear();
+    m_NameIds.reserve(m_Names.size());
+    for (int i = 0; i < m_Names.size(); ++i) {
+        m_NameIds.insert(m_Names.at(i), quint32(i));
+    }
+}
+
+QList<SmaliSymbol> SmaliIndex::definitions(const QString &filter, const int limit) const
+{
+    QList<SmaliSymbol> results;
+    foreach (const File &file, m_Files) {
+        foreach (const Symbol &symbol, file.symbols) {
+            if ((symbol.kind != 'r') && (symbol.kind != 't') && m_Names.at(symbol.name).contains(filter, Qt::CaseInsensitive)) {
+                results.append(SmaliSymbol{char(symbol.kind), int(symbol.line), m_Names.at(symbol.name), m_Folder + '/' + file.path});
+                if (results.size() >= limit) {
+                    return results;
+                }
+            }
+        }
+    }
+    return results;
+}
+
+QString SmaliIndex::folder() const
+{
+    return m_Folder;
+}
+
+QString SmaliIndex::indexFile() const
+{
+    return QDir(m_Folder).filePath(QString(SMALI_INDEX_DIR) + '/' + SMALI_INDEX_FILE);
+}
+
+QString SmaliIndex::journalFile() const
+{
+    return QDir(m_Folder).filePath(QString(SMALI_INDEX_DIR) + '/' + SMALI_INDEX_JOURNAL);
+}
+
+quint32 SmaliIndex::intern(const QString &name)
+{
+    // 同一个方法会在许多文件中被调用，名称只保存一份
+    auto it = m_NameIds.constFind(name);
+    if (it != m_NameIds.constEnd()) {
+        return it.value();
+    }
+    const quint32 id = m_Names.size();
+    m_Names.append(name);
+    m_NameIds.insert(name, id);
+    return id;
+}
+
+bool SmaliIndex::isEmpty() const
+{
+    return m_Files.isEmpty();
+}
+
+bool SmaliIndex::load()
+{
+    QFile file(indexFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic;
+    quint32 version;
+    in >> magic >> version;
+    if ((magic != SMALI_INDEX_MAGIC) || (version != SMALI_INDEX_VERSION)) {
+        return false;
+    }
+    QStringList names;
+    quint32 count;
+    in >> names >> count;
+    QVector<File> files;
+    for (quint32 i = 0; (i < count) && (in.status() == QDataStream::Ok); ++i) {
+        File entry;
+        quint32 symbols;
+        in >> entry.modified >> entry.size >> entry.path >> symbols;
+        entry.symbols.reserve(qMin<quint32>(symbols, 1 << 16));
+        for (quint32 j = 0; (j < symbols) && (in.status() == QDataStream::Ok); ++j) {
+            Symbol symbol;
+            in >> symbol.kind >> symbol.line >> symbol.name;
+            if (symbol.name >= quint32(names.size())) {
+                in.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            entry.symbols.append(symbol);
+        }
+        files.append(entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+#ifdef QT_DEBUG
+        qDebug() << "忽略无效的符号索引" << file.fileName();
+#endif
+        return false;
+    }
+    m_Files = files;
+    m_Names = names;
+    buildLookups();
+    replay();
+    return true;
+}
+
+QList<SmaliSymbol> SmaliIndex::outline(const QString &path) const
+{
+    QList<SmaliSymbol> results;
+    const QString prefix = m_Folder + '/';
+    if (!path.startsWith(prefix)) {
+        return results;
+    }
+    auto it = m_FileIds.constFind(path.mid(prefix.size()));
+    if (it == m_FileIds.constEnd()) {
+        return results;
+    }
+    foreach (const Symbol &symbol, m_Files.at(it.value()).symbols) {
+        if ((symbol.kind != 'r') && (symbol.kind != 't')) {
+            results.append(SmaliSymbol{char(symbol.kind), int(symbol.line), m_Names.at(symbol.name), path});
+        }
+    }
+    return results;
+}
+
+QList<SmaliSymbol> SmaliIndex::parse(const char *data, const qint64 size)
+{
+    QList<SmaliSymbol> symbols;
+    QString owner;
+    const char *p = data;
+    const char *end = data + size;
+    int line = 0;
+    char kind;
+    QByteArray token;
+    QList<QByteArray> types;
+    while (p < end) {
+        const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (!eol) {
+            eol = end;
+        }
+        line++;
+        types.clear();
+        if (parseLine(p, eol, kind, token, types)) {
+            QString name = QString::fromUtf8(token);
+            if (kind == 'c') {
+                owner = name;
+            } else if ((kind == 'm') || (kind == 'f')) {
+                // 方法和字段以所属类限定，与调用处的写法一致
+                name = owner + "->" + name;
+            }
+            if (kind != 't') {
+                symbols.append(SmaliSymbol{kind, line, name, QString()});
+            }
+            foreach (const QByteArray &type, types) {
+                symbols.append(SmaliSymbol{'t', line, QString::fromUtf8(type), QString()});
+            }
+        }
+        p = eol + 1;
+    }
+    return symbols;
+}
+
+QList<SmaliSymbol> SmaliIndex::parseFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || (file.size() == 0)) {
+        return QList<SmaliSymbol>();
+    }
+    const uchar *data = file.map(0, file.size());
+    if (data) {
+        return parse(reinterpret_cast<const char *>(data), file.size());
+    }
+    const QByteArray content = file.readAll();
+    return parse(content.constData(), content.size());
+}
+
+bool SmaliIndex::patch(const QStringList &paths)
+{
+    // 只重新解析指定的文件，其余文件的符号和名称表保持不变
+    bool changed = false;
+    foreach (const QString &path, paths) {
+        const QFileInfo info(m_Folder + '/' + path);
+        if (!info.isFile()) {
+            changed = remove(path) || changed;
+            continue;
+        }
+        const qint64 modified = info.lastModified().toMSecsSinceEpoch();
+        auto it = m_FileIds.constFind(path);
+        if ((it != m_FileIds.constEnd()) && (m_Files.at(it.value()).modified == modified) && (m_Files.at(it.value()).size == info.size())) {
+            continue;
+        }
+        File entry{modified, path, info.size(), QVector<Symbol>()};
+        foreach (const SmaliSymbol &symbol, parseFile(info.filePath())) {
+            entry.symbols.append(Symbol{quint8(symbol.kind), quint32(symbol.line), intern(symbol.name)});
+        }
+        replace(entry);
+        changed = true;
+    }
+    return changed;
+}
+
+bool SmaliIndex::remove(const QString &path)
+{
+    auto it = m_FileIds.find(path);
+    if (it == m_FileIds.end()) {
+        return false;
+    }
+    // 用最后一个文件填补空位，其他文件的编号不变
+    const int id = it.value();
+    m_FileIds.erase(it);
+    if (id != (m_Files.size() - 1)) {
+        m_Files[id] = m_Files.last();
+        m_FileIds.insert(m_Files.at(id).path, id);
+    }
+    m_Files.removeLast();
+    return true;
+}
+
+void SmaliIndex::replace(const File &entry)
+{
+    auto it = m_FileIds.constFind(entry.path);
+    if (it != m_FileIds.constEnd()) {
+        m_Files[it.value()] = entry;
+    } else {
+        m_FileIds.insert(entry.path, m_Files.size());
+        m_Files.append(entry);
+    }
+}
+
+void SmaliIndex::replay()
+{
+    QFile file(journalFile());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic;
+    quint32 version;
+    in >> magic >> version;
+    if ((magic != SMALI_INDEX_JOURNAL_MAGIC) || (version != SMALI_INDEX_VERSION)) {
+        return;
+    }
+    while (!in.atEnd()) {
+        File entry;
+        quint32 symbols;
+        in >> entry.modified >> entry.size >> entry.path >> symbols;
+        entry.symbols.reserve(qMin<quint32>(symbols, 1 << 16));
+        for (quint32 j = 0; (j < symbols) && (in.status() == QDataStream::Ok); ++j) {
+            Symbol symbol;
+            QString name;
+            in >> symbol.kind >> symbol.line >> name;
+            symbol.name = intern(name);
+            entry.symbols.append(symbol);
+        }
+        if (in.status() != QDataStream::Ok) {
+            // 追加日志时程序退出，丢弃最后一条不完整的记录
+            break;
+        }
+        if (entry.modified < 0) {
+            remove(entry.path);
+        } else {
+            replace(entry);
+        }
+    }
+}
+
+bool SmaliIndex::save() const
+{
+    QDir(m_Folder).mkpath(SMALI_INDEX_DIR);
+    QSaveFile file(indexFile());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << quint32(SMALI_INDEX_MAGIC) << quint32(SMALI_INDEX_VERSION) << m_Names << quint32(m_Files.size());
+    foreach (const File &entry, m_Files) {
+        out << entry.modified << entry.size << entry.path << quint32(entry.symbols.size());
+        foreach (const Symbol &symbol, entry.symbols) {
+            out << symbol.kind << symbol.line << symbol.name;
+        }
+    }
+    if (out.status() != QDataStream::Ok) {
+        return false;
+    }
+    if (!file.commit()) {
+        return false;
+    }
+    // 新的索引文件已经包含日志中的修改，提交成功后才能删除日志
+    QFile::remove(journalFile());
+    return true;
+}
+
+QString SmaliIndex::target(const QString &line, const QString &owner)
+{
+    // 返回一行代码所定义或引用的符号，名称格式与索引中的一致
+    const QByteArray bytes = line.toUtf8();
+    char kind;
+    QByteArray token;
+    QList<QByteArray> types;
+    if (!parseLine(bytes.constData(), bytes.constData() + bytes.size(), kind, token, types)) {
+        return QString();
+    }
+    const QString name = QString::fromUtf8(token);
+    return ((kind == 'm') || (kind == 'f')) ? (owner + "->" + name) : name;
+}
+
+bool SmaliIndex::update(const QList<SmaliIndexEntry> &files, const std::function<bool()> &cancelled, const std::function<void(int, int)> &progress)
+{
+    // 修改时间和大小都未变化的文件沿用旧的符号，只重新解析新增或修改过的文件
+    QVector<int> kept;
+    QVector<int> changed;
+    for (int i = 0; i < files.size(); ++i) {
+        const SmaliIndexEntry &entry = files.at(i);
+        auto it = m_FileIds.constFind(entry.path);
+        if ((it != m_FileIds.constEnd()) && (m_Files.at(it.value()).modified == entry.modified) && (m_Files.at(it.value()).size == entry.size)) {
+            kept.append(it.value());
+        } else {
+            changed.append(i);
+        }
+    }
+    if (changed.isEmpty() && (kept.size() == m_Files.size())) {
+        return false;
+    }
+#ifdef QT_DEBUG
+    qDebug() << "更新符号索引" << m_Folder << "保留" << kept.size() << "个文件，重新解析" << changed.size() << "个文件";
+#endif
+    // 重新生成名称表，已删除文件的名称不再保留
+    const QVector<File> previous = m_Files;
+    const QStringList names = m_Names;
+    m_Files.clear();
+    m_Names.clear();
+    m_NameIds.clear();
+    foreach (auto id, kept) {
+        File entry = previous.at(id);
+        for (int j = 0; j < entry.symbols.size(); ++j) {
+            entry.symbols[j].name = intern(names.at(entry.symbols.at(j).name));
+        }
+        m_Files.append(entry);
+    }
+    // 新增或修改过的文件分批并行解析，按顺序合并
+    QThreadPool pool;
+    for (int base = 0; base < changed.size(); base += SMALI_INDEX_CHUNK) {
+        if (cancelled()) {
+            return false;
+        }
+        const int count = qMin(SMALI_INDEX_CHUNK, changed.size() - base);
+        QVector<QList<SmaliSymbol>> chunk(count);
+        for (int j = 0; j < count; ++j) {
+            const QString path = m_Folder + '/' + files.at(changed.at(base + j)).path;
+            QList<SmaliSymbol> *symbols = &chunk[j];
+            pool.start([symbols, path] {
+                *symbols = parseFile(path);
+            });
+        }
+        pool.waitForDone();
+        for (int j = 0; j < count; ++j) {
+            const SmaliIndexEntry &source = files.at(changed.at(base + j));
+            File entry{source.modified, source.path, source.size, QVector<Symbol>()};
+            entry.symbols.reserve(chunk.at(j).size());
+            foreach (const SmaliSymbol &symbol, chunk.at(j)) {
+                entry.symbols.append(Symbol{quint8(symbol.kind), quint32(symbol.line), intern(symbol.name)});
+            }
+            m_Files.append(entry);
+        }
+        progress(base + count, changed.size());
+    }
+    buildLookups();
+    return true;
+}
+
+QList<SmaliSymbol> SmaliIndex::usages(const QString &target, const int limit) const
+{
+    QSet<quint32> ids;
+    if (target.endsWith(';') && !target.contains("->")) {
+        // 类的用法包括作为类型的引用以及对其所有成员的调用和访问
+        const QString prefix = target + "->";
+        for (int i = 0; i < m_Names.size(); ++i) {
+            if (m_Names.at(i).startsWith(prefix)) {
+                ids.insert(quint32(i));
+            }
+        }
+    }
+    auto it = m_NameIds.constFind(target);
+    if (it != m_NameIds.constEnd()) {
+        ids.insert(it.value());
+    }
+    QList<SmaliSymbol> results;
+    if (ids.isEmpty()) {
+        return results;
+    }
+    foreach (const File &file, m_Files) {
+        int last = -1;
+        foreach (const Symbol &symbol, file.symbols) {
+            // 同一行既调用了类的成员又以它为参数类型时只列出一次
+            if (((symbol.kind == 'r') || (symbol.kind == 't')) && (int(symbol.line) != last) && ids.contains(symbol.name)) {
+                last = int(symbol.line);
+                results.append(SmaliSymbol{char(symbol.kind), int(symbol.line), m_Names.at(symbol.name), m_Folder + '/' + file.path});
+                if (results.size() >= limit) {
+                    return results;
+                }
+            }
+        }
+    }
+    return results;
+}
@@ -0,0 +1,75 @@
+#ifndef SMALIINDEX_H
+#define SMALIINDEX_H
+
+#include <functional>
+#include <QHash>
+#include <QList>
+#include <QMetaType>
+#include <QStringList>
+#include <QVector>
+
+struct SmaliIndexEntry
+{
+    qint64 modified;
+    QString path;
+    qint64 size;
+};
+
+// kind 为 c（类）、f（字段）、m（方法）、r（invoke-* 调用以及字段读写的目标）或 t（签名和指令中引用的类型）
+struct SmaliSymbol
+{
+    char kind;
+    int line;
+    QString name;
+    QString path;
+};
+
+class SmaliIndex
+{
+public:
+    SmaliIndex();
+    explicit SmaliIndex(const QString &folder);
+    bool append(const QStringList &paths) const;
+    QList<SmaliSymbol> definitions(const QString &filter, const int limit) const;
+    QString folder() const;
+    bool isEmpty() const;
+    bool load();
+    QList<SmaliSymbol> outline(const QString &path) const;
+    static QList<SmaliSymbol> parse(const char *data, const qint64 size);
+    bool patch(const QStringList &paths);
+    bool save() const;
+    static QString target(const QString &line, const QString &owner);
+    bool update(const QList<SmaliIndexEntry> &files, const std::function<bool()> &cancelled, const std::function<void(int, int)> &progress);
+    QList<SmaliSymbol> usages(const QString &target, const int limit) const;
+private:
+    struct Symbol
+    {
+        quint8 kind;
+        quint32 line;
+        quint32 name;
+    };
+    struct File
+    {
+        qint64 modified;
+        QString path;
+        qint64 size;
+        QVector<Symbol> symbols;
+    };
+    QHash<QString, int> m_FileIds;
+    QVector<File> m_Files;
+    QString m_Folder;
+    QHash<QString, quint32> m_NameIds;
+    QStringList m_Names;
+    void buildLookups();
+    QString indexFile() const;
+    quint32 intern(const QString &name);
+    QString journalFile() const;
+    static QList<SmaliSymbol> parseFile(const QString &path);
+    bool remove(const QString &path);
+    void replace(const File &entry);
+    void replay();
+};
+
+Q_DECLARE_METATYPE(SmaliIndex);
+
+#endif // SMALIINDEX_H
@@ -0,0 +1,81 @@
+#include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThread>
+#include "smaliindexworker.h"
+
+SmaliIndexWorker::SmaliIndexWorker(const SmaliIndex &index, const QStringList &files, const quint64 request, QObject *parent)
+    : QObject(parent), m_Files(files), m_Folder(index.folder()), m_Index(index), m_Request(request)
+{
+}
+
+void SmaliIndexWorker::index()
+{
+    emit started();
+#ifdef QT_DEBUG
+    QElapsedTimer timer;
+    timer.start();
+#endif
+    if (!m_Files.isEmpty()) {
+        indexFiles();
+        return;
+    }
+    // 只有修改时间或大小变化的 smali 文件需要重新解析，其余沿用上次保存的索引
+    QList<SmaliIndexEntry> files;
+    const QString prefix = m_Folder + '/';
+    QDirIterator it(m_Folder, {"*.smali"}, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext() && !isCancelled()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        const QString path = info.filePath();
+        if (path.startsWith(prefix)) {
+            files.append(SmaliIndexEntry{info.lastModified().toMSecsSinceEpoch(), path.mid(prefix.size()), info.size()});
+        }
+    }
+    SmaliIndex index = m_Index;
+    if (index.isEmpty()) {
+        index.load();
+    }
+    const bool updated = !isCancelled() && index.update(files, [this] {
+        return isCancelled();
+    }, [](const int, const int) {
+    });
+    if (isCancelled()) {
+        emit finished();
+        return;
+    }
+    if (updated && !index.save()) {
+#ifdef QT_DEBUG
+        qDebug() << "无法保存符号索引" << m_Folder;
+#endif
+    }
+#ifdef QT_DEBUG
+    qDebug() << "符号索引完成" << m_Folder << timer.elapsed() << "毫秒";
+#endif
+    emit indexFinished(m_Request, m_Folder, index);
+    emit finished();
+}
+
+void SmaliIndexWorker::indexFiles()
+{
+    // 保存文件后只重新解析这些文件并追加到索引日志，不再遍历整个项目
+    SmaliIndex index = m_Index;
+    const bool updated = index.patch(m_Files);
+    if (isCancelled()) {
+        emit finished();
+        return;
+    }
+    if (updated && !index.append(m_Files)) {
+#ifdef QT_DEBUG
+        qDebug() << "无法保存符号索引" << m_Folder;
+#endif
+    }
+    emit indexFinished(m_Request, m_Folder, index);
+    emit finished();
+}
+
+bool SmaliIndexWorker::isCancelled() const
+{
+    return thread()->isInterruptionRequested();
+}
@@ -0,0 +1,26 @@
+#ifndef SMALIINDEXWORKER_H
+#define SMALIINDEXWORKER_H
+
+#include <QObject>
+#include "smaliindex.h"
+
+class SmaliIndexWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SmaliIndexWorker(const SmaliIndex &index, const QStringList &files, const quint64 request, QObject *parent = nullptr);
+    void index();
+private:
+    QStringList m_Files;
+    QString m_Folder;
+    SmaliIndex m_Index;
+    quint64 m_Request;
+    void indexFiles();
+    bool isCancelled() const;
+signals:
+    void finished();
+    void indexFinished(const quint64 request, const QString &folder, const SmaliIndex &index);
+    void started();
+};
+
+#endif // SMALIINDEXWORKER_H
@@ -1,22 +1,30 @@
 #include <QApplication>
+#include <QCryptographicHash>
+#include <QFile>
 #include <QFileInfo>
 #include <QPainter>
+#include <QPixmap>
 #include <QScrollBar>
 #include <QSettings>
 #include <QShortcut>
 #include <QTextBlock>
-#include <QTextStream>
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-#include <QStringConverter>
-#endif
+#include <QtMath>
+#include "filesaveworker.h"
 #include "sourcecodeedit.h"
 #include "themedsyntaxhighlighter.h"
 
+#define HIGHLIGHT_DEFERRED_BLOCKS 5000
+#define SAVE_CHUNK_SIZE (1024 * 1024)
+#ifdef Q_OS_WIN
+#define SAVE_NEWLINE "\r\n"
+#else
+#define SAVE_NEWLINE "\n"
+#endif
 #define TAB_STOP_WIDTH 4
 #define TABS_TO_SPACES true
 
 SourceCodeEdit::SourceCodeEdit(QWidget *parent)
-    : QPlainTextEdit(parent)
+    : QPlainTextEdit(parent), m_Highlighter(nullptr), m_Loading(false)
 {
     m_Sidebar = new SourceCodeSidebarWidget(this);
     QSettings settings;
@@ -40,6 +48,7 @@ SourceCodeEdit::SourceCodeEdit(QWidget *parent)
     setCursorWidth(2);
     setFrameStyle(QFrame::NoFrame);
     setFont(font);
+    m_Sidebar->updateGlyphs();
     setTabChangesFocus(false);
     setWordWrapMode(QTextOption::NoWrap);
     connect(this, &QPlainTextEdit::cursorPositionChanged, this, &SourceCodeEdit::handleCursorPositionChanged);
@@ -60,6 +69,17 @@ SourceCodeEdit::SourceCodeEdit(QWidget *parent)
     });
 }
 
+void SourceCodeEdit::changeEvent(QEvent *event)
+{
+    QPlainTextEdit::changeEvent(event);
+    if ((event->type() == QEvent::FontChange) || (event->type() == QEvent::PaletteChange)) {
+        // 缩放或换主题后重新绘制行号栏的数字
+        m_Sidebar->updateGlyphs();
+        m_Sidebar->update();
+        handleBlockCountChanged(0);
+    }
+}
+
 QRectF SourceCodeEdit::blockBoundingGeometryProxy(const QTextBlock &block)
 {
     return blockBoundingGeometry(block);
@@ -94,7 +114,11 @@ void SourceCodeEdit::gotoLine(const int no)
 void SourceCodeEdit::handleBlockCountChanged(const int count)
 {
     Q_UNUSED(count)
-    setViewportMargins(m_Sidebar->sizeHint().width(), 0, 0, 0);
+    // 每次文本变化都会调用，只有行号位数变化时才重新布局
+    const int width = m_Sidebar->sizeHint().width();
+    if (width != viewportMargins().left()) {
+        setViewportMargins(width, 0, 0, 0);
+    }
 }
 
 void SourceCodeEdit::handleCursorPositionChanged()
@@ -122,6 +146,17 @@ void SourceCodeEdit::handleUpdateRequest(const QRect &rect, const int column)
     if (rect.contains(viewport()->rect())) {
         handleBlockCountChanged(0);
     }
+    if (m_Highlighter && m_Highlighter->isDeferred()) {
+        // 大文件先高亮可见的块，其余的在空闲时处理
+        const QTextBlock first = firstVisibleBlock();
+        const QPointF offset = contentOffset();
+        const int bottom = viewport()->rect().bottom();
+        QTextBlock last = first;
+        for (QTextBlock block = first; block.isValid() && (blockBoundingGeometry(block).translated(offset).top() <= bottom); block = block.next()) {
+            last = block;
+        }
+        m_Highlighter->highlightVisible(first, last);
+    }
 }
 
 void SourceCodeEdit::handleTextChanged()
@@ -220,6 +255,11 @@ QString SourceCodeEdit::indentText(QString text, int count) const
     return text;
 }
 
+bool SourceCodeEdit::isLoading() const
+{
+    return m_Loading;
+}
+
 void SourceCodeEdit::keyPressEvent(QKeyEvent *event)
 {
     QTextCursor cursor = textCursor();
@@ -374,20 +414,34 @@ void SourceCodeEdit::open(const QString &path)
 {
     QFile file(path);
     if (file.open(QFile::ReadOnly | QFile::Text)) {
-        auto content = QString::fromUtf8(file.readAll());
-        setPlainText(content);
-        QFileInfo info(path);
-        QString extension = info.suffix().toLower();
-        QSettings settings;
-        const bool dark = settings.value("dark_theme", false).toBool();
-        new ThemedSyntaxHighlighter(
-                    ThemedSyntaxHighlighter::theme(dark ? "dark" : "light"),
-                    ThemedSyntaxHighlighter::definitions(extension),
-                    document());
+        open(path, QString::fromUtf8(file.readAll()));
     }
     m_FilePath = path;
 }
 
+void SourceCodeEdit::open(const QString &path, const QString &content, const QByteArray &hash)
+{
+    m_FilePath = path;
+    m_Loading = false;
+    m_PendingHash.clear();
+    // 摘要由读取文件的后台线程计算，编辑后又改回原样时保存会跳过写入
+    m_SavedHash = hash;
+    setPlaceholderText(QString());
+    setReadOnly(false);
+    setPlainText(content);
+    QFileInfo info(path);
+    QString extension = info.suffix().toLower();
+    QSettings settings;
+    const bool dark = settings.value("dark_theme", false).toBool();
+    delete m_Highlighter;
+    m_Highlighter = new ThemedSyntaxHighlighter(
+                ThemedSyntaxHighlighter::theme(dark ? "dark" : "light"),
+                ThemedSyntaxHighlighter::definitions(extension),
+                document());
+    m_Highlighter->setDeferred(document()->blockCount() > HIGHLIGHT_DEFERRED_BLOCKS);
+    emit loaded();
+}
+
 void SourceCodeEdit::paintEvent(QPaintEvent *event)
 {
     QPainter line(viewport());
@@ -413,21 +467,71 @@ void SourceCodeEdit::resizeEvent(QResizeEvent *event)
 
 bool SourceCodeEdit::save()
 {
-    QFile file(m_FilePath);
-    if (file.open(QFile::WriteOnly | QFile::Text)) {
-        QTextStream out(&file);
-#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
-        out.setCodec("UTF-8");
-#else
-        out.setEncoding(QStringConverter::Utf8);
-#endif
-        out.setGenerateByteOrderMark(false);
-        out << toPlainText();
-        out.flush();
-        file.close();
-        return true;
+    QList<QByteArray> chunks;
+    QByteArray hash;
+    if (!snapshot(chunks, hash)) {
+        // 内容还没有读完时保存会把文件清空；没有修改时不需要写入
+        return !m_Loading;
     }
-    return false;
+    const bool success = FileSaveWorker::write(m_FilePath, chunks);
+    setSaved(hash, success);
+    return success;
+}
+
+void SourceCodeEdit::setLoading(const QString &path)
+{
+    // 内容由后台线程读取，完成前只显示占位提示
+    m_FilePath = path;
+    m_Loading = true;
+    setPlaceholderText(tr("正在加载..."));
+    setReadOnly(true);
+}
+
+void SourceCodeEdit::setSaved(const QByteArray &hash, const bool success)
+{
+    if (success) {
+        m_SavedHash = hash;
+    } else if (hash == m_PendingHash) {
+        // 写入失败，恢复修改标记，下次保存时重新写入
+        m_PendingHash = m_SavedHash;
+        document()->setModified(true);
+    }
+}
+
+bool SourceCodeEdit::snapshot(QList<QByteArray> &chunks, QByteArray &hash)
+{
+    if (m_Loading || !document()->isModified()) {
+        return false;
+    }
+    // 逐块编码成 UTF-8 分块并计算摘要；不生成整个文档的 QString，但分块合起来仍是整个文档，在界面线程中生成
+    QCryptographicHash digest(QCryptographicHash::Md5);
+    QByteArray chunk;
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        if (block != document()->begin()) {
+            chunk.append(SAVE_NEWLINE);
+        }
+        // 与 toPlainText() 一致：行内换行符按换行保存，不换行空格按普通空格保存
+        QString text = block.text();
+        text.replace(QChar::LineSeparator, QLatin1String(SAVE_NEWLINE));
+        text.replace(QChar::Nbsp, QLatin1Char(' '));
+        chunk.append(text.toUtf8());
+        if (chunk.size() >= SAVE_CHUNK_SIZE) {
+            digest.addData(chunk);
+            chunks.append(chunk);
+            chunk.clear();
+        }
+    }
+    digest.addData(chunk);
+    chunks.append(chunk);
+    hash = digest.result();
+    // 交给保存线程时就清除修改标记，保存完成前关闭或退出不会再提示；写入失败时由 setSaved() 恢复
+    document()->setModified(false);
+    if (hash == (m_PendingHash.isEmpty() ? m_SavedHash : m_PendingHash)) {
+        // 内容与上次保存（或正在保存）的相同，跳过写入
+        return false;
+    }
+    m_PendingHash = hash;
+    return true;
 }
 
 void SourceCodeEdit::transformText(const bool upper)
@@ -466,7 +570,7 @@ void SourceCodeEdit::wheelEvent(QWheelEvent *event)
 }
 
 SourceCodeSidebarWidget::SourceCodeSidebarWidget(SourceCodeEdit *edit)
-    : QWidget(edit), m_Edit(edit)
+    : QWidget(edit), m_Advance(0), m_Edit(edit), m_Height(0), m_Ratio(0), m_Space(0)
 {
 }
 
@@ -483,37 +587,42 @@ void SourceCodeSidebarWidget::leaveEvent(QEvent *e)
 
 void SourceCodeSidebarWidget::paintEvent(QPaintEvent *e)
 {
+    if (!qFuzzyCompare(devicePixelRatioF(), m_Ratio)) {
+        updateGlyphs();
+    }
     QPainter painter(this);
     QTextBlock block = m_Edit->firstVisibleBlockProxy();
     int i = block.blockNumber();
     int top = static_cast<int>(m_Edit->blockBoundingGeometryProxy(block).translated(m_Edit->contentOffsetProxy()).top());
     int bottom = top + static_cast<int>(m_Edit->blockBoundingRectProxy(block).height());
-    QRect full = e->rect();
+    const int current = m_Edit->textCursor().blockNumber();
+    const int right = width() - m_Space;
+    const QRect full = e->rect();
     painter.fillRect(full, palette().color(QPalette::Base));
     while (block.isValid() && (top <= full.bottom())) {
         if (block.isVisible() && (bottom >= full.top())) {
-            QRect box(0, top, width(), m_Edit->fontMetrics().height());
-            QFont font = painter.font();
-            font.setFamily(m_Edit->font().family());
-            font.setPointSize(m_Edit->font().pointSize());
-            if (m_Edit->textCursor().blockNumber() == i) {
-                painter.fillRect(box, palette().color(QPalette::Highlight));
-                painter.setPen(palette().color(QPalette::HighlightedText));
-                font.setWeight(QFont::Bold);
-            } else {
-                font.setWeight(QFont::Normal);
-                painter.setPen(palette().color(QPalette::Text));
+            const bool highlight = (i == current);
+            if (highlight) {
+                painter.fillRect(0, top, width(), m_Height, palette().color(QPalette::Highlight));
             }
-            painter.setFont(font);
-            painter.drawText(box.left(), box.top(), box.width(), box.height(), Qt::AlignRight, QString::number(i + 1).append(' '));
-            painter.setPen(palette().color(QPalette::Highlight));
-            painter.drawLine(full.topRight(), full.bottomRight());
+            // 从右往左逐位贴上预先绘制的数字，不为每一行创建字符串和字体
+            const QPixmap &glyphs = m_Glyphs[highlight ? 1 : 0];
+            int x = right;
+            int number = i + 1;
+            do {
+                x -= m_Advance;
+                const int digit = number % 10;
+                painter.drawPixmap(QPointF(x, top), glyphs, QRectF(digit * m_Advance * m_Ratio, 0, m_Advance * m_Ratio, m_Height * m_Ratio));
+                number /= 10;
+            } while (number > 0);
         }
         block = block.next();
         top = bottom;
         bottom = (top + static_cast<int>(m_Edit->blockBoundingRectProxy(block).height()));
         ++i;
     }
+    painter.setPen(palette().color(QPalette::Highlight));
+    painter.drawLine(full.topRight(), full.bottomRight());
 }
 
 void SourceCodeSidebarWidget::mouseEvent(QMouseEvent *e)
@@ -550,7 +659,34 @@ QSize SourceCodeSidebarWidget::sizeHint() const
     }
     digits++;
     digits++;
-    return QSize((3 + (m_Edit->fontMetrics().horizontalAdvance('8') * digits)), 0);
+    return QSize((3 + (m_Advance * digits)), 0);
+}
+
+void SourceCodeSidebarWidget::updateGlyphs()
+{
+    // 数字 0-9 按普通和当前行两种样式各绘制成一条，绘制行号时按位截取
+    QFont font = m_Edit->font();
+    QFont bold = font;
+    bold.setWeight(QFont::Bold);
+    const QFontMetrics metrics(font);
+    const QFontMetrics boldMetrics(bold);
+    m_Advance = qMax(metrics.horizontalAdvance('8'), boldMetrics.horizontalAdvance('8'));
+    m_Height = metrics.height();
+    m_Ratio = devicePixelRatioF();
+    m_Space = metrics.horizontalAdvance(' ');
+    const QColor colors[2] = { palette().color(QPalette::Text), palette().color(QPalette::HighlightedText) };
+    for (int style = 0; style < 2; ++style) {
+        QPixmap glyphs(qCeil(m_Advance * 10 * m_Ratio), qCeil(m_Height * m_Ratio));
+        glyphs.setDevicePixelRatio(m_Ratio);
+        glyphs.fill(Qt::transparent);
+        QPainter painter(&glyphs);
+        painter.setFont(style ? bold : font);
+        painter.setPen(colors[style]);
+        for (int digit = 0; digit < 10; ++digit) {
+            painter.drawText(QRect(digit * m_Advance, 0, m_Advance, m_Height), Qt::AlignRight, QString(QChar('0' + digit)));
+        }
+        m_Glyphs[style] = glyphs;
+    }
 }
 
 void SourceCodeSidebarWidget::wheelEvent(QWheelEvent *e)
@@ -1,9 +1,11 @@
 #ifndef SOURCECODEEDIT_H
 #define SOURCECODEEDIT_H
 
+#include <QPixmap>
 #include <QPlainTextEdit>
 
 class SourceCodeSidebarWidget;
+class ThemedSyntaxHighlighter;
 
 class SourceCodeEdit : public QPlainTextEdit
 {
@@ -16,16 +18,26 @@ public:
     QString filePath();
     QTextBlock firstVisibleBlockProxy();
     void gotoLine(const int no);
+    bool isLoading() const;
     void moveCursor(const bool end);
     void open(const QString &path);
+    void open(const QString &path, const QString &content, const QByteArray &hash = QByteArray());
     bool save();
+    void setLoading(const QString &path);
+    void setSaved(const QByteArray &hash, const bool success);
+    bool snapshot(QList<QByteArray> &chunks, QByteArray &hash);
 protected:
+    void changeEvent(QEvent *event);
     void keyPressEvent(QKeyEvent *event);
     void paintEvent(QPaintEvent *event);
     void resizeEvent(QResizeEvent *event);
     void wheelEvent(QWheelEvent *event);
 private:
     QString m_FilePath;
+    ThemedSyntaxHighlighter *m_Highlighter;
+    bool m_Loading;
+    QByteArray m_PendingHash;
+    QByteArray m_SavedHash;
     SourceCodeSidebarWidget *m_Sidebar;
     int indentSize(const QString &text);
     bool indentText(const bool forward);
@@ -37,6 +49,8 @@ private slots:
     void handleCursorPositionChanged();
     void handleUpdateRequest(const QRect &rect, const int column);
     void handleTextChanged();
+signals:
+    void loaded();
 };
 
 class SourceCodeSidebarWidget : public QWidget
@@ -45,6 +59,7 @@ class SourceCodeSidebarWidget : public QWidget
 public:
     explicit SourceCodeSidebarWidget(SourceCodeEdit *edit);
     QSize sizeHint() const;
+    void updateGlyphs();
 protected:
     void leaveEvent(QEvent *event);
     void mouseEvent(QMouseEvent *event);
@@ -54,7 +69,12 @@ protected:
     void paintEvent(QPaintEvent *event);
     void wheelEvent(QWheelEvent *event);
 private:
+    int m_Advance;
     SourceCodeEdit *m_Edit;
+    QPixmap m_Glyphs[2];
+    int m_Height;
+    qreal m_Ratio;
+    int m_Space;
 };
 
 #endif // SOURCECODEEDIT_H
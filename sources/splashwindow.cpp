@@ -1,15 +1,10 @@
 #include <QDebug>
 #include <QPainter>
 #include <QPixmap>
-#include <QThread>
 #include <QTimer>
 #include <QVBoxLayout>
 #include "mainwindow.h"
-#include "processutils.h"
 #include "splashwindow.h"
-#include "tooldownloaddialog.h"
-#include "tooldownloadworker.h"
-#include "versionresolveworker.h"
 
 #define SPLASH_WIDTH 512
 #define SPLASH_HEIGHT 320
@@ -20,16 +15,8 @@ SplashWindow::SplashWindow(const QString &apkFilePath)
     setCentralWidget(buildCentralWidget());
     setFixedSize(SPLASH_WIDTH, SPLASH_HEIGHT);
     setStyleSheet("QLabel { background-color: transparent; color: white; padding: 0 }");
-    auto thread = new QThread;
-    auto worker = new VersionResolveWorker;
-    worker->moveToThread(thread);
-    connect(worker, &VersionResolveWorker::versionResolved, this, &SplashWindow::handleVersionResolved);
-    connect(worker, &VersionResolveWorker::finished, this, &SplashWindow::handleVersionResolveFinished);
-    connect(thread, &QThread::started, worker, &VersionResolveWorker::resolve);
-    connect(worker, &VersionResolveWorker::finished, thread, &QThread::quit);
-    connect(worker, &VersionResolveWorker::finished, worker, &QObject::deleteLater);
-    connect(thread, &QThread::finished, thread, &QObject::deleteLater);
-    thread->start();
+    // 版本检查由 MainWindow 在后台进行，不再等待其完成
+    QTimer::singleShot(0, this, &SplashWindow::showMainWindow);
 }
 
 QWidget *SplashWindow::buildCentralWidget()
@@ -68,14 +55,9 @@ QWidget *SplashWindow::buildCentralWidget()
     return widget;
 }
 
-void SplashWindow::handleVersionResolved(const QString &binary, const QString &version)
+void SplashWindow::showMainWindow()
 {
-    m_Versions.insert(binary, version);
-}
-
-void SplashWindow::handleVersionResolveFinished()
-{
-    auto mainWindow = new MainWindow(m_Versions);
+    auto mainWindow = new MainWindow();
     mainWindow->show();
     // 如果通过命令行传入了 APK 文件路径，自动打开反编译对话框
     if (!m_ApkFilePath.isEmpty()) {
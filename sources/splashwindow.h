@@ -3,7 +3,6 @@
 
 #include <QLabel>
 #include <QMainWindow>
-#include <QMap>
 
 class SplashWindow : public QMainWindow
 {
@@ -12,12 +11,10 @@ public:
     explicit SplashWindow(const QString &apkFilePath = QString());
     ~SplashWindow();
 private:
-    QMap<QString, QString> m_Versions;
     QString m_ApkFilePath;
     QWidget *buildCentralWidget();
 private slots:
-    void handleVersionResolved(const QString &binary, const QString &version);
-    void handleVersionResolveFinished();
+    void showMainWindow();
 };
 
 #endif // SPLASHWINDOW_H
@@ -0,0 +1,96 @@
+#include <QDir>
+#include <QIcon>
+#include <QSignalBlocker>
+#include <QVBoxLayout>
+#include "mainwindow.h"
+#include "symbolsearchdialog.h"
+
+#define SYMBOL_SEARCH_MAX_RESULTS 1000
+#define SYMBOL_SEARCH_MIN_LENGTH 2
+
+SymbolSearchDialog::SymbolSearchDialog(const SmaliIndex &index, const Mode mode, MainWindow *parent)
+    : QDialog(parent), m_Index(index), m_MainWindow(parent), m_Mode(mode)
+{
+    setAttribute(Qt::WA_DeleteOnClose);
+    setWindowTitle((mode == Definitions) ? tr("转到符号") : tr("查找用法"));
+    setMinimumSize(512, 384);
+#ifdef Q_OS_WIN
+    setWindowIcon(QIcon(":/icons/fugue/binocular.png"));
+#endif
+    buildUI();
+    connect(m_EditQuery, &QLineEdit::textChanged, this, &SymbolSearchDialog::handleQueryChanged);
+    connect(m_ResultsList, &QListWidget::itemActivated, this, &SymbolSearchDialog::handleResultActivated);
+}
+
+void SymbolSearchDialog::buildUI()
+{
+    auto layout = new QVBoxLayout(this);
+    layout->setContentsMargins(8, 8, 8, 8);
+    layout->setSpacing(8);
+    m_EditQuery = new QLineEdit(this);
+    m_EditQuery->setClearButtonEnabled(true);
+    m_EditQuery->setPlaceholderText((m_Mode == Definitions)
+                                    ? tr("输入类、方法或字段名称...")
+                                    : tr("输入完整的类或成员签名，例如 Lcom/example/Foo;->bar()V"));
+    layout->addWidget(m_EditQuery);
+    m_ResultsList = new QListWidget(this);
+    m_ResultsList->setUniformItemSizes(true);
+    layout->addWidget(m_ResultsList, 1);
+    m_LabelStatus = new QLabel(this);
+    layout->addWidget(m_LabelStatus);
+    if (m_Index.isEmpty()) {
+        m_LabelStatus->setText(tr("符号索引尚未建立完成。"));
+    }
+}
+
+void SymbolSearchDialog::handleQueryChanged(const QString &text)
+{
+    // 结果直接来自内存中的索引，每次输入都重新查询
+    m_ResultsList->clear();
+    const QString query = text.trimmed();
+    if (query.length() < SYMBOL_SEARCH_MIN_LENGTH) {
+        m_LabelStatus->clear();
+        return;
+    }
+    showResults((m_Mode == Definitions)
+                ? m_Index.definitions(query, SYMBOL_SEARCH_MAX_RESULTS)
+                : m_Index.usages(query, SYMBOL_SEARCH_MAX_RESULTS));
+}
+
+void SymbolSearchDialog::handleResultActivated(QListWidgetItem *item)
+{
+    m_MainWindow->openFileAt(item->data(Qt::UserRole).toString(), item->data(Qt::UserRole + 1).toInt());
+}
+
+void SymbolSearchDialog::setQuery(const QString &query)
+{
+    m_EditQuery->setText(query);
+    m_EditQuery->selectAll();
+}
+
+void SymbolSearchDialog::setResults(const QString &query, const QList<SmaliSymbol> &symbols)
+{
+    // 结果由调用方查好，例如资源的引用，查询框只用于显示
+    QSignalBlocker blocker(m_EditQuery);
+    m_EditQuery->setReadOnly(true);
+    m_EditQuery->setText(query);
+    showResults(symbols);
+}
+
+void SymbolSearchDialog::showResults(const QList<SmaliSymbol> &symbols)
+{
+    m_ResultsList->clear();
+    const QDir root(m_Index.folder());
+    foreach (const SmaliSymbol &symbol, symbols) {
+        const QString location = QString("%1:%2").arg(QDir::toNativeSeparators(root.relativeFilePath(symbol.path))).arg(symbol.line);
+        auto item = new QListWidgetItem((m_Mode == Definitions) ? QString("%1    %2").arg(symbol.name, location) : location, m_ResultsList);
+        item->setData(Qt::UserRole, symbol.path);
+        item->setData(Qt::UserRole + 1, symbol.line);
+        item->setToolTip(symbol.name);
+    }
+    if (symbols.size() >= SYMBOL_SEARCH_MAX_RESULTS) {
+        m_LabelStatus->setText(tr("仅显示前 %1 个结果。").arg(SYMBOL_SEARCH_MAX_RESULTS));
+    } else {
+        m_LabelStatus->setText(tr("找到 %1 个结果。").arg(symbols.size()));
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef SYMBOLSEARCHDIALOG_H
+#define SYMBOLSEARCHDIALOG_H
+
+#include <QDialog>
+#include <QLabel>
+#include <QLineEdit>
+#include <QListWidget>
+#include "smaliindex.h"
+
+class MainWindow;
+
+class SymbolSearchDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        Definitions = 0,
+        Usages
+    };
+    explicit SymbolSearchDialog(const SmaliIndex &index, const Mode mode, MainWindow *parent = nullptr);
+    void setQuery(const QString &query);
+    void setResults(const QString &query, const QList<SmaliSymbol> &symbols);
+private:
+    QLineEdit *m_EditQuery;
+    SmaliIndex m_Index;
+    QLabel *m_LabelStatus;
+    MainWindow *m_MainWindow;
+    Mode m_Mode;
+    QListWidget *m_ResultsList;
+    void buildUI();
+    void showResults(const QList<SmaliSymbol> &symbols);
+private slots:
+    void handleQueryChanged(const QString &text);
+    void handleResultActivated(QListWidgetItem *item);
+};
+
+#endif // SYMBOLSEARCHDIALOG_H
@@ -0,0 +1,361 @@
+#include <algorithm>
+#include <cstring>
+#include <QIODevice>
+#include "textpiecetable.h"
+
+#define LINE_INDEX_STRIDE 64
+#define SAVE_CHUNK_SIZE (1024 * 1024)
+#define UNDO_LIMIT 1000
+
+TextPieceTable::TextPieceTable()
+    : m_CleanDepth(0), m_Data(nullptr), m_Lines(0), m_MappedSize(0), m_OriginalLines(0), m_Size(0)
+{
+}
+
+qint64 TextPieceTable::breaksBefore(const qint64 offset) const
+{
+    // 先跳到之前最近的检查点，再数剩余不超过一个间隔的换行符
+    const qint64 i = std::lower_bound(m_Checkpoints.cbegin(), m_Checkpoints.cend(), offset) - m_Checkpoints.cbegin();
+    const char *p = m_Data + (i ? (m_Checkpoints.at(i - 1) + 1) : 0);
+    return (i * LINE_INDEX_STRIDE) + std::count(p, m_Data + offset, '\n');
+}
+
+bool TextPieceTable::canRedo() const
+{
+    return !m_Redo.isEmpty();
+}
+
+bool TextPieceTable::canUndo() const
+{
+    return !m_Undo.isEmpty();
+}
+
+void TextPieceTable::changed()
+{
+    // 保存时的状态还在重做栈中时，新的修改会丢弃它，之后不可能再回到未修改的状态
+    if (m_CleanDepth > m_Undo.size()) {
+        m_CleanDepth = -1;
+    }
+    // 每次修改前保存片段表，撤销时直接换回，片段本身引用的字节从不改变
+    m_Undo.append(m_Pieces);
+    if (m_Undo.size() > UNDO_LIMIT) {
+        m_Undo.removeFirst();
+        if (m_CleanDepth >= 0) {
+            m_CleanDepth--;
+        }
+    }
+    m_Redo.clear();
+}
+
+qint64 TextPieceTable::countBreaks(const Piece &piece) const
+{
+    if (piece.added) {
+        const char *data = pieceData(piece);
+        return std::count(data, data + piece.length, '\n');
+    }
+    return breaksBefore(piece.start + piece.length) - breaksBefore(piece.start);
+}
+
+void TextPieceTable::indexLines(const char *data, const qint64 size, TextLineIndex &index)
+{
+    // 只记录每隔 LINE_INDEX_STRIDE 个换行符的位置，数百 MB 的文件索引也只占很少内存；可以分块连续调用
+    const char *p = data;
+    const char *end = data + size;
+    while ((p < end) && (p = static_cast<const char *>(memchr(p, '\n', end - p)))) {
+        if ((++index.lines % LINE_INDEX_STRIDE) == 0) {
+            index.checkpoints.append(index.size + (p - data));
+        }
+        p++;
+    }
+    index.size += size;
+}
+
+void TextPieceTable::insert(const qint64 offset, const QByteArray &data)
+{
+    if (data.isEmpty() || (offset < 0) || (offset > m_Size)) {
+        return;
+    }
+    changed();
+    const int i = split(offset);
+    const qint64 lines = std::count(data.cbegin(), data.cend(), '\n');
+    if ((i > 0) && m_Pieces.at(i - 1).added && ((m_Pieces.at(i - 1).start + m_Pieces.at(i - 1).length) == m_Added.size())) {
+        // 连续输入时扩展上一个片段，避免片段数随按键增长
+        m_Pieces[i - 1].length += data.size();
+        m_Pieces[i - 1].lines += lines;
+    } else {
+        m_Pieces.insert(i, Piece{true, lines, data.size(), m_Added.size()});
+    }
+    m_Added.append(data);
+    m_Size += data.size();
+    m_Lines += lines;
+}
+
+bool TextPieceTable::isModified() const
+{
+    // 撤销栈的深度与保存时相同说明内容没有变化
+    return m_Undo.size() != m_CleanDepth;
+}
+
+QByteArray TextPieceTable::line(const qint64 number) const
+{
+    const qint64 start = lineOffset(number);
+    const qint64 end = (number < m_Lines) ? (lineOffset(number + 1) - 1) : m_Size;
+    QByteArray bytes = read(start, end - start);
+    if (bytes.endsWith('\r')) {
+        bytes.chop(1);
+    }
+    return bytes;
+}
+
+qint64 TextPieceTable::lineCount() const
+{
+    return m_Lines + 1;
+}
+
+qint64 TextPieceTable::lineOffset(const qint64 number) const
+{
+    if (number <= 0) {
+        return 0;
+    }
+    if (number > m_Lines) {
+        return m_Size;
+    }
+    // 行首位于第 number 个换行符之后
+    qint64 position = 0;
+    qint64 seen = 0;
+    foreach (const Piece &piece, m_Pieces) {
+        if ((seen + piece.lines) >= number) {
+            return position + nthBreak(piece, number - seen - 1) + 1;
+        }
+        seen += piece.lines;
+        position += piece.length;
+    }
+    return m_Size;
+}
+
+qint64 TextPieceTable::nthBreak(const Piece &piece, const qint64 n) const
+{
+    if (!piece.added) {
+        return nthOriginalBreak(breaksBefore(piece.start) + n) - piece.start;
+    }
+    const char *data = pieceData(piece);
+    const char *p = data;
+    for (qint64 i = 0; ; ++i) {
+        p = static_cast<const char *>(memchr(p, '\n', (data + piece.length) - p));
+        if (i == n) {
+            return p - data;
+        }
+        p++;
+    }
+}
+
+qint64 TextPieceTable::nthOriginalBreak(const qint64 n) const
+{
+    const qint64 i = n / LINE_INDEX_STRIDE;
+    const char *end = m_Data + m_MappedSize;
+    const char *p = m_Data + (i ? (m_Checkpoints.at(i - 1) + 1) : 0);
+    for (qint64 r = n % LINE_INDEX_STRIDE; ; --r) {
+        p = static_cast<const char *>(memchr(p, '\n', end - p));
+        if (r == 0) {
+            return p - m_Data;
+        }
+        p++;
+    }
+}
+
+bool TextPieceTable::open(const QString &path, const TextLineIndex &index)
+{
+    m_File.close();
+    m_Added.clear();
+    m_Checkpoints.clear();
+    m_CleanDepth = 0;
+    m_Data = nullptr;
+    m_Lines = m_MappedSize = m_OriginalLines = m_Size = 0;
+    m_Pieces.clear();
+    m_Redo.clear();
+    m_Undo.clear();
+    m_File.setFileName(path);
+    if (!m_File.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // 文件在后台扫描之后又被修改时索引不再可用
+    m_MappedSize = m_File.size();
+    if ((m_MappedSize != index.size) || (index.checkpoints.size() != (index.lines / LINE_INDEX_STRIDE))) {
+        m_File.close();
+        m_MappedSize = 0;
+        return false;
+    }
+    // 原文件只做映射，不读入内存；修改只追加到片段表中
+    if (m_MappedSize > 0) {
+        m_Data = reinterpret_cast<const char *>(m_File.map(0, m_MappedSize));
+        if (!m_Data) {
+            m_File.close();
+            m_MappedSize = 0;
+            return false;
+        }
+        m_Checkpoints = index.checkpoints;
+        m_OriginalLines = index.lines;
+        m_Pieces.append(Piece{false, m_OriginalLines, m_MappedSize, 0});
+    }
+    m_Lines = m_OriginalLines;
+    m_Size = m_MappedSize;
+    return true;
+}
+
+const char *TextPieceTable::pieceData(const Piece &piece) const
+{
+    return (piece.added ? m_Added.constData() : m_Data) + piece.start;
+}
+
+QByteArray TextPieceTable::read(qint64 offset, qint64 length) const
+{
+    QByteArray bytes;
+    offset = qBound<qint64>(0, offset, m_Size);
+    length = qBound<qint64>(0, length, m_Size - offset);
+    bytes.reserve(length);
+    qint64 position = 0;
+    foreach (const Piece &piece, m_Pieces) {
+        if (length <= 0) {
+            break;
+        }
+        if ((offset < position + piece.length) && (offset >= position)) {
+            const qint64 skip = offset - position;
+            const qint64 count = qMin(length, piece.length - skip);
+            bytes.append(pieceData(piece) + skip, count);
+            offset += count;
+            length -= count;
+        }
+        position += piece.length;
+    }
+    return bytes;
+}
+
+bool TextPieceTable::redo()
+{
+    if (m_Redo.isEmpty()) {
+        return false;
+    }
+    m_Undo.append(m_Pieces);
+    restore(m_Redo.takeLast());
+    return true;
+}
+
+void TextPieceTable::release()
+{
+    // 替换原文件前释放映射，Windows 上无法替换仍被映射的文件；之后只能调用 remap() 或 open()
+    m_File.close();
+    m_Data = nullptr;
+}
+
+bool TextPieceTable::remap()
+{
+    // 原文件没有被替换，重新映射后片段仍然有效
+    if (!m_File.open(QIODevice::ReadOnly) || (m_File.size() != m_MappedSize)) {
+        // 原文件已经变化，引用它的片段都不再可用
+        m_File.close();
+        m_Pieces.clear();
+        m_Redo.clear();
+        m_Undo.clear();
+        m_Lines = m_MappedSize = m_Size = 0;
+        return false;
+    }
+    if (m_MappedSize > 0) {
+        m_Data = reinterpret_cast<const char *>(m_File.map(0, m_MappedSize));
+    }
+    return m_Data || (m_MappedSize == 0);
+}
+
+void TextPieceTable::remove(const qint64 offset, qint64 length)
+{
+    length = qMin(length, m_Size - offset);
+    if ((offset < 0) || (length <= 0)) {
+        return;
+    }
+    changed();
+    const int first = split(offset);
+    const int last = split(offset + length);
+    for (int i = first; i < last; ++i) {
+        m_Lines -= m_Pieces.at(i).lines;
+    }
+    m_Pieces.remove(first, last - first);
+    m_Size -= length;
+}
+
+void TextPieceTable::restore(const QVector<Piece> &pieces)
+{
+    m_Pieces = pieces;
+    m_Lines = m_Size = 0;
+    foreach (const Piece &piece, m_Pieces) {
+        m_Lines += piece.lines;
+        m_Size += piece.length;
+    }
+}
+
+qint64 TextPieceTable::size() const
+{
+    return m_Size;
+}
+
+TextPieceTable::Snapshot TextPieceTable::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.added = m_Added;
+    snapshot.data = m_Data;
+    snapshot.pieces = m_Pieces;
+    return snapshot;
+}
+
+int TextPieceTable::split(const qint64 offset)
+{
+    qint64 position = 0;
+    for (int i = 0; i < m_Pieces.size(); ++i) {
+        const Piece piece = m_Pieces.at(i);
+        if (offset == position) {
+            return i;
+        }
+        if (offset < (position + piece.length)) {
+            Piece head = piece;
+            head.length = offset - position;
+            head.lines = countBreaks(head);
+            Piece tail = piece;
+            tail.start += head.length;
+            tail.length -= head.length;
+            tail.lines = piece.lines - head.lines;
+            m_Pieces[i] = head;
+            m_Pieces.insert(i + 1, tail);
+            return i + 1;
+        }
+        position += piece.length;
+    }
+    return m_Pieces.size();
+}
+
+bool TextPieceTable::undo()
+{
+    if (m_Undo.isEmpty()) {
+        return false;
+    }
+    m_Redo.append(m_Pieces);
+    restore(m_Undo.takeLast());
+    return true;
+}
+
+bool TextPieceTable::Snapshot::write(QIODevice *device, TextLineIndex &index, const std::function<bool()> &cancelled) const
+{
+    // 按片段分块写出，不在内存中拼出整个文件；同时为新文件建立换行符索引，保存后不需要再扫描一遍
+    index = TextLineIndex();
+    foreach (const Piece &piece, pieces) {
+        const char *bytes = (piece.added ? added.constData() : data) + piece.start;
+        for (qint64 written = 0; written < piece.length; written += SAVE_CHUNK_SIZE) {
+            if (cancelled()) {
+                return false;
+            }
+            const qint64 chunk = qMin<qint64>(SAVE_CHUNK_SIZE, piece.length - written);
+            if (device->write(bytes + written, chunk) != chunk) {
+                return false;
+            }
+            indexLines(bytes + written, chunk, index);
+        }
+    }
+    return true;
+}
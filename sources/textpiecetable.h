@@ -0,0 +1,82 @@
+#ifndef TEXTPIECETABLE_H
+#define TEXTPIECETABLE_H
+
+#include <functional>
+#include <QByteArray>
+#include <QFile>
+#include <QMetaType>
+#include <QVector>
+
+class QIODevice;
+
+// 原文件的换行符检查点，由后台线程扫描后交给片段表
+struct TextLineIndex
+{
+    QVector<qint64> checkpoints;
+    qint64 lines = 0;
+    qint64 size = 0;
+};
+
+class TextPieceTable
+{
+public:
+    // 片段引用原文件映射或追加缓冲区中的一段字节，lines 为其中换行符的个数
+    struct Piece
+    {
+        bool added;
+        qint64 lines;
+        qint64 length;
+        qint64 start;
+    };
+    // 交给保存线程的片段表副本，追加缓冲区隐式共享，原文件映射在写完之前由编辑器保持有效
+    struct Snapshot
+    {
+        QByteArray added;
+        const char *data = nullptr;
+        QVector<Piece> pieces;
+        bool write(QIODevice *device, TextLineIndex &index, const std::function<bool()> &cancelled) const;
+    };
+    TextPieceTable();
+    bool canRedo() const;
+    bool canUndo() const;
+    static void indexLines(const char *data, const qint64 size, TextLineIndex &index);
+    void insert(const qint64 offset, const QByteArray &data);
+    bool isModified() const;
+    QByteArray line(const qint64 number) const;
+    qint64 lineCount() const;
+    qint64 lineOffset(const qint64 number) const;
+    bool open(const QString &path, const TextLineIndex &index);
+    QByteArray read(qint64 offset, qint64 length) const;
+    bool redo();
+    void release();
+    bool remap();
+    void remove(const qint64 offset, qint64 length);
+    qint64 size() const;
+    Snapshot snapshot() const;
+    bool undo();
+private:
+    QByteArray m_Added;
+    QVector<qint64> m_Checkpoints;
+    int m_CleanDepth;
+    const char *m_Data;
+    QFile m_File;
+    qint64 m_Lines;
+    qint64 m_MappedSize;
+    qint64 m_OriginalLines;
+    QVector<Piece> m_Pieces;
+    QVector<QVector<Piece>> m_Redo;
+    qint64 m_Size;
+    QVector<QVector<Piece>> m_Undo;
+    qint64 breaksBefore(const qint64 offset) const;
+    void changed();
+    qint64 countBreaks(const Piece &piece) const;
+    qint64 nthBreak(const Piece &piece, const qint64 n) const;
+    qint64 nthOriginalBreak(const qint64 n) const;
+    const char *pieceData(const Piece &piece) const;
+    void restore(const QVector<Piece> &pieces);
+    int split(const qint64 offset);
+};
+
+Q_DECLARE_METATYPE(TextLineIndex);
+
+#endif // TEXTPIECETABLE_H
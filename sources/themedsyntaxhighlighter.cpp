@@ -1,58 +1,182 @@
+#include <algorithm>
+#include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QMutexLocker>
 #include <QSettings>
 #include <QRegularExpression>
 #include <QTextStream>
 #include "themedsyntaxhighlighter.h"
 
+#define HIGHLIGHT_IDLE_BUDGET_MSECS 8
 #define REGEXP_CRLF "[\\r\\n]"
 #define REGEXP_THEME_LINE "\\s*=\\s*"
 #define REGEXP_THEME_STYLE "\\b([a-z]+)\\:\\s*([0-9a-z#]+)\\b"
 #define REGEXP_WHITESPACE "[\\s\\t]+"
 
-ThemedSyntaxHighlighter::ThemedSyntaxHighlighter(const SyntaxHighlighterTheme &theme, const SyntaxHighlighterDefinitionList &definitions, QTextDocument *document)
-    : QSyntaxHighlighter(document), m_Definitions(definitions), m_Theme(theme)
+QMutex ThemedSyntaxHighlighter::m_CacheMutex;
+QHash<QString, SyntaxHighlighterRules> ThemedSyntaxHighlighter::m_DefinitionCache;
+QHash<QString, SyntaxHighlighterTheme> ThemedSyntaxHighlighter::m_ThemeCache;
+
+ThemedSyntaxHighlighter::ThemedSyntaxHighlighter(const SyntaxHighlighterTheme &theme, const SyntaxHighlighterRules &rules, QTextDocument *document)
+    : QSyntaxHighlighter(document), m_Deferred(false), m_ForcedBlock(-1), m_Rules(rules), m_VisibleFirst(-1), m_VisibleLast(-1), m_WhitespaceFormat(theme.value("whitespaces"))
+{
+    m_IdleTimer.setInterval(0);
+    m_IdleTimer.setSingleShot(true);
+    connect(&m_IdleTimer, &QTimer::timeout, this, &ThemedSyntaxHighlighter::highlightIdle);
+    // 样式在创建时解析一次，高亮时按下标取用
+    m_Formats.reserve(rules.definitions.size());
+    foreach (const SyntaxHighlighterDefinition &definition, rules.definitions) {
+        m_Formats.append(theme.value(definition.style));
+    }
+}
+
+int ThemedSyntaxHighlighter::closeMultiline(const QString &text, const int start, const int from, const int rule)
 {
+    const QRegularExpressionMatch match = m_Rules.definitions.at(rule).end.match(text, from);
+    if (!match.hasMatch()) {
+        // 块状态记录未结束的规则，下一块从该规则的结束表达式继续
+        setFormat(start, text.length() - start, m_Formats.at(rule));
+        setCurrentBlockState(rule + 1);
+        return text.length();
+    }
+    setFormat(start, match.capturedEnd() - start, m_Formats.at(rule));
+    return match.capturedEnd();
 }
 
 void ThemedSyntaxHighlighter::highlightBlock(const QString &text) {
-    foreach (const SyntaxHighlighterDefinition &definition, m_Definitions) {
-        if (definition.regexp.isEmpty()) {
+    const QTextBlock block = currentBlock();
+    const int number = block.blockNumber();
+    if (m_Deferred && (number != m_ForcedBlock)) {
+        if ((block.position() >= m_Frontier.position()) && ((number < m_VisibleFirst) || (number > m_VisibleLast))) {
+            // 还没轮到的块先不处理，标记为未高亮，等滚动到可见范围或空闲时再补上
+            setCurrentBlockState(-1);
+            return;
+        }
+    }
+    // 从左到右只扫描一遍：取最靠左的匹配，同一位置有多条规则匹配时取 .def 中靠前的规则
+    setCurrentBlockState(0);
+    int i = 0;
+    const int state = previousBlockState();
+    if ((state > 0) && (state <= m_Rules.definitions.size()) && m_Rules.definitions.at(state - 1).multiline) {
+        i = closeMultiline(text, 0, 0, state - 1);
+    }
+    while (!m_Rules.groups.isEmpty() && (i < text.length())) {
+        const QRegularExpressionMatch match = m_Rules.scanner.match(text, i);
+        if (!match.hasMatch()) {
+            break;
+        }
+        // 规则内部的捕获组编号都位于本规则外层组与下一条规则外层组之间
+        const int rule = int(std::upper_bound(m_Rules.groups.cbegin(), m_Rules.groups.cend(), match.lastCapturedIndex()) - m_Rules.groups.cbegin()) - 1;
+        const int start = match.capturedStart();
+        const int end = match.capturedEnd();
+        if ((rule >= 0) && m_Rules.definitions.at(rule).multiline) {
+            i = closeMultiline(text, start, end, rule);
             continue;
         }
-        if (definition.multiline) {
-            QStringList pair = definition.regexp.split('|');
-            QRegularExpression fregexp(pair.first());
-            QRegularExpression eregexp(pair.last());
-            setCurrentBlockState(0);
-            int i = 0;
-            if (previousBlockState() != 1) {
-                i = text.indexOf(fregexp);
-            }
-            while (i >= 0) {
-                QRegularExpressionMatch match = eregexp.match(text, i);
-                int j = match.capturedStart();
-                int length;
-                if (j == -1) {
-                    setCurrentBlockState(1);
-                    length = (text.length() - i);
-                } else {
-                    length = ((j - i) + match.capturedLength());
+        if (rule >= 0) {
+            setFormat(start, end - start, m_Formats.at(rule));
+        }
+        i = (end > start) ? end : (end + 1);
+    }
+    if (m_Rules.whitespaces) {
+        // 空白字符的样式叠加在其它规则之上
+        for (int j = 0; j < text.length(); ++j) {
+            if (text.at(j).isSpace()) {
+                int k = j + 1;
+                while ((k < text.length()) && text.at(k).isSpace()) {
+                    k++;
                 }
-                setFormat(i, length, m_Theme.value(definition.style));
-                i = text.indexOf(fregexp, i + length);
+                setFormat(j, k - j, m_WhitespaceFormat);
+                j = k;
             }
-            continue;
         }
-        QRegularExpression regexp(definition.regexp);
-        QRegularExpressionMatchIterator iterator = regexp.globalMatch(text);
-        while (iterator.hasNext()) {
-            QRegularExpressionMatch match = iterator.next();
-            setFormat(match.capturedStart(), match.capturedLength(), m_Theme.value(definition.style));
+    }
+}
+
+void ThemedSyntaxHighlighter::highlightIdle()
+{
+    // 每次只占用一小段时间，分批处理剩余的块，保证界面能及时响应
+    QElapsedTimer timer;
+    timer.start();
+    QTextBlock block = m_Frontier.block();
+    while (block.isValid() && (timer.elapsed() < HIGHLIGHT_IDLE_BUDGET_MSECS)) {
+        // 只强制处理目标块；状态变化连带到的后续块仍在边界之后，会再次标记为未高亮，不会一路高亮到文末
+        m_ForcedBlock = block.blockNumber();
+        rehighlightBlock(block);
+        m_ForcedBlock = -1;
+        block = block.next();
+        if (block.isValid()) {
+            m_Frontier.setPosition(block.position());
         }
     }
+    if (block.isValid()) {
+        m_IdleTimer.start();
+    } else {
+        m_Deferred = false;
+    }
 }
 
-SyntaxHighlighterDefinitionList ThemedSyntaxHighlighter::definitions(const QString &language)
+void ThemedSyntaxHighlighter::highlightVisible(const QTextBlock &first, const QTextBlock &last)
+{
+    if (!m_Deferred) {
+        return;
+    }
+    m_VisibleFirst = first.blockNumber();
+    m_VisibleLast = last.blockNumber();
+    // 可见范围内尚未高亮的块立即处理；多行规则的状态可能暂时不准，后台处理到这里时会自动修正
+    for (QTextBlock block = first; block.isValid() && (block.blockNumber() <= m_VisibleLast); block = block.next()) {
+        if ((block.userState() == -1) && (block.position() >= m_Frontier.position())) {
+            m_ForcedBlock = block.blockNumber();
+            rehighlightBlock(block);
+            m_ForcedBlock = -1;
+        }
+    }
+}
+
+bool ThemedSyntaxHighlighter::isDeferred() const
+{
+    return m_Deferred;
+}
+
+SyntaxHighlighterRules ThemedSyntaxHighlighter::definitions(const QString &language)
+{
+    // 同一语言的规则只解析和编译一次，所有编辑器共享；是否显示空白字符也会影响规则，一并作为键
+    QSettings settings;
+    const bool whitespaces = settings.value("editor_whitespaces", false).toBool();
+    const QString key = language + (whitespaces ? ":whitespaces" : "");
+    // 打开文件的后台线程会提前编译规则，缓存需要加锁
+    QMutexLocker locker(&m_CacheMutex);
+    auto it = m_DefinitionCache.constFind(key);
+    if (it != m_DefinitionCache.constEnd()) {
+        return it.value();
+    }
+    SyntaxHighlighterRules rules;
+    rules.whitespaces = whitespaces;
+    QStringList alternatives;
+    int group = 1;
+    foreach (const SyntaxHighlighterDefinition &definition, parse(language)) {
+        if (!definition.regexp.isValid() || (definition.multiline && !definition.end.isValid())) {
+#ifdef QT_DEBUG
+            qDebug() << "忽略无效的高亮规则" << language << definition.regexp.pattern();
+#endif
+            continue;
+        }
+        // 每条规则包在一个捕获组中，规则自身的捕获组顺延编号
+        rules.definitions.append(definition);
+        rules.groups.append(group);
+        alternatives.append('(' + definition.regexp.pattern() + ')');
+        group += 1 + definition.regexp.captureCount();
+    }
+    if (!alternatives.isEmpty()) {
+        rules.scanner = QRegularExpression(alternatives.join('|'));
+        rules.scanner.optimize();
+    }
+    m_DefinitionCache.insert(key, rules);
+    return rules;
+}
+
+SyntaxHighlighterDefinitionList ThemedSyntaxHighlighter::parse(const QString &language)
 {
     SyntaxHighlighterDefinitionList defs;
     QFile file(QString(":/highlights/%1.def").arg(language));
@@ -65,34 +189,50 @@ SyntaxHighlighterDefinitionList ThemedSyntaxHighlighter::definitions(const QStri
             QStringList pair = line.split(QRegularExpression(REGEXP_WHITESPACE), Qt::SkipEmptyParts);
             if (pair.size() == 2) {
                 if (QString::compare(pair.first(), "@include") == 0) {
-                    defs << definitions(pair.last());
+                    defs << parse(pair.last());
                 } else {
                     SyntaxHighlighterDefinition def;
                     def.style = pair.first();
                     def.multiline = def.style.endsWith('?');
                     if (def.multiline) {
                         def.style = def.style.mid(0, def.style.length() - 1);
+                        // 多行规则以 | 分隔起止表达式
+                        const QStringList parts = pair.last().split('|');
+                        def.regexp = QRegularExpression(parts.first());
+                        def.end = QRegularExpression(parts.last());
+                        // 结束表达式单独匹配，立即编译，启用 JIT 时同时生成机器码
+                        def.end.optimize();
+                    } else {
+                        def.regexp = QRegularExpression(pair.last());
                     }
-                    def.regexp = pair.last();
                     defs << def;
                 }
             }
         }
     }
-    QSettings settings;
-    const bool whitespaces = settings.value("editor_whitespaces", false).toBool();
-    if (whitespaces) {
-        SyntaxHighlighterDefinition def;
-        def.multiline = false;
-        def.regexp = REGEXP_WHITESPACE;
-        def.style = "whitespaces";
-        defs << def;
-    }
     return defs;
 }
 
+void ThemedSyntaxHighlighter::setDeferred(const bool deferred)
+{
+    // 需要在文档首次整体高亮（构造后的下一轮事件循环）之前设置
+    m_Deferred = deferred && document();
+    if (m_Deferred) {
+        m_Frontier = QTextCursor(document());
+        m_IdleTimer.start();
+    } else {
+        m_IdleTimer.stop();
+    }
+}
+
 SyntaxHighlighterTheme ThemedSyntaxHighlighter::theme(const QString &name)
 {
+    // 与规则缓存共用一把锁，后台线程也可能读取主题
+    QMutexLocker locker(&m_CacheMutex);
+    auto it = m_ThemeCache.constFind(name);
+    if (it != m_ThemeCache.constEnd()) {
+        return it.value();
+    }
     SyntaxHighlighterTheme theme;
     QFile file(QString(":/themes/%1.theme").arg(name));
     if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
@@ -126,5 +266,6 @@ SyntaxHighlighterTheme ThemedSyntaxHighlighter::theme(const QString &name)
             }
         }
     }
+    m_ThemeCache.insert(name, theme);
     return theme;
 }
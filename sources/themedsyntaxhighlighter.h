@@ -1,29 +1,66 @@
 #ifndef THEMEDSYNTAXHIGHLIGHTER_H
 #define THEMEDSYNTAXHIGHLIGHTER_H
 
+#include <QHash>
+#include <QMutex>
+#include <QRegularExpression>
 #include <QSyntaxHighlighter>
+#include <QTextBlock>
+#include <QTextCharFormat>
+#include <QTextCursor>
+#include <QTimer>
+#include <QVector>
 
+// 多行规则的 regexp 为起始表达式，end 为结束表达式
 struct SyntaxHighlighterDefinition
 {
+    QRegularExpression end;
     bool multiline;
-    QString regexp;
+    QRegularExpression regexp;
     QString style;
 };
 
 typedef QList<SyntaxHighlighterDefinition> SyntaxHighlighterDefinitionList;
 
+// 一种语言的全部规则合并成的扫描器，每条规则对应一个外层捕获组
+struct SyntaxHighlighterRules
+{
+    SyntaxHighlighterDefinitionList definitions;
+    QVector<int> groups;
+    QRegularExpression scanner;
+    bool whitespaces;
+};
+
 typedef QMap<QString, QTextCharFormat> SyntaxHighlighterTheme;
 
 class ThemedSyntaxHighlighter : public QSyntaxHighlighter
 {
+    Q_OBJECT
 public:
-    explicit ThemedSyntaxHighlighter(const SyntaxHighlighterTheme &theme, const SyntaxHighlighterDefinitionList &definitions, QTextDocument *document = nullptr);
-    static SyntaxHighlighterDefinitionList definitions(const QString &language);
+    explicit ThemedSyntaxHighlighter(const SyntaxHighlighterTheme &theme, const SyntaxHighlighterRules &rules, QTextDocument *document = nullptr);
+    static SyntaxHighlighterRules definitions(const QString &language);
     static SyntaxHighlighterTheme theme(const QString &name);
     void highlightBlock(const QString &text);
+    void highlightVisible(const QTextBlock &first, const QTextBlock &last);
+    bool isDeferred() const;
+    void setDeferred(const bool deferred);
 private:
-    SyntaxHighlighterDefinitionList m_Definitions;
-    SyntaxHighlighterTheme m_Theme;
+    static QMutex m_CacheMutex;
+    static QHash<QString, SyntaxHighlighterRules> m_DefinitionCache;
+    bool m_Deferred;
+    int m_ForcedBlock;
+    QVector<QTextCharFormat> m_Formats;
+    QTextCursor m_Frontier;
+    QTimer m_IdleTimer;
+    SyntaxHighlighterRules m_Rules;
+    static QHash<QString, SyntaxHighlighterTheme> m_ThemeCache;
+    int m_VisibleFirst;
+    int m_VisibleLast;
+    QTextCharFormat m_WhitespaceFormat;
+    int closeMultiline(const QString &text, const int start, const int from, const int rule);
+    static SyntaxHighlighterDefinitionList parse(const QString &language);
+private slots:
+    void highlightIdle();
 };
 
 #endif // THEMEDSYNTAXHIGHLIGHTER_H
@@ -15,6 +15,7 @@
 #include <QStandardPaths>
 #include <QThread>
 #include <QUrl>
+#include "processutils.h"
 #include "tooldownloadworker.h"
 
 #ifdef Q_OS_WIN
@@ -157,6 +158,9 @@ void ToolDownloadWorker::download()
             emit progress(75, tr("正在复制 %1...").arg(fileName));
             QString targetPath = QDir(extractPath).filePath(fileName);
             
+            // 常驻的工具进程仍在使用旧的 JAR，先让它们退出
+            ProcessUtils::stopToolHosts();
+
             // 如果目标文件已存在，则删除
             if (QFile::exists(targetPath)) {
                 QFile::remove(targetPath);
@@ -253,6 +257,7 @@ void ToolDownloadWorker::download()
             break;
         }
         settings.sync();
+        ProcessUtils::clearToolCache();
 
         // 清理下载文件
         m_DownloadFile->remove();
@@ -0,0 +1,407 @@
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QStandardPaths>
+#include <QUuid>
+#include "toolhost.h"
+
+#define TOOLHOST_CLASS "ToolHost"
+#define TOOLHOST_COMPILED "ToolHost.ok"
+#define TOOLHOST_SOURCE ":/tools/ToolHost.java"
+#define TOOLHOST_SHUTDOWN_MSECS 2000
+
+ToolHostRequest::ToolHostRequest(const QStringList &args, const int timeout, QObject *parent)
+    : QObject(parent), m_Args(args), m_Fallback(false), m_Timeout(timeout)
+{
+    m_Result.code = -1;
+}
+
+QStringList ToolHostRequest::args() const
+{
+    return m_Args;
+}
+
+bool ToolHostRequest::fallback() const
+{
+    return m_Fallback;
+}
+
+void ToolHostRequest::finish(const int code, const bool fallback)
+{
+    m_Fallback = fallback;
+    m_Result.code = code;
+    emit finished();
+}
+
+ProcessResult &ToolHostRequest::result()
+{
+    return m_Result;
+}
+
+int ToolHostRequest::timeout() const
+{
+    return m_Timeout;
+}
+
+ToolHost::ToolHost(const QString &java, const QString &jar, const int heap, QObject *parent)
+    : QObject(parent), m_Compiler(nullptr), m_CompileFailed(false), m_Heap(heap), m_Jar(jar), m_Java(java), m_Process(nullptr), m_Ready(false), m_Stopped(false), m_Timeout(nullptr), m_Unsupported(false)
+{
+}
+
+void ToolHost::compile(const QString &source)
+{
+    // 首次使用时用同一 JDK 中的 javac 编译到应用数据目录，之后启动宿主不再需要编译源文件
+    QString javac = QFileInfo(m_Java).dir().filePath("javac");
+#ifdef Q_OS_WIN
+    javac.append(".exe");
+#endif
+    if (!QFile::exists(javac)) {
+        // 只有 JRE 时使用源文件模式（需要 Java 11+）
+        handleCompiled(false);
+        return;
+    }
+    m_Compiler = new QProcess(this);
+    m_Compiler->setProcessChannelMode(QProcess::MergedChannels);
+    connect(m_Compiler, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            handleCompiled(false);
+        }
+    });
+    connect(m_Compiler, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this](int code, QProcess::ExitStatus status) {
+        handleCompiled((status == QProcess::NormalExit) && (code == 0));
+    });
+#ifdef QT_DEBUG
+    qDebug() << "正在编译工具宿主" << javac << source;
+#endif
+    m_Compiler->start(javac, {"-encoding", "UTF-8", "-d", QFileInfo(source).path(), source});
+}
+
+void ToolHost::detach(QProcess *process)
+{
+    // 不在界面线程中等待进程退出：关闭输入并请求终止，超时后强制结束，退出后再释放
+    process->setParent(nullptr);
+    if (process->state() == QProcess::NotRunning) {
+        process->deleteLater();
+        return;
+    }
+    QObject::connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), process, &QObject::deleteLater);
+    process->closeWriteChannel();
+    process->terminate();
+    QTimer::singleShot(TOOLHOST_SHUTDOWN_MSECS, process, [process] {
+        process->kill();
+    });
+}
+
+void ToolHost::dispatchNext()
+{
+    if (!m_Ready || m_Current || m_Queue.isEmpty()) {
+        return;
+    }
+    if (!m_Process || (m_Process->state() != QProcess::Running)) {
+        return;
+    }
+    m_Current = m_Queue.dequeue();
+    if (!m_Current) {
+        dispatchNext();
+        return;
+    }
+    const QStringList args = m_Current->args();
+    ProcessOutput::instance()->emitCommandStarting(m_Jar, args);
+    QByteArray command = QByteArray::number(args.size()).append('\n');
+    foreach (auto arg, args) {
+        command.append(arg.toUtf8()).append('\n');
+    }
+    m_Process->write(command);
+    m_Timeout->start(m_Current->timeout() * 1000);
+}
+
+void ToolHost::execute(ToolHostRequest *request)
+{
+    // 已停止或当前 Java 版本无法常驻的宿主不再接受命令，调用方改用一次性进程
+    if (m_Stopped || m_Unsupported) {
+        request->finish(-1, true);
+        return;
+    }
+    m_Queue.enqueue(request);
+    if (!m_Process) {
+        start();
+    }
+    dispatchNext();
+}
+
+void ToolHost::failAll(const bool fallback)
+{
+    // 正在执行的命令已经中断，不能再重新执行；排队中的命令可以交回一次性进程
+    if (m_Current) {
+        ToolHostRequest *current = m_Current;
+        m_Current = nullptr;
+        ProcessOutput::instance()->emitCommandFinished(current->result());
+        current->finish(-1);
+    }
+    while (!m_Queue.isEmpty()) {
+        ToolHostRequest *request = m_Queue.dequeue();
+        if (request) {
+            request->finish(-1, fallback);
+        }
+    }
+}
+
+void ToolHost::handleCompiled(const bool success)
+{
+    if (m_Compiler) {
+        m_Compiler->deleteLater();
+        m_Compiler = nullptr;
+    }
+    const QString source = sourceFile();
+    if (success) {
+        QFile stamp(QFileInfo(source).dir().filePath(TOOLHOST_COMPILED));
+        stamp.open(QIODevice::WriteOnly);
+    } else {
+#ifdef QT_DEBUG
+        qDebug() << "无法编译工具宿主，改用源文件模式" << m_Java;
+#endif
+        m_CompileFailed = true;
+    }
+    if (!m_Queue.isEmpty()) {
+        launch(source);
+    }
+}
+
+void ToolHost::handleErrorOccurred(QProcess::ProcessError error)
+{
+    // 启动失败（例如 Java 版本过低不支持源文件模式）时交回一次性进程执行
+    if (error == QProcess::FailedToStart) {
+#ifdef QT_DEBUG
+        qDebug() << "无法启动工具宿主" << m_Jar;
+#endif
+        m_Process->deleteLater();
+        m_Process = nullptr;
+        m_Ready = false;
+        failAll(true);
+    }
+}
+
+void ToolHost::handleFinished(int code, QProcess::ExitStatus status)
+{
+    Q_UNUSED(status)
+#ifdef QT_DEBUG
+    qDebug() << "工具宿主已退出" << m_Jar << code;
+#endif
+    m_Timeout->stop();
+    handleReadyRead();
+    const bool ready = m_Ready;
+    m_Buffer.clear();
+    m_Process->deleteLater();
+    m_Process = nullptr;
+    m_Ready = false;
+    if (!ready) {
+        // 尚未就绪就退出，说明宿主本身不可用
+        failAll(true);
+        return;
+    }
+    // 工具调用了无法拦截的 System.exit，当前命令以该代码结束，剩余命令在新的宿主中执行
+    if (m_Current) {
+        ToolHostRequest *current = m_Current;
+        m_Current = nullptr;
+        ProcessOutput::instance()->emitCommandFinished(current->result());
+        current->finish(code);
+    }
+    if (!m_Queue.isEmpty()) {
+        start();
+    } else {
+        retireIfIdle();
+    }
+}
+
+void ToolHost::handleLine(const QString &line, QStringList &output)
+{
+    if (line.startsWith(m_Marker)) {
+        const QString status = line.mid(m_Marker.length()).trimmed();
+        if (status == "READY") {
+            m_Ready = true;
+        } else if (status == "UNSUPPORTED") {
+            // Java 18 起无法拦截 System.exit，宿主随即退出，之后的命令都使用一次性进程
+            m_Unsupported = true;
+        } else if (m_Current) {
+            m_Timeout->stop();
+            ToolHostRequest *current = m_Current;
+            m_Current = nullptr;
+            if (!output.isEmpty()) {
+                ProcessOutput::instance()->emitCommandOutput(output);
+                output.clear();
+            }
+            ProcessOutput::instance()->emitCommandFinished(current->result());
+            current->finish(status.toInt());
+            retireIfIdle();
+        }
+        return;
+    }
+    if (m_Current) {
+        QStringList &captured = m_Current->result().output;
+        captured.append(line);
+        if (captured.size() > PROCESS_OUTPUT_MAX_LINES) {
+            captured.removeFirst();
+        }
+    }
+    output.append(line);
+}
+
+void ToolHost::handleReadyRead()
+{
+    if (!m_Process) {
+        return;
+    }
+    m_Buffer.append(m_Process->readAllStandardOutput());
+    static const QRegularExpression crlf("[\\r\\n]");
+    QStringList output;
+    int end;
+    while ((end = m_Buffer.indexOf('\n')) >= 0) {
+        const QString line = QString::fromUtf8(m_Buffer.constData(), end).remove(crlf);
+        m_Buffer.remove(0, end + 1);
+        if (!line.isEmpty()) {
+            handleLine(line, output);
+        }
+    }
+    if (m_Buffer.size() >= PROCESS_OUTPUT_MAX_LINE_LENGTH) {
+        handleLine(QString::fromUtf8(m_Buffer), output);
+        m_Buffer.clear();
+    }
+    if (!output.isEmpty()) {
+        ProcessOutput::instance()->emitCommandOutput(output);
+    }
+    dispatchNext();
+}
+
+void ToolHost::handleTimeout()
+{
+#ifdef QT_DEBUG
+    qDebug() << "工具宿主命令超时，正在终止" << m_Jar;
+#endif
+    if (m_Process) {
+        m_Process->kill();
+    }
+}
+
+void ToolHost::launch(const QString &source)
+{
+    if (!m_Timeout) {
+        m_Timeout = new QTimer(this);
+        m_Timeout->setSingleShot(true);
+        connect(m_Timeout, &QTimer::timeout, this, &ToolHost::handleTimeout);
+    }
+    m_Marker = QString("@@TOOLHOST-%1@@").arg(QUuid::createUuid().toString(QUuid::WithoutBraces));
+    m_Ready = false;
+    m_Buffer.clear();
+    m_Process = new QProcess(this);
+    m_Process->setProcessChannelMode(QProcess::MergedChannels);
+    connect(m_Process, &QProcess::errorOccurred, this, &ToolHost::handleErrorOccurred);
+    connect(m_Process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &ToolHost::handleFinished);
+    connect(m_Process, &QProcess::readyReadStandardOutput, this, &ToolHost::handleReadyRead);
+    QStringList args;
+    args << QString("-Xmx%1m").arg(m_Heap);
+    if (m_CompileFailed) {
+        args << "-cp" << m_Jar << source;
+    } else {
+        args << "-cp" << (m_Jar + QDir::listSeparator() + QFileInfo(source).path()) << TOOLHOST_CLASS;
+    }
+    args << m_Jar << m_Marker;
+#ifdef QT_DEBUG
+    qDebug() << "正在启动工具宿主" << m_Java << args;
+#endif
+    m_Process->start(m_Java, args);
+}
+
+bool ToolHost::matches(const QString &java, const QString &jar, const int heap) const
+{
+    return (m_Java == java) && (m_Jar == jar) && (m_Heap == heap);
+}
+
+void ToolHost::retire()
+{
+    // 不再接受新命令，手头的命令完成后退出
+    m_Stopped = true;
+    retireIfIdle();
+}
+
+void ToolHost::retireIfIdle()
+{
+    // 可能处于进程信号的处理过程中，由析构函数负责关闭进程
+    if (m_Stopped && !m_Current && m_Queue.isEmpty()) {
+        deleteLater();
+    }
+}
+
+void ToolHost::shutdown()
+{
+    // 关闭标准输入后宿主会自行退出，进程对象在退出后自行释放
+    if (m_Compiler) {
+        disconnect(m_Compiler, nullptr, this, nullptr);
+        detach(m_Compiler);
+        m_Compiler = nullptr;
+    }
+    if (m_Process) {
+        disconnect(m_Process, nullptr, this, nullptr);
+        detach(m_Process);
+        m_Process = nullptr;
+    }
+    m_Ready = false;
+    m_Stopped = true;
+    failAll(true);
+}
+
+QString ToolHost::sourceFile() const
+{
+    // 将内置的 ToolHost.java 释放到应用数据目录，目录名取决于源文件内容和所用的 Java，编译结果保存在同一目录
+    QFile resource(TOOLHOST_SOURCE);
+    if (!resource.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    const QByteArray source = resource.readAll();
+    QCryptographicHash digest(QCryptographicHash::Md5);
+    digest.addData(source);
+    digest.addData(m_Java.toUtf8());
+    const QString folder = QString("toolhost/%1").arg(QString::fromLatin1(digest.result().toHex()));
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    dir.mkpath(folder);
+    const QString path = dir.filePath(folder + "/ToolHost.java");
+    QFile file(path);
+    if (file.exists() && file.open(QIODevice::ReadOnly)) {
+        const bool same = file.readAll() == source;
+        file.close();
+        if (same) {
+            return path;
+        }
+    }
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return QString();
+    }
+    file.write(source);
+    file.close();
+    return path;
+}
+
+void ToolHost::start()
+{
+    if (m_Compiler) {
+        // 编译完成后启动
+        return;
+    }
+    const QString source = sourceFile();
+    if (source.isEmpty()) {
+        failAll(true);
+        return;
+    }
+    if (!m_CompileFailed && !QFileInfo::exists(QFileInfo(source).dir().filePath(TOOLHOST_COMPILED))) {
+        compile(source);
+        return;
+    }
+    launch(source);
+}
+
+ToolHost::~ToolHost()
+{
+    shutdown();
+}
@@ -0,0 +1,73 @@
+#ifndef TOOLHOST_H
+#define TOOLHOST_H
+
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QQueue>
+#include <QTimer>
+#include "processutils.h"
+
+class ToolHostRequest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ToolHostRequest(const QStringList &args, const int timeout, QObject *parent = nullptr);
+    QStringList args() const;
+    bool fallback() const;
+    void finish(const int code, const bool fallback = false);
+    ProcessResult &result();
+    int timeout() const;
+private:
+    QStringList m_Args;
+    bool m_Fallback;
+    ProcessResult m_Result;
+    int m_Timeout;
+signals:
+    void finished();
+};
+
+class ToolHost : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ToolHost(const QString &java, const QString &jar, const int heap, QObject *parent = nullptr);
+    ~ToolHost();
+    bool matches(const QString &java, const QString &jar, const int heap) const;
+    void retire();
+    void shutdown();
+public slots:
+    void execute(ToolHostRequest *request);
+private:
+    QByteArray m_Buffer;
+    QProcess *m_Compiler;
+    bool m_CompileFailed;
+    QPointer<ToolHostRequest> m_Current;
+    int m_Heap;
+    QString m_Jar;
+    QString m_Java;
+    QString m_Marker;
+    QProcess *m_Process;
+    QQueue<QPointer<ToolHostRequest>> m_Queue;
+    bool m_Ready;
+    bool m_Stopped;
+    QTimer *m_Timeout;
+    bool m_Unsupported;
+    void compile(const QString &source);
+    static void detach(QProcess *process);
+    void dispatchNext();
+    void failAll(const bool fallback);
+    void handleCompiled(const bool success);
+    void handleLine(const QString &line, QStringList &output);
+    void launch(const QString &source);
+    void retireIfIdle();
+    QString sourceFile() const;
+    void start();
+private slots:
+    void handleErrorOccurred(QProcess::ProcessError error);
+    void handleFinished(int code, QProcess::ExitStatus status);
+    void handleReadyRead();
+    void handleTimeout();
+};
+
+#endif // TOOLHOST_H
@@ -0,0 +1,418 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <QDebug>
+#include <QDir>
+#include <QHash>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QtEndian>
+#include "trigramindex.h"
+
+#define TRIGRAM_INDEX_CHUNK 256
+#define TRIGRAM_INDEX_DIR ".apkstudio"
+#define TRIGRAM_INDEX_FILE "trigrams.idx"
+#define TRIGRAM_INDEX_MAGIC "ASTI"
+#define TRIGRAM_INDEX_VERSION 1
+
+// 文件格式（小端序）：
+//   文件头   magic[4] version fileCount trigramCount postingsSize pathsSize（各 4 字节）
+//   文件表   fileCount × { modified(8) size(8) pathOffset(4) pathLength(4) }
+//   三元组表 trigramCount × { key(4) offset(4) count(4) }，按 key 排序
+//   倒排表   文件编号升序排列，差值以 varint 编码
+//   路径     相对于项目根目录的 UTF-8 路径
+#define HEADER_SIZE 24
+#define FILE_RECORD_SIZE 24
+#define TRIGRAM_RECORD_SIZE 12
+
+struct TrigramPosting
+{
+    quint32 count = 0;
+    QByteArray data;
+    quint32 last = 0;
+};
+
+static void appendPosting(TrigramPosting &posting, const quint32 id)
+{
+    quint32 delta = posting.count ? (id - posting.last) : id;
+    while (delta >= 0x80) {
+        posting.data.append(char((delta & 0x7F) | 0x80));
+        delta >>= 7;
+    }
+    posting.data.append(char(delta));
+    posting.last = id;
+    posting.count++;
+}
+
+template <typename T>
+static void appendValue(QByteArray &out, const T value)
+{
+    const T le = qToLittleEndian(value);
+    out.append(reinterpret_cast<const char *>(&le), sizeof(T));
+}
+
+QHash<QString, QSet<QString>> TrigramIndex::m_Dirty;
+QMutex TrigramIndex::m_DirtyMutex;
+
+TrigramIndex::TrigramIndex(const QString &folder)
+    : m_Data(nullptr), m_FileCount(0), m_Folder(folder), m_PathsSize(0), m_PostingsSize(0), m_TrigramCount(0)
+{
+}
+
+QStringList TrigramIndex::candidates(const QByteArray &needle) const
+{
+    QStringList paths;
+    const QVector<quint32> keys = extract(reinterpret_cast<const uchar *>(needle.constData()), needle.size());
+    if (keys.isEmpty()) {
+        // 关键词太短无法筛选，返回全部文件
+        for (quint32 id = 0; id < m_FileCount; ++id) {
+            paths.append(m_Folder + '/' + filePath(id));
+        }
+        return paths;
+    }
+    QVector<QPair<quint32, quint32>> lists;
+    foreach (auto key, keys) {
+        quint32 offset;
+        quint32 count;
+        if (!findTrigram(key, offset, count)) {
+            return paths;
+        }
+        lists.append(qMakePair(count, offset));
+    }
+    // 从最短的倒排表开始求交集
+    std::sort(lists.begin(), lists.end());
+    QVector<quint32> ids = postings(lists.first().second, lists.first().first);
+    for (int i = 1; (i < lists.size()) && !ids.isEmpty(); ++i) {
+        const QVector<quint32> other = postings(lists.at(i).second, lists.at(i).first);
+        QVector<quint32> common;
+        std::set_intersection(ids.cbegin(), ids.cend(), other.cbegin(), other.cend(), std::back_inserter(common));
+        ids = common;
+    }
+    foreach (auto id, ids) {
+        paths.append(m_Folder + '/' + filePath(id));
+    }
+    return paths;
+}
+
+QStringList TrigramIndex::dirtyFiles(const QString &folder)
+{
+    QMutexLocker locker(&m_DirtyMutex);
+    return m_Dirty.value(QDir::cleanPath(folder)).values();
+}
+
+QVector<quint32> TrigramIndex::extract(const uchar *data, const qint64 size)
+{
+    // 三元组按 ASCII 折叠后计算，同时适用于区分和不区分大小写的搜索；跨行的三元组不会被搜索到，直接跳过
+    const uchar *fold = foldTable();
+    QVector<quint32> keys;
+    keys.reserve(qMin<qint64>(size, 1 << 20));
+    quint32 key = 0;
+    int valid = 0;
+    for (qint64 i = 0; i < size; ++i) {
+        const uchar c = fold[data[i]];
+        if ((c == '\n') || (c == '\r')) {
+            valid = 0;
+            continue;
+        }
+        key = ((key << 8) | c) & 0xFFFFFF;
+        if (++valid >= 3) {
+            keys.append(key);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+qint64 TrigramIndex::fileModified(const quint32 id) const
+{
+    return qFromLittleEndian<qint64>(m_Data + HEADER_SIZE + (id * FILE_RECORD_SIZE));
+}
+
+QString TrigramIndex::filePath(const quint32 id) const
+{
+    const uchar *record = m_Data + HEADER_SIZE + (id * FILE_RECORD_SIZE);
+    const uchar *paths = m_Data + HEADER_SIZE + (m_FileCount * FILE_RECORD_SIZE) + (m_TrigramCount * TRIGRAM_RECORD_SIZE) + m_PostingsSize;
+    const quint32 offset = qFromLittleEndian<quint32>(record + 16);
+    const quint32 length = qFromLittleEndian<quint32>(record + 20);
+    if ((offset > m_PathsSize) || (length > (m_PathsSize - offset))) {
+        return QString();
+    }
+    return QString::fromUtf8(reinterpret_cast<const char *>(paths + offset), length);
+}
+
+qint64 TrigramIndex::fileSize(const quint32 id) const
+{
+    return qFromLittleEndian<qint64>(m_Data + HEADER_SIZE + (id * FILE_RECORD_SIZE) + 8);
+}
+
+bool TrigramIndex::findTrigram(const quint32 key, quint32 &offset, quint32 &count) const
+{
+    const uchar *table = m_Data + HEADER_SIZE + (m_FileCount * FILE_RECORD_SIZE);
+    quint32 low = 0;
+    quint32 high = m_TrigramCount;
+    while (low < high) {
+        const quint32 middle = low + ((high - low) / 2);
+        const uchar *record = table + (middle * TRIGRAM_RECORD_SIZE);
+        const quint32 current = qFromLittleEndian<quint32>(record);
+        if (current == key) {
+            offset = qFromLittleEndian<quint32>(record + 4);
+            count = qFromLittleEndian<quint32>(record + 8);
+            return true;
+        }
+        if (current < key) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+const uchar *TrigramIndex::foldTable()
+{
+    // 只折叠 ASCII 字母，UTF-8 多字节序列中的字节都不小于 0x80，不会被误改
+    static const std::array<uchar, 256> table = [] {
+        std::array<uchar, 256> folded;
+        for (int i = 0; i < 256; ++i) {
+            folded[i] = ((i >= 'A') && (i <= 'Z')) ? uchar(i - 'A' + 'a') : uchar(i);
+        }
+        return folded;
+    }();
+    return table.data();
+}
+
+QString TrigramIndex::indexFile() const
+{
+    return QDir(m_Folder).filePath(QString(TRIGRAM_INDEX_DIR) + '/' + TRIGRAM_INDEX_FILE);
+}
+
+bool TrigramIndex::load()
+{
+    m_File.setFileName(indexFile());
+    if (!m_File.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    // 直接映射索引文件，查询时不需要整体读入
+    const uchar *data = m_File.map(0, m_File.size());
+    if (data && parse(data, m_File.size())) {
+        return true;
+    }
+#ifdef QT_DEBUG
+    qDebug() << "忽略无效的索引文件" << m_File.fileName();
+#endif
+    m_File.close();
+    parse(nullptr, 0);
+    return false;
+}
+
+void TrigramIndex::markDirty(const QString &folder, const QStringList &paths)
+{
+    // 保存过的文件在下次后台更新索引之前由搜索直接扫描
+    QMutexLocker locker(&m_DirtyMutex);
+    QSet<QString> &dirty = m_Dirty[QDir::cleanPath(folder)];
+    foreach (const QString &path, paths) {
+        dirty.insert(path);
+    }
+}
+
+bool TrigramIndex::parse(const uchar *data, const qint64 size)
+{
+    m_Data = nullptr;
+    m_FileCount = m_TrigramCount = m_PostingsSize = m_PathsSize = 0;
+    if (!data || (size < HEADER_SIZE) || (memcmp(data, TRIGRAM_INDEX_MAGIC, 4) != 0)
+            || (qFromLittleEndian<quint32>(data + 4) != TRIGRAM_INDEX_VERSION)) {
+        return false;
+    }
+    const quint32 fileCount = qFromLittleEndian<quint32>(data + 8);
+    const quint32 trigramCount = qFromLittleEndian<quint32>(data + 12);
+    const quint32 postingsSize = qFromLittleEndian<quint32>(data + 16);
+    const quint32 pathsSize = qFromLittleEndian<quint32>(data + 20);
+    const qint64 expected = HEADER_SIZE + (qint64(fileCount) * FILE_RECORD_SIZE) + (qint64(trigramCount) * TRIGRAM_RECORD_SIZE) + postingsSize + pathsSize;
+    if (expected != size) {
+        return false;
+    }
+    m_Data = data;
+    m_FileCount = fileCount;
+    m_TrigramCount = trigramCount;
+    m_PostingsSize = postingsSize;
+    m_PathsSize = pathsSize;
+    return true;
+}
+
+QVector<quint32> TrigramIndex::postings(const quint32 offset, const quint32 count) const
+{
+    if (offset > m_PostingsSize) {
+        return QVector<quint32>();
+    }
+    const uchar *p = m_Data + HEADER_SIZE + (m_FileCount * FILE_RECORD_SIZE) + (m_TrigramCount * TRIGRAM_RECORD_SIZE) + offset;
+    const uchar *end = p + (m_PostingsSize - offset);
+    QVector<quint32> ids;
+    ids.reserve(count);
+    quint32 id = 0;
+    for (quint32 i = 0; (i < count) && (p < end); ++i) {
+        quint32 delta = 0;
+        int shift = 0;
+        while ((p < end) && (*p & 0x80)) {
+            delta |= quint32(*p++ & 0x7F) << shift;
+            shift += 7;
+        }
+        if (p < end) {
+            delta |= quint32(*p++) << shift;
+        }
+        id = i ? (id + delta) : delta;
+        ids.append(id);
+    }
+    return ids;
+}
+
+bool TrigramIndex::save()
+{
+    if (m_Buffer.isEmpty()) {
+        return false;
+    }
+    QDir(m_Folder).mkpath(TRIGRAM_INDEX_DIR);
+    QSaveFile file(indexFile());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(m_Buffer);
+    return file.commit();
+}
+
+QStringList TrigramIndex::takeDirtyFiles(const QString &folder)
+{
+    QMutexLocker locker(&m_DirtyMutex);
+    return m_Dirty.take(QDir::cleanPath(folder)).values();
+}
+
+QVector<quint32> TrigramIndex::trigrams(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || (file.size() == 0)) {
+        return QVector<quint32>();
+    }
+    const uchar *data = file.map(0, file.size());
+    if (data) {
+        return extract(data, file.size());
+    }
+    const QByteArray content = file.readAll();
+    return extract(reinterpret_cast<const uchar *>(content.constData()), content.size());
+}
+
+bool TrigramIndex::update(const QList<TrigramIndexEntry> &files, const QStringList &dirty, const std::function<bool()> &cancelled)
+{
+    // 修改时间和大小都未变化的文件沿用旧索引，只重新读取新增或修改过的文件；保存过的文件总是重新读取
+    const QString prefix = m_Folder + '/';
+    QSet<QString> forced;
+    foreach (const QString &path, dirty) {
+        if (path.startsWith(prefix)) {
+            forced.insert(path.mid(prefix.size()));
+        }
+    }
+    QHash<QString, quint32> previous;
+    previous.reserve(m_FileCount);
+    for (quint32 id = 0; id < m_FileCount; ++id) {
+        previous.insert(filePath(id), id);
+    }
+    QVector<QPair<quint32, int>> kept;
+    QVector<int> changed;
+    for (int i = 0; i < files.size(); ++i) {
+        const TrigramIndexEntry &entry = files.at(i);
+        auto it = previous.constFind(entry.path);
+        if ((it != previous.constEnd()) && !forced.contains(entry.path) && (fileModified(it.value()) == entry.modified) && (fileSize(it.value()) == entry.size)) {
+            kept.append(qMakePair(it.value(), i));
+        } else {
+            changed.append(i);
+        }
+    }
+    if (changed.isEmpty() && (kept.size() == int(m_FileCount))) {
+        return false;
+    }
+#ifdef QT_DEBUG
+    qDebug() << "更新项目索引" << m_Folder << "保留" << kept.size() << "个文件，重新索引" << changed.size() << "个文件";
+#endif
+    // 保留的文件按旧编号排序后重新编号，旧倒排表映射后仍然有序
+    std::sort(kept.begin(), kept.end());
+    QVector<qint64> remap(m_FileCount, -1);
+    QVector<int> order;
+    order.reserve(files.size());
+    foreach (auto pair, kept) {
+        remap[pair.first] = order.size();
+        order.append(pair.second);
+    }
+    QHash<quint32, TrigramPosting> lists;
+    lists.reserve(m_TrigramCount);
+    const uchar *table = m_Data + HEADER_SIZE + (m_FileCount * FILE_RECORD_SIZE);
+    for (quint32 t = 0; t < m_TrigramCount; ++t) {
+        const uchar *record = table + (t * TRIGRAM_RECORD_SIZE);
+        TrigramPosting *posting = nullptr;
+        foreach (auto id, postings(qFromLittleEndian<quint32>(record + 4), qFromLittleEndian<quint32>(record + 8))) {
+            if ((id < m_FileCount) && (remap.at(id) >= 0)) {
+                if (!posting) {
+                    posting = &lists[qFromLittleEndian<quint32>(record)];
+                }
+                appendPosting(*posting, quint32(remap.at(id)));
+            }
+        }
+    }
+    // 新增或修改过的文件分批并行提取三元组，按编号顺序合并
+    QThreadPool pool;
+    for (int base = 0; base < changed.size(); base += TRIGRAM_INDEX_CHUNK) {
+        if (cancelled()) {
+            return false;
+        }
+        const int count = qMin(TRIGRAM_INDEX_CHUNK, changed.size() - base);
+        QVector<QVector<quint32>> chunk(count);
+        for (int j = 0; j < count; ++j) {
+            const QString path = m_Folder + '/' + files.at(changed.at(base + j)).path;
+            QVector<quint32> *keys = &chunk[j];
+            pool.start([keys, path] {
+                *keys = trigrams(path);
+            });
+        }
+        pool.waitForDone();
+        for (int j = 0; j < count; ++j) {
+            const quint32 id = order.size();
+            order.append(changed.at(base + j));
+            foreach (auto key, chunk.at(j)) {
+                appendPosting(lists[key], id);
+            }
+        }
+    }
+    // 生成新的索引映像
+    QByteArray records;
+    QByteArray paths;
+    foreach (auto index, order) {
+        const TrigramIndexEntry &entry = files.at(index);
+        const QByteArray path = entry.path.toUtf8();
+        appendValue<qint64>(records, entry.modified);
+        appendValue<qint64>(records, entry.size);
+        appendValue<quint32>(records, paths.size());
+        appendValue<quint32>(records, path.size());
+        paths.append(path);
+    }
+    QList<quint32> keys = lists.keys();
+    std::sort(keys.begin(), keys.end());
+    QByteArray trigramTable;
+    QByteArray blob;
+    foreach (auto key, keys) {
+        const TrigramPosting &posting = lists[key];
+        appendValue<quint32>(trigramTable, key);
+        appendValue<quint32>(trigramTable, blob.size());
+        appendValue<quint32>(trigramTable, posting.count);
+        blob.append(posting.data);
+    }
+    QByteArray image(TRIGRAM_INDEX_MAGIC, 4);
+    appendValue<quint32>(image, TRIGRAM_INDEX_VERSION);
+    appendValue<quint32>(image, order.size());
+    appendValue<quint32>(image, keys.size());
+    appendValue<quint32>(image, blob.size());
+    appendValue<quint32>(image, paths.size());
+    image.append(records).append(trigramTable).append(blob).append(paths);
+    // 先释放旧文件的映射，保存时才能替换它
+    m_File.close();
+    m_Buffer = image;
+    return parse(reinterpret_cast<const uchar *>(m_Buffer.constData()), m_Buffer.size());
+}
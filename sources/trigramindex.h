@@ -0,0 +1,55 @@
+#ifndef TRIGRAMINDEX_H
+#define TRIGRAMINDEX_H
+
+#include <functional>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+struct TrigramIndexEntry
+{
+    qint64 modified;
+    QString path;
+    qint64 size;
+};
+
+class TrigramIndex
+{
+public:
+    explicit TrigramIndex(const QString &folder);
+    QStringList candidates(const QByteArray &needle) const;
+    static QStringList dirtyFiles(const QString &folder);
+    static const uchar *foldTable();
+    bool load();
+    static void markDirty(const QString &folder, const QStringList &paths);
+    bool save();
+    static QStringList takeDirtyFiles(const QString &folder);
+    bool update(const QList<TrigramIndexEntry> &files, const QStringList &dirty, const std::function<bool()> &cancelled);
+private:
+    QByteArray m_Buffer;
+    const uchar *m_Data;
+    static QHash<QString, QSet<QString>> m_Dirty;
+    static QMutex m_DirtyMutex;
+    QFile m_File;
+    quint32 m_FileCount;
+    QString m_Folder;
+    quint32 m_PathsSize;
+    quint32 m_PostingsSize;
+    quint32 m_TrigramCount;
+    static QVector<quint32> extract(const uchar *data, const qint64 size);
+    qint64 fileModified(const quint32 id) const;
+    QString filePath(const quint32 id) const;
+    qint64 fileSize(const quint32 id) const;
+    bool findTrigram(const quint32 key, quint32 &offset, quint32 &count) const;
+    QString indexFile() const;
+    bool parse(const uchar *data, const qint64 size);
+    QVector<quint32> postings(const quint32 offset, const quint32 count) const;
+    static QVector<quint32> trigrams(const QString &path);
+};
+
+#endif // TRIGRAMINDEX_H
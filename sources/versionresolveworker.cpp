@@ -1,5 +1,9 @@
+#include <QDateTime>
 #include <QDebug>
+#include <QFileInfo>
 #include <QRegularExpression>
+#include <QSettings>
+#include <QThreadPool>
 #include "versionresolveworker.h"
 #include "processutils.h"
 
@@ -12,152 +16,165 @@ VersionResolveWorker::VersionResolveWorker(QObject *parent)
 {
 }
 
-void VersionResolveWorker::resolve()
+QString VersionResolveWorker::cachedVersion(const QString &binary, const QString &path)
 {
-    emit started();
-#ifdef QT_DEBUG
-    qDebug() << "使用来自" << ProcessUtils::javaExe() << "的 'java'";
-#endif
-    bool found = false;
-    const QString java = ProcessUtils::javaExe();
-    if (!java.isEmpty()) {
-        ProcessResult result = ProcessUtils::runCommand(java, QStringList() << "-version");
-#ifdef QT_DEBUG
-        qDebug() << "Java 返回代码" << result.code;
-#endif
-        if ((result.code == 0) && !result.output.isEmpty()) {
-#ifdef QT_DEBUG
-            qDebug() << "Java 返回" << result.output[0];
-#endif
-            QRegularExpression regexp(REGEXP_JAVA_VERSION);
-            QRegularExpressionMatch match = regexp.match(result.output[0]);
-            if (match.hasMatch()) {
-                emit versionResolved("java", match.captured(1));
-                found = true;
-            }
-        }
+    QSettings settings;
+    settings.beginGroup("version_cache/" + binary);
+    const QFileInfo info(path);
+    if ((settings.value("path").toString() != path)
+            || (settings.value("modified").toLongLong() != info.lastModified().toMSecsSinceEpoch())
+            || (settings.value("size").toLongLong() != info.size())) {
+        return QString();
     }
-    if (!found) {
-        emit versionResolved("java", QString());
+    return settings.value("version").toString();
+}
+
+void VersionResolveWorker::probe(const QString &binary, const QString &path, const std::function<QString()> &resolver)
+{
+    if (path.isEmpty()) {
+        emit versionResolved(binary, QString());
+        return;
     }
-#ifdef QT_DEBUG
-    qDebug() << "使用来自" << ProcessUtils::apktoolJar() << "的 'apktool'";
-#endif
-    found = false;
-    const QString apktool = ProcessUtils::apktoolJar();
-    if (!java.isEmpty() && !apktool.isEmpty()) {
-        QStringList args;
-        args << "-jar" << apktool;
-        args << "--version";
-        ProcessResult result = ProcessUtils::runCommand(java, args);
-#ifdef QT_DEBUG
-        qDebug() << "Apktool 返回代码" << result.code;
-#endif
-        if ((result.code == 0) && !result.output.isEmpty()) {
-#ifdef QT_DEBUG
-            qDebug() << "Apktool 返回" << result.output.first();
-#endif
-            emit versionResolved("apktool", result.output.first().trimmed());
-            found = true;
+    QString version = cachedVersion(binary, path);
+    if (version.isEmpty()) {
+        version = resolver();
+        if (!version.isEmpty()) {
+            storeVersion(binary, path, version);
         }
     }
-    if (!found) {
-        emit versionResolved("apktool", QString());
-    }
 #ifdef QT_DEBUG
-    qDebug() << "使用来自" << ProcessUtils::jadxExe() << "的 'jadx'";
+    else {
+        qDebug() << "使用缓存的" << binary << "版本" << version;
+    }
 #endif
-    found = false;
+    emit versionResolved(binary, version);
+}
+
+void VersionResolveWorker::resolve()
+{
+    emit started();
+    const QString java = ProcessUtils::javaExe();
+    const QString apktool = ProcessUtils::apktoolJar();
     const QString jadx = ProcessUtils::jadxExe();
-    if (!jadx.isEmpty()) {
+    const QString adb = ProcessUtils::adbExe();
+    const QString uas = ProcessUtils::uberApkSignerJar();
 #ifdef QT_DEBUG
-        qDebug() << "尝试从以下位置获取 JADX 版本：" << jadx;
+    qDebug() << "使用来自" << java << "的 'java'";
+    qDebug() << "使用来自" << apktool << "的 'apktool'";
+    qDebug() << "使用来自" << jadx << "的 'jadx'";
+    qDebug() << "使用来自" << adb << "的 'adb'";
+    qDebug() << "使用来自" << uas << "的 'uas'";
 #endif
-        ProcessResult result = ProcessUtils::runCommand(jadx, QStringList() << "--version");
+    // 各个版本检查互不依赖，并行执行以缩短启动时间
+    QThreadPool pool;
+    pool.setMaxThreadCount(5);
+    pool.start([=] {
+        probe("java", java, [=] {
+            ProcessResult result = ProcessUtils::runCommand(java, QStringList() << "-version");
 #ifdef QT_DEBUG
-        qDebug() << "Jadx 返回代码" << result.code;
-        qDebug() << "Jadx 输出行数：" << result.output.size();
-        for (int i = 0; i < result.output.size(); ++i) {
-            qDebug() << "  输出[" << i << "]：" << result.output[i];
-        }
-        qDebug() << "Jadx 错误行数：" << result.error.size();
-        for (int i = 0; i < result.error.size(); ++i) {
-            qDebug() << "  错误[" << i << "]：" << result.error[i];
-        }
+            qDebug() << "Java 返回代码" << result.code;
 #endif
-        if ((result.code == 0) && !result.output.isEmpty()) {
+            if ((result.code == 0) && !result.output.isEmpty()) {
 #ifdef QT_DEBUG
-            qDebug() << "Jadx 返回" << result.output.first();
+                qDebug() << "Java 返回" << result.output[0];
 #endif
-            emit versionResolved("jadx", result.output.first().trimmed());
-            found = true;
-        } else {
+                QRegularExpression regexp(REGEXP_JAVA_VERSION);
+                QRegularExpressionMatch match = regexp.match(result.output[0]);
+                if (match.hasMatch()) {
+                    return match.captured(1);
+                }
+            }
+            return QString();
+        });
+    });
+    pool.start([=] {
+        probe("apktool", java.isEmpty() ? QString() : apktool, [=] {
+            ProcessResult result = ProcessUtils::runJar(apktool, QStringList() << "--version");
 #ifdef QT_DEBUG
-            qDebug() << "Jadx 版本检查失败 - 代码：" << result.code << "输出为空：" << result.output.isEmpty();
+            qDebug() << "Apktool 返回代码" << result.code;
 #endif
-        }
-    } else {
+            if ((result.code == 0) && !result.output.isEmpty()) {
 #ifdef QT_DEBUG
-        qDebug() << "JADX 可执行文件路径为空";
+                qDebug() << "Apktool 返回" << result.output.first();
 #endif
-    }
-    if (!found) {
-        emit versionResolved("jadx", QString());
-    }
+                return result.output.first().trimmed();
+            }
+            return QString();
+        });
+    });
+    pool.start([=] {
+        probe("jadx", jadx, [=] {
+            ProcessResult result = ProcessUtils::runCommand(jadx, QStringList() << "--version");
+#ifdef QT_DEBUG
+            qDebug() << "Jadx 返回代码" << result.code;
+            qDebug() << "Jadx 输出行数：" << result.output.size();
+            for (int i = 0; i < result.output.size(); ++i) {
+                qDebug() << "  输出[" << i << "]：" << result.output[i];
+            }
+#endif
+            if ((result.code == 0) && !result.output.isEmpty()) {
 #ifdef QT_DEBUG
-    qDebug() << "使用来自" << ProcessUtils::adbExe() << "的 'adb'";
+                qDebug() << "Jadx 返回" << result.output.first();
 #endif
-    found = false;
-    const QString adb = ProcessUtils::adbExe();
-    if (!adb.isEmpty()) {
-        ProcessResult result = ProcessUtils::runCommand(adb, QStringList() << "--version");
+                return result.output.first().trimmed();
+            }
 #ifdef QT_DEBUG
-        qDebug() << "ADB 返回代码" << result.code;
+            qDebug() << "Jadx 版本检查失败 - 代码：" << result.code << "输出为空：" << result.output.isEmpty();
 #endif
-        if ((result.code == 0) && !result.output.isEmpty()) {
+            return QString();
+        });
+    });
+    pool.start([=] {
+        probe("adb", adb, [=] {
+            ProcessResult result = ProcessUtils::runCommand(adb, QStringList() << "--version");
 #ifdef QT_DEBUG
-            qDebug() << "ADB 返回" << result.output.first();
+            qDebug() << "ADB 返回代码" << result.code;
 #endif
-            QRegularExpression regexp(REGEXP_ADB_VERSION);
-            QRegularExpressionMatch match = regexp.match(result.output.first());
-            if (match.hasMatch()) {
-                emit versionResolved("adb", match.captured(1));
-                found = true;
-            }
-        }
-    }
-    if (!found) {
-        emit versionResolved("adb", QString());
-    }
+            if ((result.code == 0) && !result.output.isEmpty()) {
 #ifdef QT_DEBUG
-    qDebug() << "使用来自" << ProcessUtils::uberApkSignerJar() << "的 'uas'";
+                qDebug() << "ADB 返回" << result.output.first();
 #endif
-    found = false;
-    const QString uas = ProcessUtils::uberApkSignerJar();
-    if (!java.isEmpty() && !uas.isEmpty()) {
-        QStringList args;
-        args << "-jar" << uas;
-        args << "--version";
-        ProcessResult result = ProcessUtils::runCommand(java, args);
+                QRegularExpression regexp(REGEXP_ADB_VERSION);
+                QRegularExpressionMatch match = regexp.match(result.output.first());
+                if (match.hasMatch()) {
+                    return match.captured(1);
+                }
+            }
+            return QString();
+        });
+    });
+    pool.start([=] {
+        probe("uas", java.isEmpty() ? QString() : uas, [=] {
+            ProcessResult result = ProcessUtils::runJar(uas, QStringList() << "--version");
 #ifdef QT_DEBUG
-        qDebug() << "Uber APK signer 返回代码" << result.code;
+            qDebug() << "Uber APK signer 返回代码" << result.code;
 #endif
-        if ((result.code == 0) && !result.output.isEmpty()) {
+            if ((result.code == 0) && !result.output.isEmpty()) {
 #ifdef QT_DEBUG
-            qDebug() << "Uber APK signer 返回" << result.output.first();
+                qDebug() << "Uber APK signer 返回" << result.output.first();
 #endif
-            QRegularExpression regexp(REGEXP_UAS_VERSION);
-            QRegularExpressionMatch match = regexp.match(result.output.first());
-            if (match.hasMatch()) {
-                emit versionResolved("uas", match.captured(1));
-                found = true;
+                QRegularExpression regexp(REGEXP_UAS_VERSION);
+                QRegularExpressionMatch match = regexp.match(result.output.first());
+                if (match.hasMatch()) {
+                    return match.captured(1);
+                }
             }
-        }
-        if (!found) {
-            emit versionResolved("uas", QString());
-        }
-    } else {
-        emit versionResolved("uas", QString());
-    }
+            return QString();
+        });
+    });
+    pool.waitForDone();
     emit finished();
 }
+
+void VersionResolveWorker::storeVersion(const QString &binary, const QString &path, const QString &version)
+{
+    QSettings settings;
+    settings.beginGroup("version_cache/" + binary);
+    const QFileInfo info(path);
+    settings.setValue("path", path);
+    settings.setValue("modified", info.lastModified().toMSecsSinceEpoch());
+    settings.setValue("size", info.size());
+    settings.setValue("version", version);
+    settings.endGroup();
+    settings.sync();
+}
@@ -1,6 +1,7 @@
 #ifndef VERSIONRESOLVEWORKER_H
 #define VERSIONRESOLVEWORKER_H
 
+#include <functional>
 #include <QObject>
 
 class VersionResolveWorker : public QObject
@@ -8,7 +9,11 @@ class VersionResolveWorker : public QObject
     Q_OBJECT
 public:
     explicit VersionResolveWorker(QObject *parent = nullptr);
+    static QString cachedVersion(const QString &binary, const QString &path);
     void resolve();
+private:
+    void probe(const QString &binary, const QString &path, const std::function<QString()> &resolver);
+    static void storeVersion(const QString &binary, const QString &path, const QString &version);
 signals:
     void finished();
     void started();